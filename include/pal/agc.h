@@ -0,0 +1,111 @@
+/**
+ * @file agc.h
+ * @brief Block-floating automatic gain control for the 8 kHz RX path
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace pal {
+
+class Resampler;
+class IEventHandler;
+
+/**
+ * @brief AGC configuration
+ */
+struct AgcConfig {
+    float sample_rate = 8000.0f;    ///< Sample rate of the processed stream (Hz)
+    float attack_ms = 5.0f;         ///< Time constant when the level rises
+    float decay_ms = 500.0f;        ///< Time constant when the level falls
+    float target_level = 0.5f;      ///< Desired output peak (full scale = 1.0)
+    float max_gain_db = 60.0f;      ///< Upper gain limit
+    float min_gain_db = -20.0f;     ///< Lower gain limit
+    size_t sub_block = 32;          ///< Samples per gain update
+};
+
+/**
+ * @brief Block-floating AGC
+ *
+ * The level detector runs once per sub-block (peak of |x|), so the
+ * per-sample work is a max() for detection and a multiply-add for the
+ * gain ramp. Both loops are branch- and divide-free and auto-vectorize.
+ * The gain is linearly interpolated across each sub-block to avoid
+ * zipper noise on the modem input.
+ */
+class Agc {
+public:
+    explicit Agc(const AgcConfig& config = AgcConfig());
+
+    /**
+     * @brief Apply AGC in place
+     *
+     * @param samples Samples to normalize
+     * @param count Number of samples
+     */
+    void process(float* samples, size_t count);
+
+    /**
+     * @brief Decimate and apply AGC in one pass (48kHz -> 8kHz)
+     *
+     * Runs the resampler one sub-block at a time so each decimated
+     * sub-block is normalized while still in cache.
+     *
+     * @param resampler Resampler performing the decimation
+     * @param input Input samples at high rate
+     * @param input_count Number of input samples
+     * @param output Output buffer (must hold input_count/ratio samples)
+     * @return Number of output samples produced
+     */
+    size_t decimate(Resampler& resampler, const float* input, size_t input_count, float* output);
+
+    /**
+     * @brief Reset detector and gain to unity
+     */
+    void reset();
+
+    /**
+     * @brief Current gain in dB (safe to call from any thread)
+     */
+    float get_gain_db() const;
+
+    /**
+     * @brief Detected input level in dBFS (safe to call from any thread)
+     */
+    float get_level_dbfs() const;
+
+    /**
+     * @brief Emit an AUDIO_LEVEL event with the current gain and level
+     *
+     * Call from a non-real-time thread; code carries the gain in 0.1 dB.
+     */
+    void emit_events(IEventHandler& events) const;
+
+    const AgcConfig& get_config() const { return config_; }
+
+private:
+    void process_sub_block(float* samples, size_t count);
+
+    AgcConfig config_;
+    float attack_coeff_;
+    float decay_coeff_;
+    float max_gain_;
+    float min_gain_;
+    float inv_sub_block_;
+
+    float envelope_;
+    float gain_;
+
+    // Telemetry, written by the processing thread only
+    std::atomic<float> telemetry_gain_;
+    std::atomic<float> telemetry_level_;
+};
+
+} // namespace pal
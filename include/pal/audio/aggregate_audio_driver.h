@@ -0,0 +1,170 @@
+/**
+ * @file aggregate_audio_driver.h
+ * @brief Several audio devices presented as one multi-channel IAudioDriver
+ *
+ * Multi-radio stations run one USB codec per radio, each on its own
+ * crystal. The aggregate keeps one device as the clock master and slaves
+ * the others to it: a slave's own callback only moves samples through a
+ * pair of SPSC rings, and all processing happens in the master's
+ * callback, where each slave is pulled onto the master clock by a
+ * FractionalResampler steered from its ring fill level.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/audio_ring.h"
+#include "pal/fractional_resampler.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pal {
+
+class IEventHandler;
+
+/**
+ * @brief Aggregate driver configuration
+ */
+struct AggregateAudioConfig {
+    uint32_t target_fill_frames = 0;    ///< Slave ring fill held by the controller (0 = 2 periods)
+    uint32_t ring_frames = 0;           ///< Ring size per slave and direction (0 = 8 periods)
+    double max_drift_ppm = 1000.0;      ///< Largest clock error corrected
+};
+
+/**
+ * @brief Clock tracking state of one device
+ */
+struct AggregateDeviceStats {
+    double drift_ppm = 0.0;             ///< Slave clock relative to the master (+ = slave fast)
+    double rx_fill_frames = 0.0;        ///< Smoothed RX ring fill
+    double tx_fill_frames = 0.0;        ///< Smoothed TX ring fill
+    uint64_t rx_overruns = 0;           ///< Slave RX dropped, ring full
+    uint64_t rx_underruns = 0;          ///< Master found too little slave RX
+    uint64_t tx_overruns = 0;           ///< Master TX dropped, ring full
+    uint64_t tx_underruns = 0;          ///< Slave found too little TX
+};
+
+/**
+ * @brief Master/slave aggregate of IAudioDrivers
+ *
+ * Channel 0 is the master device, channel k the k-th add_device(). The
+ * native format is interleaved F32 with one channel per device; a native
+ * callback sees every device in one aligned block, and a float callback
+ * sees the channel selected with set_native_format() (radio_channel).
+ * All devices run at the same nominal rate and period.
+ *
+ * AudioBlockInfo is the master's: slave channels are on the master
+ * timeline, delayed by the ring target fill plus the slave's own latency.
+ * A slave's drift estimate settles within a few seconds; until a slave
+ * ring first reaches its target that channel reads silence.
+ *
+ * Slave threads only copy a period into and out of their rings. The
+ * drivers' own threads and priorities are unchanged.
+ */
+class AggregateAudioDriver : public IAudioDriver {
+public:
+    explicit AggregateAudioDriver(std::unique_ptr<IAudioDriver> master,
+                                  const AggregateAudioConfig& config = AggregateAudioConfig());
+
+    ~AggregateAudioDriver() override;
+
+    /**
+     * @brief Add a slave device; call before initialize()
+     * @param device_name Passed to the slave's initialize()
+     * @return Channel index of the device
+     */
+    size_t add_device(std::unique_ptr<IAudioDriver> device, const std::string& device_name);
+
+    // IAudioDriver interface
+
+    /**
+     * @brief Initialize the master on device_name, then every slave
+     */
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+    bool set_native_audio_callback(NativeAudioCallback callback) override;
+
+    /**
+     * @brief Accepts F32 with one channel per device; radio_channel picks the float channel
+     */
+    bool set_native_format(const AudioFormat& format) override;
+    AudioFormat get_native_format() const override;
+    void set_timer(const ITimer* timer) override;
+
+    /**
+     * @brief Applied to every device's thread; the status is the master's
+     */
+    void set_rt_policy(const RtThreadPolicy& policy) override;
+    RtThreadStatus get_rt_status() const override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+
+    /**
+     * @brief Master latency plus the slave ring target
+     */
+    float get_latency_ms() const override;
+
+    // Aggregate specific
+
+    size_t get_device_count() const { return slaves_.size() + 1; }
+    IAudioDriver& get_device(size_t channel);
+
+    /**
+     * @brief Clock tracking of a device (any thread; channel 0 is all zero)
+     */
+    AggregateDeviceStats get_device_stats(size_t channel) const;
+
+    /**
+     * @brief Emit AUDIO_OVERRUN / AUDIO_UNDERRUN for every slave ring (non-RT thread)
+     */
+    void emit_events(IEventHandler& events);
+
+    /**
+     * @brief Move one master period through every device (master audio thread)
+     *
+     * Normally called from the master's callback; exposed so tests and
+     * custom masters can drive the aggregate directly.
+     */
+    void process(const AudioBlockInfo& info, const float* rx, float* tx, size_t num_frames);
+
+private:
+    struct Slave;
+
+    static void slave_callback(void* context, const float* rx, float* tx, size_t n);
+    void pull_rx(Slave& slave, float* out, size_t n);
+    void push_tx(Slave& slave, const float* in, size_t n);
+
+    std::unique_ptr<IAudioDriver> master_;
+    std::vector<std::unique_ptr<Slave>> slaves_;
+    AggregateAudioConfig config_;
+    AudioCallbackSlot callback_;
+    uint16_t radio_channel_ = 0;
+
+    uint32_t target_fill_ = 0;
+    size_t block_frames_ = 0;           // Plane size; master periods are split to fit
+    std::vector<std::vector<float>> rx_planes_;
+    std::vector<std::vector<float>> tx_planes_;
+    std::vector<float> rx_frames_;      // Interleaved, for native callbacks
+    std::vector<float> tx_frames_;
+};
+
+} // namespace pal
@@ -0,0 +1,148 @@
+/**
+ * @file alsa_audio_driver.h
+ * @brief Linux ALSA IAudioDriver using mmap (in-place) period transfer
+ *
+ * Built only with -DPAL_WITH_ALSA=ON. Capture and playback ring buffers
+ * are handed to the audio callback directly via snd_pcm_mmap_begin/commit,
+ * so there is no intermediate copy between the device and the modem.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Forward declarations so users don't need ALSA headers
+struct _snd_pcm;
+struct _snd_pcm_hw_params;
+
+namespace pal {
+
+/**
+ * @brief ALSA driver configuration
+ */
+struct AlsaAudioConfig {
+    std::string playback_device;    ///< Playback PCM; empty = same as capture
+    uint32_t periods = 2;           ///< Periods in the hardware ring buffer
+    int rt_priority = 70;           ///< Initial SCHED_FIFO policy; 0 = none (see set_rt_policy)
+};
+
+/**
+ * @brief ALSA full-duplex driver
+ *
+ * Opens capture and playback with MMAP_INTERLEAVED access in the layout
+ * asked for with set_native_format() (mono FLOAT by default), falling
+ * back to FLOAT, S32 or S16 and mono or stereo as the hardware allows,
+ * and links them so they start together. Float callbacks get the radio
+ * channel converted in place of the device layout; a native callback is
+ * handed the mmap areas untouched. The driver thread sleeps in
+ * poll() on the capture descriptors and runs one callback per period
+ * (split only if a period straddles the end of the ring). Xruns are
+ * recovered with snd_pcm_prepare, the device stays open.
+ *
+ * AudioBlockInfo: the TX index runs one hardware ring ahead of RX (the
+ * silence primed at start). TX frames that find the playback ring full
+ * are dropped but still advance the TX index. Timestamps come from
+ * snd_pcm_avail_delay at wakeup; after an xrun the RX index skips the
+ * frames lost (timed from the last wakeup) and TX is re-anchored to
+ * RX + ring.
+ *
+ * "plughw:..." still works for layouts the hardware lacks, at the cost
+ * of conversion inside alsa-lib; "null" exercises the driver without a
+ * sound card.
+ */
+class AlsaAudioDriver : public IAudioDriver {
+public:
+    explicit AlsaAudioDriver(const AlsaAudioConfig& config = AlsaAudioConfig());
+
+    ~AlsaAudioDriver() override;
+
+    // IAudioDriver interface
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+    bool set_native_audio_callback(NativeAudioCallback callback) override;
+    bool set_native_format(const AudioFormat& format) override;
+    AudioFormat get_native_format() const override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+
+    /**
+     * @brief Round-trip latency from the current capture + playback delay
+     *
+     * Updated every period from snd_pcm_avail_delay(); before start() it
+     * is the configured buffering.
+     */
+    float get_latency_ms() const override;
+
+    // ALSA specific
+
+    /**
+     * @brief Number of xruns recovered since initialize()
+     */
+    uint64_t get_xrun_count() const { return xruns_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief True if the driver thread got the requested scheduling class and priority
+     */
+    bool has_rt_priority() const {
+        RtThreadStatus status = get_rt_status();
+        return status.applied && status.sched_granted && rt_policy_.sched != RtSchedClass::DEFAULT;
+    }
+
+private:
+    bool choose_format(_snd_pcm* handle, _snd_pcm_hw_params* hw);
+    bool open_pcm(_snd_pcm** pcm, const std::string& name, bool capture);
+    bool prime();
+    bool recover(int err);
+    bool process_period();
+    void run();
+
+    AlsaAudioConfig config_;
+
+    _snd_pcm* capture_ = nullptr;
+    _snd_pcm* playback_ = nullptr;
+    bool linked_ = false;               // Streams start/stop together
+
+    uint32_t sample_rate_ = 0;
+    uint32_t buffer_frames_ = 0;        // Period size
+    uint32_t ring_frames_ = 0;          // Hardware buffer size
+    AudioFormat requested_;             // From set_native_format()
+    AudioFormat format_;                // Layout the device was opened with
+
+    AudioCallbackSlot callback_;
+    std::vector<uint8_t> scratch_;      // TX sink when playback has no room
+    std::vector<float> rx_float_;       // Radio channel staging when the device
+    std::vector<float> tx_float_;       // isn't mono float
+    uint64_t rx_index_ = 0;             // Frames captured since start(), lost ones included
+    uint64_t tx_index_ = 0;             // Frames handed to playback since start(), dropped ones included
+    int64_t anchor_ns_ = 0;             // Last wakeup (steady clock; 0 = none yet)
+    uint64_t anchor_index_ = 0;         // Capture timeline position at anchor_ns_
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint64_t> xruns_{0};
+    std::atomic<uint32_t> delay_frames_{0};
+};
+
+} // namespace pal
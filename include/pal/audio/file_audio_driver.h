@@ -0,0 +1,157 @@
+/**
+ * @file file_audio_driver.h
+ * @brief Offline IAudioDriver reading RX from a WAV/raw file and writing TX to a file
+ *
+ * Drives the audio callback as fast as the CPU allows (or at a fixed
+ * multiple of real time) so recorded HF captures can be reprocessed for
+ * regression testing and throughput measurement without a sound card.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/sample_format.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pal {
+
+/**
+ * @brief File driver configuration
+ */
+struct FileAudioConfig {
+    std::string tx_path;                        ///< TX output (.wav = WAV, else raw); empty = discard
+    SampleFormat tx_format = SampleFormat::S16; ///< TX output sample format
+    float speed = 0.0f;                         ///< Real-time multiple; 0 = as fast as possible
+
+    // Raw PCM input layout (WAV input uses its header instead)
+    SampleFormat raw_format = SampleFormat::S16;
+    uint16_t raw_channels = 1;
+
+    uint16_t rx_channel = 0;                    ///< Input channel fed to the callback
+};
+
+/**
+ * @brief Offline file-backed audio driver
+ *
+ * initialize() takes the RX input path as device_name. The input is
+ * memory-mapped, so reading it costs nothing beyond page faults. The
+ * last partial period is zero-padded; the driver stops by itself at the
+ * end of the input.
+ *
+ * A native callback is handed the mapped input frames directly (copied
+ * per period if the WAV data chunk isn't sample aligned). Its TX
+ * frames are written to tx_path unconverted (multi-channel WAV if the
+ * input is), so the TX file layout follows the callback kind of the
+ * first run; start() refuses to switch kinds once TX has been written.
+ */
+class FileAudioDriver : public IAudioDriver {
+public:
+    explicit FileAudioDriver(const FileAudioConfig& config = FileAudioConfig());
+
+    ~FileAudioDriver() override;
+
+    // IAudioDriver interface
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+    bool set_native_audio_callback(NativeAudioCallback callback) override;
+
+    /**
+     * @brief Select the radio channel; the file dictates format and channels
+     */
+    bool set_native_format(const AudioFormat& format) override;
+
+    /**
+     * @brief Input file layout (WAV header or raw_format/raw_channels)
+     */
+    AudioFormat get_native_format() const override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+    float get_latency_ms() const override;
+
+    // File driver specific
+
+    /**
+     * @brief Block until the input is exhausted or stop() is called
+     */
+    void wait();
+
+    /**
+     * @brief Total input frames in the file
+     */
+    uint64_t get_total_frames() const { return total_frames_; }
+
+    /**
+     * @brief Frames delivered to the callback so far
+     */
+    uint64_t get_frames_processed() const { return frames_processed_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Audio time processed divided by wall time of the last run
+     */
+    double get_realtime_factor() const;
+
+private:
+    class MappedFile;
+
+    bool parse_wav();
+    bool open_tx();
+    void close_tx();
+    void run();
+
+    FileAudioConfig config_;
+
+    uint32_t sample_rate_ = 0;
+    uint32_t buffer_frames_ = 0;
+
+    // Input layout
+    std::unique_ptr<MappedFile> input_;
+    const uint8_t* data_ = nullptr;
+    bool data_aligned_ = true;                  // Samples can be read in place
+    SampleFormat format_ = SampleFormat::S16;
+    uint16_t channels_ = 1;
+    size_t frame_bytes_ = 0;
+    uint64_t total_frames_ = 0;
+
+    // Output
+    std::FILE* tx_file_ = nullptr;
+    bool tx_wav_ = false;
+    uint64_t tx_bytes_ = 0;
+    AudioFormat tx_layout_;                     // Frame layout written to tx_file_
+
+    AudioCallbackSlot callback_;
+    std::vector<float> rx_buffer_;
+    std::vector<float> tx_buffer_;
+    std::vector<uint8_t> tx_pcm_;               // TX file staging, or native TX frames
+    std::vector<uint8_t> rx_pad_;               // Zero-padded last native period, or misaligned input
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint64_t> frames_processed_{0};
+    std::atomic<double> elapsed_s_{0.0};
+    bool initialized_ = false;
+};
+
+} // namespace pal
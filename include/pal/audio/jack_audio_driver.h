@@ -0,0 +1,114 @@
+/**
+ * @file jack_audio_driver.h
+ * @brief JACK (and PipeWire-JACK) client IAudioDriver
+ *
+ * Built only with -DPAL_WITH_JACK=ON. The audio callback runs inside the
+ * server's process cycle on the port buffers themselves, so there is no
+ * extra buffering beyond the server's own period.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Forward declarations so users don't need JACK headers
+struct _jack_client;
+struct _jack_port;
+
+namespace pal {
+
+/**
+ * @brief JACK driver configuration
+ */
+struct JackAudioConfig {
+    std::string connect_rx;     ///< Source port for RX (e.g. "system:capture_1"); empty = first physical
+    std::string connect_tx;     ///< Sink port for TX (e.g. "system:playback_1"); empty = first physical
+    bool auto_connect = true;   ///< Connect ports on start()
+};
+
+/**
+ * @brief JACK client audio driver
+ *
+ * initialize() takes the JACK client name as device_name. The server owns
+ * the sample rate and period: initialize() fails if sample_rate differs
+ * from the server's, and get_buffer_frames() reports the server period
+ * (buffer_frames is only a hint). Works with jackd/jackdbus, PipeWire's
+ * JACK layer, and the headless "dummy" backend (jackd -d dummy).
+ *
+ * AudioBlockInfo timestamps come from the server's cycle start time
+ * (jack_last_frame_time) shifted by the port latencies, mapped onto the
+ * ITimer clock each cycle.
+ *
+ * set_rt_policy() is applied when libjack creates the client thread
+ * during start(); leave sched at DEFAULT to keep the
+ * priority the server assigns and only pin or lock memory.
+ */
+class JackAudioDriver : public IAudioDriver {
+public:
+    explicit JackAudioDriver(const JackAudioConfig& config = JackAudioConfig());
+
+    ~JackAudioDriver() override;
+
+    // IAudioDriver interface
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+
+    /**
+     * @brief Capture + playback port latency plus one server period
+     */
+    float get_latency_ms() const override;
+
+    // JACK specific
+
+    /**
+     * @brief Xruns reported by the server since initialize()
+     */
+    uint64_t get_xrun_count() const { return xruns_.load(std::memory_order_relaxed); }
+
+private:
+    static int process_callback(uint32_t nframes, void* arg);
+    static int buffer_size_callback(uint32_t nframes, void* arg);
+    static int xrun_callback(void* arg);
+    static void thread_init_callback(void* arg);
+    static void shutdown_callback(void* arg);
+
+    bool connect_ports();
+
+    JackAudioConfig config_;
+
+    _jack_client* client_ = nullptr;
+    _jack_port* rx_port_ = nullptr;
+    _jack_port* tx_port_ = nullptr;
+
+    uint32_t sample_rate_ = 0;
+    std::atomic<uint32_t> buffer_frames_{0};
+
+    AudioCallbackSlot callback_;
+    uint64_t rx_index_ = 0;     // Frames captured since start()
+
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> xruns_{0};
+};
+
+} // namespace pal
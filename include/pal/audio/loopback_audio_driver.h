@@ -0,0 +1,153 @@
+/**
+ * @file loopback_audio_driver.h
+ * @brief TX->RX loopback IAudioDriver for DSP throughput profiling
+ *
+ * Feeds each period's TX output back as the next period's RX input,
+ * optionally through a simulated channel (frequency offset + AWGN), and
+ * calls the audio callback in a tight loop. Used as the standard harness
+ * for "how many channels fit on this box".
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/hilbert.h"
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pal {
+
+/**
+ * @brief Loopback channel configuration
+ */
+struct LoopbackConfig {
+    float freq_offset_hz = 0.0f;    ///< Frequency shift applied to the looped signal
+    float noise_rms = 0.0f;         ///< AWGN standard deviation (0 = no noise)
+    uint32_t noise_seed = 1;        ///< Seed for reproducible noise
+    uint64_t max_callbacks = 0;     ///< Stop after this many callbacks (0 = until stop())
+};
+
+/**
+ * @brief Throughput statistics
+ */
+struct LoopbackStats {
+    uint64_t callbacks = 0;
+    uint64_t samples = 0;
+    double elapsed_s = 0.0;         ///< Wall time from the first block to the last (or now, while running)
+    double samples_per_sec = 0.0;
+    double callbacks_per_sec = 0.0;
+    double avg_callback_us = 0.0;   ///< CPU time spent inside the callback
+    double max_callback_us = 0.0;
+    double load = 0.0;              ///< Callback time / real-time period length
+};
+
+/**
+ * @brief Loopback audio driver
+ *
+ * device_name is ignored. RX of period N is the (channel-processed) TX of
+ * period N-1, so round-trip latency is one period (plus the Hilbert delay
+ * when a frequency offset is set). The offset is applied to the analytic
+ * signal from pal::Hilbert, so it is a true single-sideband shift rather
+ * than a mixer with an image. AudioBlockInfo reports tx_sample_index one
+ * period ahead of rx_sample_index, so TX frame k comes back at RX frame k
+ * (plus the Hilbert delay). Callback time is the calling thread's CPU
+ * time (CLOCK_THREAD_CPUTIME_ID) around each call, so preemption by other
+ * threads doesn't count against the callback.
+ */
+class LoopbackAudioDriver : public IAudioDriver {
+public:
+    explicit LoopbackAudioDriver(const LoopbackConfig& config = LoopbackConfig());
+
+    ~LoopbackAudioDriver() override;
+
+    // IAudioDriver interface
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+    float get_latency_ms() const override;
+
+    // Loopback specific
+
+    /**
+     * @brief Run callbacks on the calling thread (no driver thread)
+     * @param callbacks Number of periods to run
+     */
+    void run(uint64_t callbacks);
+
+    /**
+     * @brief Block until max_callbacks is reached or stop() is called
+     */
+    void wait();
+
+    /**
+     * @brief Snapshot of throughput statistics (any thread)
+     */
+    LoopbackStats get_stats() const;
+
+    /**
+     * @brief Clear statistics; the measurement clock restarts at the next block
+     */
+    void reset_stats();
+
+private:
+    void run_period();
+    void apply_channel();
+    void thread_main();
+
+    LoopbackConfig config_;
+
+    uint32_t sample_rate_ = 0;
+    uint32_t buffer_frames_ = 0;
+
+    AudioCallbackSlot callback_;
+    std::vector<float> rx_buffer_;
+    std::vector<float> tx_buffer_;
+    uint64_t sample_index_ = 0;     // RX timeline position of the next period
+    uint64_t origin_us_ = 0;        // Media time of sample 0
+
+    // Channel simulation
+    Hilbert hilbert_;
+    std::vector<float> i_buffer_;
+    std::vector<float> q_buffer_;
+    float osc_re_ = 1.0f;
+    float osc_im_ = 0.0f;
+    float rot_re_ = 1.0f;
+    float rot_im_ = 0.0f;
+    std::mt19937 rng_;
+    std::normal_distribution<float> noise_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    bool initialized_ = false;
+
+    // Statistics (written by the running thread)
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> callback_ns_{0};
+    std::atomic<uint64_t> callback_ns_max_{0};
+    std::atomic<int64_t> start_ns_{0};       // First block since reset (0 = none yet)
+    std::atomic<int64_t> end_ns_{0};         // Latched when the thread or run() ends (0 = running)
+};
+
+} // namespace pal
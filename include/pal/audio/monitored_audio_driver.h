@@ -0,0 +1,152 @@
+/**
+ * @file monitored_audio_driver.h
+ * @brief IAudioDriver decorator that measures callback CPU budget and jitter
+ *
+ * Wraps any driver and times every callback against its period length,
+ * plus the spacing between callbacks. Results go into lock-free
+ * histograms that can be read from any thread while audio runs.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/events.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pal {
+
+/**
+ * @brief Monitor configuration
+ */
+struct AudioMonitorConfig {
+    float warn_load = 0.7f;         ///< Warn when a callback uses this fraction of its period
+    std::string source = "audio_monitor";   ///< Event source name
+};
+
+/**
+ * @brief Point-in-time copy of the monitor statistics
+ *
+ * Load bin i counts callbacks that used [i, i+1) tenths of their period;
+ * the last bin collects everything from 1.5 periods up. Jitter bin i
+ * counts callback start deviations in [2^i, 2^(i+1)) us (bin 0 also
+ * holds anything under 1 us).
+ */
+struct AudioMonitorSnapshot {
+    static constexpr size_t LOAD_BINS = 16;
+    static constexpr size_t JITTER_BINS = 16;
+
+    uint64_t callbacks = 0;
+    uint64_t over_budget = 0;       ///< Callbacks above warn_load
+    uint64_t deadline_misses = 0;   ///< Callbacks longer than their period
+    double avg_load = 0.0;          ///< Mean callback time / period
+    double max_load = 0.0;
+    double max_jitter_us = 0.0;
+    std::array<uint64_t, LOAD_BINS> load_histogram{};
+    std::array<uint64_t, JITTER_BINS> jitter_histogram{};
+
+    /**
+     * @brief Load not exceeded by fraction p of callbacks (bin upper edge)
+     *
+     * 1.0 - load_percentile(0.99) is the headroom left on this machine.
+     */
+    double load_percentile(double p) const;
+};
+
+/**
+ * @brief Instrumenting audio driver decorator
+ *
+ * All IAudioDriver calls are forwarded to the wrapped driver. The user
+ * callback runs inside a timed (or, for native callbacks, a native)
+ * trampoline; AudioBlockInfo is passed through unchanged. Measurement adds two steady_clock reads and a few
+ * relaxed atomic stores per callback.
+ */
+class MonitoredAudioDriver : public IAudioDriver {
+public:
+    explicit MonitoredAudioDriver(std::unique_ptr<IAudioDriver> inner,
+                                  const AudioMonitorConfig& config = AudioMonitorConfig());
+
+    ~MonitoredAudioDriver() override;
+
+    // IAudioDriver interface
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+    bool set_native_audio_callback(NativeAudioCallback callback) override;
+    bool set_native_format(const AudioFormat& format) override;
+    AudioFormat get_native_format() const override;
+    void set_timer(const ITimer* timer) override;
+    void set_rt_policy(const RtThreadPolicy& policy) override;
+    RtThreadStatus get_rt_status() const override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+    float get_latency_ms() const override;
+
+    // Monitor specific
+
+    /**
+     * @brief Copy of the statistics since initialize() (any thread)
+     */
+    AudioMonitorSnapshot snapshot() const;
+
+    /**
+     * @brief Emit SYSTEM_WARNING if callbacks went over budget since the last call
+     *
+     * Call from a non-real-time thread; code carries the worst load in
+     * percent of the period since the previous report.
+     */
+    void emit_events(IEventHandler& events);
+
+    IAudioDriver& get_inner() { return *inner_; }
+
+private:
+    void install_float_trampoline();
+    int64_t begin_measure(size_t n);
+    void end_measure(int64_t start, size_t n);
+    void reset_stats();
+
+    std::unique_ptr<IAudioDriver> inner_;
+    AudioMonitorConfig config_;
+    AudioCallbackSlot callback_;
+    bool inner_native_ = false;         // Inner driver runs the native trampoline
+
+    double ns_per_frame_ = 0.0;
+
+    // Written only by the audio thread
+    int64_t last_start_ns_ = 0;
+    size_t last_frames_ = 0;
+
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> over_budget_{0};
+    std::atomic<uint64_t> deadline_misses_{0};
+    std::atomic<uint64_t> load_ppm_sum_{0};     // Sum of per-callback load, parts per million
+    std::atomic<uint32_t> max_load_ppm_{0};
+    std::atomic<uint32_t> window_load_ppm_{0};  // Max load since the last emit_events
+    std::atomic<uint64_t> max_jitter_ns_{0};
+    std::array<std::atomic<uint64_t>, AudioMonitorSnapshot::LOAD_BINS> load_bins_{};
+    std::array<std::atomic<uint64_t>, AudioMonitorSnapshot::JITTER_BINS> jitter_bins_{};
+
+    // emit_events bookkeeping
+    uint64_t reported_over_budget_ = 0;
+    uint64_t reported_misses_ = 0;
+};
+
+} // namespace pal
@@ -0,0 +1,171 @@
+/**
+ * @file shm_audio_driver.h
+ * @brief Shared-memory audio transport between an RT audio process and a modem process
+ *
+ * Linux only (shm_open + futex; CMake defines PAL_WITH_SHM_AUDIO). The RT
+ * process owns the sound device and a ShmAudioServer; the modem process
+ * uses ShmAudioDriver, an ordinary IAudioDriver whose callback sees RX and
+ * TX memory inside the shared segment. Either side of a crash leaves the
+ * other running: the server keeps the device open and the consumer can
+ * re-attach at any time.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/events.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pal {
+
+struct ShmAudioLayout;
+
+/**
+ * @brief Shared-memory transport configuration
+ */
+struct ShmAudioConfig {
+    uint32_t capacity_frames = 16384;   ///< Frames per ring (server; rounded up to a power of two)
+    uint32_t tx_prefill_frames = 0;     ///< Silence queued on attach (consumer; 0 = one period)
+};
+
+/**
+ * @brief RT-process side: publishes device RX and plays consumer TX
+ *
+ * Create the segment, then either call process() from your own audio
+ * callback or attach() it to a driver. process() is wait-free: RX that
+ * doesn't fit is dropped (overrun), missing TX is played as silence
+ * (underrun), and the consumer is woken with a futex only when it sleeps.
+ */
+class ShmAudioServer {
+public:
+    explicit ShmAudioServer(const ShmAudioConfig& config = ShmAudioConfig());
+
+    ~ShmAudioServer();
+
+    ShmAudioServer(const ShmAudioServer&) = delete;
+    ShmAudioServer& operator=(const ShmAudioServer&) = delete;
+
+    /**
+     * @brief Create (or replace) the shared segment
+     * @param name shm name, e.g. "/pc-ale-audio"
+     * @param sample_rate Device sample rate, checked by consumers
+     * @return true on success
+     */
+    bool create(const std::string& name, uint32_t sample_rate);
+
+    /**
+     * @brief Unmap and unlink the segment
+     */
+    void close();
+
+    /**
+     * @brief Install process() as the driver's audio callback
+     */
+    void attach(IAudioDriver& driver);
+
+    /**
+     * @brief Move one device period through the rings (RT thread)
+     */
+    void process(const float* rx_samples, float* tx_samples, size_t num_samples);
+
+    /**
+     * @brief Emit AUDIO_OVERRUN / AUDIO_UNDERRUN for new drops (non-RT thread)
+     */
+    void emit_events(IEventHandler& events, const std::string& source = "shm_audio");
+
+    bool is_open() const { return layout_ != nullptr; }
+    uint64_t get_rx_index() const;
+    uint64_t get_rx_overruns() const;
+    uint64_t get_tx_underruns() const;
+
+private:
+    ShmAudioConfig config_;
+    std::string name_;
+    ShmAudioLayout* layout_ = nullptr;
+    size_t map_bytes_ = 0;
+
+    uint64_t reported_overruns_ = 0;
+    uint64_t reported_underruns_ = 0;
+};
+
+/**
+ * @brief Modem-process side: IAudioDriver backed by a ShmAudioServer
+ *
+ * initialize() takes the segment name as device_name and fails if the
+ * server's sample rate differs. Reading resumes at the server's current
+ * RX index, so sample indices stay continuous across consumer restarts:
+ * AudioBlockInfo indices are the server's absolute counters, and TX
+ * index k is played in the server period that captures RX index k (add
+ * the RT driver's own latency for converter time). RX the server had to
+ * drop while no consumer was reading is never given an index. Timestamps
+ * are not carried across processes (times are 0).
+ *
+ * Callbacks receive pointers straight into the shared rings (no copy) and
+ * at most buffer_frames samples; a block that straddles the end of a ring
+ * is delivered as two callbacks.
+ */
+class ShmAudioDriver : public IAudioDriver {
+public:
+    explicit ShmAudioDriver(const ShmAudioConfig& config = ShmAudioConfig());
+
+    ~ShmAudioDriver() override;
+
+    // IAudioDriver interface
+    bool initialize(const std::string& device_name,
+                    uint32_t sample_rate,
+                    uint32_t buffer_frames) override;
+
+    void shutdown() override;
+    bool start() override;
+    void stop() override;
+
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override;
+    void set_audio_callback(AudioCallbackFn fn, void* context) override;
+    void set_timed_audio_callback(TimedAudioCallback callback) override;
+
+    bool is_running() const override;
+    uint32_t get_sample_rate() const override;
+    uint32_t get_buffer_frames() const override;
+
+    /**
+     * @brief One period plus the TX currently queued for the server
+     */
+    float get_latency_ms() const override;
+
+    // Shared-memory specific
+
+    /**
+     * @brief TX samples dropped because the server stopped consuming
+     */
+    uint64_t get_tx_overruns() const { return tx_overruns_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    bool process_available();
+
+    ShmAudioConfig config_;
+    ShmAudioLayout* layout_ = nullptr;
+    size_t map_bytes_ = 0;
+
+    uint32_t sample_rate_ = 0;
+    uint32_t buffer_frames_ = 0;
+
+    AudioCallbackSlot callback_;
+    std::vector<float> scratch_;    // TX sink when the TX ring is full
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint64_t> tx_overruns_{0};
+};
+
+} // namespace pal
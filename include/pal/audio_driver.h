@@ -9,14 +9,38 @@
 
 #pragma once
 
+#include "pal/rt_thread.h"
+#include "pal/sample_format.h"
+#include "pal/timer.h"
 #include <functional>
 #include <cstdint>
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace pal {
 
+/**
+ * @brief Timing of one audio block, passed to TimedAudioCallback
+ * 
+ * RX and TX indices count frames on a shared timeline that starts at the
+ * driver's first captured frame: RX frame k and TX frame k pass the
+ * converters at the same instant. tx_sample_index - rx_sample_index is
+ * therefore the round-trip latency in frames, and a burst that must go
+ * on air at RX frame k is written where tx_sample_index reaches k.
+ * 
+ * Times are ITimer::get_time_us() values (0 when no timer is set).
+ * Drivers without a hardware clock (file, loopback) report media time:
+ * time at start() plus index / sample rate.
+ */
+struct AudioBlockInfo {
+    uint64_t rx_sample_index = 0;   ///< Timeline index of rx_samples[0]
+    uint64_t tx_sample_index = 0;   ///< Timeline index of tx_samples[0]
+    uint64_t rx_time_us = 0;        ///< When rx_samples[0] was captured
+    uint64_t tx_time_us = 0;        ///< When tx_samples[0] will be played
+};
+
 /**
  * @brief Audio driver interface for platform abstraction
  */
@@ -39,6 +63,49 @@ public:
         size_t num_samples
     )>;
     
+    /**
+     * @brief Function-pointer callback type (no type erasure, no allocation)
+     * 
+     * @param context User pointer given to set_audio_callback
+     * 
+     * @note Same real-time rules as AudioCallback
+     */
+    using AudioCallbackFn = void (*)(
+        void* context,
+        const float* rx_samples,
+        float* tx_samples,
+        size_t num_samples
+    );
+    
+    /**
+     * @brief Audio callback with block timing
+     * 
+     * @note Same real-time rules as AudioCallback
+     */
+    using TimedAudioCallback = std::function<void(
+        const AudioBlockInfo& info,
+        const float* rx_samples,
+        float* tx_samples,
+        size_t num_samples
+    )>;
+    
+    /**
+     * @brief Audio callback on the device's own frames (no conversion)
+     * 
+     * @param rx_frames  Captured frames, interleaved in get_native_format()
+     * @param tx_frames  Playback frames to fill, same layout; every channel
+     *                   must be written (they may hold stale data)
+     * @param num_frames Frame count
+     * 
+     * @note Same real-time rules as AudioCallback
+     */
+    using NativeAudioCallback = std::function<void(
+        const AudioBlockInfo& info,
+        const void* rx_frames,
+        void* tx_frames,
+        size_t num_frames
+    )>;
+    
     /**
      * @brief Initialize audio driver
      * 
@@ -57,10 +124,243 @@ public:
     
     virtual void set_audio_callback(AudioCallback callback) = 0;
     
+    /**
+     * @brief Install a function-pointer callback
+     * 
+     * Drivers that override this call fn directly on the real-time path.
+     * The default wraps it in an AudioCallback (two pointers, fits the
+     * small-buffer storage, so no allocation) for drivers that don't.
+     * Drivers overriding only one overload should add
+     * `using IAudioDriver::set_audio_callback;`.
+     * 
+     * @param fn Callback, or nullptr to clear
+     * @param context Passed back as the first argument
+     */
+    virtual void set_audio_callback(AudioCallbackFn fn, void* context) {
+        if (!fn) {
+            set_audio_callback(AudioCallback());
+            return;
+        }
+        set_audio_callback([fn, context](const float* rx, float* tx, size_t n) {
+            fn(context, rx, tx, n);
+        });
+    }
+    
+    /**
+     * @brief Bind a member function as a function-pointer callback
+     * 
+     * Usage: driver->bind_audio_callback<Modem, &Modem::process>(&modem);
+     */
+    template <typename T, void (T::*Method)(const float*, float*, size_t)>
+    void bind_audio_callback(T* object) {
+        set_audio_callback(&member_trampoline<T, Method>, object);
+    }
+    
+    /**
+     * @brief Install a callback that also receives block timing
+     * 
+     * Replaces any plain callback. Drivers that know their device timing
+     * override this. The default counts frames from the first callback and
+     * estimates times from the timer and get_latency_ms().
+     * 
+     * @param callback Callback, or empty to clear
+     */
+    virtual void set_timed_audio_callback(TimedAudioCallback callback) {
+        if (!callback) {
+            set_audio_callback(AudioCallback());
+            return;
+        }
+        uint64_t rx_index = 0;
+        set_audio_callback([this, callback, rx_index](const float* rx, float* tx, size_t n) mutable {
+            uint32_t rate = get_sample_rate();
+            uint64_t latency = static_cast<uint64_t>(get_latency_ms() * rate / 1000.0f);
+
+            AudioBlockInfo info;
+            info.rx_sample_index = rx_index;
+            info.tx_sample_index = rx_index + latency;
+            if (timer_ && rate > 0) {
+                // The block has just completed: its first frame is n frames old
+                info.rx_time_us = timer_->get_time_us() - n * 1000000ull / rate;
+                info.tx_time_us = info.rx_time_us + latency * 1000000ull / rate;
+            }
+            rx_index += n;
+            callback(info, rx, tx, n);
+        });
+    }
+    
+    /**
+     * @brief Ask for a device frame layout; call before initialize()
+     * 
+     * Drivers open the device in the requested layout when it offers it
+     * and otherwise fall back to one it does; get_native_format() reports
+     * the outcome. Float callbacks always see radio_channel as mono float,
+     * converted by the driver when the device runs anything else.
+     * 
+     * @return false if the driver can never run this layout
+     */
+    virtual bool set_native_format(const AudioFormat& format) {
+        return format.is_mono_float();
+    }
+    
+    /**
+     * @brief Frame layout the device runs (valid after initialize())
+     */
+    virtual AudioFormat get_native_format() const { return AudioFormat(); }
+    
+    /**
+     * @brief Install a callback that receives device frames as they are
+     * 
+     * Replaces any other callback. The default only works for drivers
+     * whose native format is mono float, where it is the timed callback.
+     * 
+     * @param callback Callback, or empty to clear
+     * @return false if the driver can't deliver native frames
+     */
+    virtual bool set_native_audio_callback(NativeAudioCallback callback) {
+        if (!callback) {
+            set_audio_callback(AudioCallback());
+            return true;
+        }
+        if (!get_native_format().is_mono_float()) return false;
+        set_timed_audio_callback([callback](const AudioBlockInfo& info,
+                                            const float* rx, float* tx, size_t n) {
+            callback(info, rx, tx, n);
+        });
+        return true;
+    }
+    
+    /**
+     * @brief Time base for AudioBlockInfo timestamps
+     * 
+     * Set before start(). The timer must outlive the driver. Decorators
+     * override this to forward the timer to the wrapped driver.
+     */
+    virtual void set_timer(const ITimer* timer) { timer_ = timer; }
+    const ITimer* get_timer() const { return timer_; }
+    
+    /**
+     * @brief Scheduling, CPU pinning and memory locking for the audio thread
+     * 
+     * Set before start(); the driver applies it on its own thread when
+     * that thread starts. Drivers whose callback runs on a thread they
+     * don't create (or none at all) may ignore parts of it. Decorators
+     * forward it to the wrapped driver.
+     */
+    virtual void set_rt_policy(const RtThreadPolicy& policy) { rt_policy_ = policy; }
+    const RtThreadPolicy& get_rt_policy() const { return rt_policy_; }
+    
+    /**
+     * @brief What the audio thread was granted (applied == false before start())
+     */
+    virtual RtThreadStatus get_rt_status() const { return rt_status_.load(); }
+    
     virtual bool is_running() const = 0;
     virtual uint32_t get_sample_rate() const = 0;
     virtual uint32_t get_buffer_frames() const = 0;
     virtual float get_latency_ms() const = 0;
+
+protected:
+    const ITimer* timer_ = nullptr;
+    RtThreadPolicy rt_policy_;
+    RtStatusCell rt_status_;            // Stored by the driver thread at startup
+
+private:
+    template <typename T, void (T::*Method)(const float*, float*, size_t)>
+    static void member_trampoline(void* context, const float* rx, float* tx, size_t n) {
+        (static_cast<T*>(context)->*Method)(rx, tx, n);
+    }
+};
+
+/**
+ * @brief Callback holder for driver implementations
+ * 
+ * Stores any form of audio callback and dispatches without going
+ * through std::function when a function pointer was installed. Not
+ * thread-safe: install callbacks before start().
+ */
+class AudioCallbackSlot {
+public:
+    void set(IAudioDriver::AudioCallback callback) {
+        function_ = std::move(callback);
+        timed_ = nullptr;
+        native_ = nullptr;
+        fn_ = nullptr;
+        context_ = nullptr;
+    }
+    
+    void set(IAudioDriver::AudioCallbackFn fn, void* context) {
+        function_ = nullptr;
+        timed_ = nullptr;
+        native_ = nullptr;
+        fn_ = fn;
+        context_ = context;
+    }
+    
+    void set_timed(IAudioDriver::TimedAudioCallback callback) {
+        timed_ = std::move(callback);
+        native_ = nullptr;
+        function_ = nullptr;
+        fn_ = nullptr;
+        context_ = nullptr;
+    }
+    
+    void set_native(IAudioDriver::NativeAudioCallback callback) {
+        native_ = std::move(callback);
+        timed_ = nullptr;
+        function_ = nullptr;
+        fn_ = nullptr;
+        context_ = nullptr;
+    }
+    
+    bool empty() const { return !fn_ && !function_ && !timed_ && !native_; }
+    
+    /**
+     * @brief True if the installed callback uses AudioBlockInfo
+     */
+    bool is_timed() const { return static_cast<bool>(timed_); }
+    
+    /**
+     * @brief True if the installed callback takes device frames
+     */
+    bool is_native() const { return static_cast<bool>(native_); }
+    
+    /**
+     * @brief Invoke a native callback; no-op unless is_native()
+     */
+    void call_native(const AudioBlockInfo& info, const void* rx_frames,
+                     void* tx_frames, size_t num_frames) const {
+        if (native_) native_(info, rx_frames, tx_frames, num_frames);
+    }
+    
+    /**
+     * @brief Invoke the installed callback; no-op when empty
+     */
+    void operator()(const float* rx_samples, float* tx_samples, size_t num_samples) const {
+        if (fn_) {
+            fn_(context_, rx_samples, tx_samples, num_samples);
+        } else if (function_) {
+            function_(rx_samples, tx_samples, num_samples);
+        }
+    }
+    
+    /**
+     * @brief Invoke with block timing; plain callbacks ignore info
+     */
+    void operator()(const AudioBlockInfo& info, const float* rx_samples,
+                    float* tx_samples, size_t num_samples) const {
+        if (timed_) {
+            timed_(info, rx_samples, tx_samples, num_samples);
+        } else {
+            (*this)(rx_samples, tx_samples, num_samples);
+        }
+    }
+
+private:
+    IAudioDriver::AudioCallbackFn fn_ = nullptr;
+    void* context_ = nullptr;
+    IAudioDriver::AudioCallback function_;
+    IAudioDriver::TimedAudioCallback timed_;
+    IAudioDriver::NativeAudioCallback native_;
 };
 
 /**
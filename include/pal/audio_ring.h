@@ -0,0 +1,308 @@
+/**
+ * @file audio_ring.h
+ * @brief Lock-free single-producer/single-consumer audio ring buffer
+ *
+ * Hands samples from the IAudioDriver real-time callback to a processing
+ * thread (or back) without locks or allocation. Header-only.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/events.h"
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace pal {
+
+/**
+ * @brief Cache line size used to keep producer and consumer state apart
+ */
+constexpr size_t PAL_CACHE_LINE = 64;
+
+/**
+ * @brief Wait-free SPSC ring buffer
+ *
+ * Capacity is rounded up to a power of two. Read and write positions are
+ * free-running 64-bit counters, so "full" and "empty" never alias and the
+ * counters double as running sample indices.
+ *
+ * The region API hands out up to two contiguous spans so callers can
+ * produce or consume in place (zero-copy). write()/read() are convenience
+ * copies on top of it that also maintain the overrun/underrun counters.
+ *
+ * Thread rules: write_regions/commit_write/write are producer-only,
+ * read_regions/commit_read/read are consumer-only. emit_events belongs to
+ * a single non-real-time reporting thread, and the statistics getters
+ * may be called from any thread.
+ *
+ * @tparam T Sample type (float, int16_t, ...), must be trivially copyable
+ */
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing requires trivially copyable samples");
+
+public:
+    /**
+     * @brief Up to two contiguous spans of the ring
+     */
+    template <typename U>
+    struct Regions {
+        U* first = nullptr;
+        size_t first_count = 0;
+        U* second = nullptr;
+        size_t second_count = 0;
+
+        size_t total() const { return first_count + second_count; }
+    };
+
+    using WriteRegions = Regions<T>;
+    using ReadRegions = Regions<const T>;
+
+    /**
+     * @brief Construct ring
+     * @param capacity Minimum number of samples (rounded up to power of two)
+     */
+    explicit SpscRing(size_t capacity)
+        : capacity_(round_up_pow2(capacity))
+        , mask_(capacity_ - 1)
+        , buffer_(new T[capacity_]())
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // ---- Producer side ------------------------------------------------
+
+    /**
+     * @brief Get writable regions (at most max_count samples)
+     */
+    WriteRegions write_regions(size_t max_count = SIZE_MAX) {
+        uint64_t head = producer_.head.load(std::memory_order_relaxed);
+        size_t space = capacity_ - static_cast<size_t>(head - producer_.cached_tail);
+        if (space < max_count) {
+            // Refresh the consumer position only when the cached one is short
+            producer_.cached_tail = consumer_.tail.load(std::memory_order_acquire);
+            space = capacity_ - static_cast<size_t>(head - producer_.cached_tail);
+        }
+        return make_regions<T>(head, std::min(space, max_count));
+    }
+
+    /**
+     * @brief Publish count samples written into the write regions
+     */
+    void commit_write(size_t count) {
+        uint64_t head = producer_.head.load(std::memory_order_relaxed) + count;
+        producer_.head.store(head, std::memory_order_release);
+
+        // Fresh consumer position so the mark isn't inflated by a stale cache
+        uint64_t tail = consumer_.tail.load(std::memory_order_relaxed);
+        size_t fill = static_cast<size_t>(head - tail);
+        if (fill > stats_.high_water.load(std::memory_order_relaxed)) {
+            stats_.high_water.store(fill, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Copy samples in; samples that don't fit are dropped and counted
+     * @return Number of samples written
+     */
+    size_t write(const T* data, size_t count) {
+        WriteRegions r = write_regions(count);
+        std::memcpy(r.first, data, r.first_count * sizeof(T));
+        if (r.second_count) {
+            std::memcpy(r.second, data + r.first_count, r.second_count * sizeof(T));
+        }
+        commit_write(r.total());
+
+        if (r.total() < count) {
+            note_overrun(count - r.total());
+        }
+        return r.total();
+    }
+
+    /**
+     * @brief Record samples dropped by a producer using the region API
+     */
+    void note_overrun(size_t dropped) {
+        stats_.overruns.fetch_add(1, std::memory_order_relaxed);
+        stats_.overrun_samples.fetch_add(dropped, std::memory_order_relaxed);
+    }
+
+    // ---- Consumer side ------------------------------------------------
+
+    /**
+     * @brief Get readable regions (at most max_count samples)
+     */
+    ReadRegions read_regions(size_t max_count = SIZE_MAX) {
+        uint64_t tail = consumer_.tail.load(std::memory_order_relaxed);
+        size_t avail = static_cast<size_t>(consumer_.cached_head - tail);
+        if (avail < max_count) {
+            consumer_.cached_head = producer_.head.load(std::memory_order_acquire);
+            avail = static_cast<size_t>(consumer_.cached_head - tail);
+        }
+        return make_regions<const T>(tail, std::min(avail, max_count));
+    }
+
+    /**
+     * @brief Release count samples obtained from read_regions
+     */
+    void commit_read(size_t count) {
+        uint64_t tail = consumer_.tail.load(std::memory_order_relaxed);
+        consumer_.tail.store(tail + count, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy samples out; a short read is counted as an underrun
+     * @return Number of samples read
+     */
+    size_t read(T* data, size_t count) {
+        ReadRegions r = read_regions(count);
+        std::memcpy(data, r.first, r.first_count * sizeof(T));
+        if (r.second_count) {
+            std::memcpy(data + r.first_count, r.second, r.second_count * sizeof(T));
+        }
+        commit_read(r.total());
+
+        if (r.total() < count) {
+            note_underrun(count - r.total());
+        }
+        return r.total();
+    }
+
+    /**
+     * @brief Record samples missing for a consumer using the region API
+     */
+    void note_underrun(size_t missing) {
+        stats_.underruns.fetch_add(1, std::memory_order_relaxed);
+        stats_.underrun_samples.fetch_add(missing, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Emit AUDIO_OVERRUN / AUDIO_UNDERRUN for counts since the last call
+     *
+     * Call from the reporting thread; code carries the number of new
+     * overrun/underrun occurrences.
+     */
+    void emit_events(IEventHandler& events, const std::string& source = "audio_ring") {
+        uint64_t overruns = get_overruns();
+        uint64_t underruns = get_underruns();
+
+        if (overruns != reported_overruns_) {
+            emit(events, EventType::AUDIO_OVERRUN, source, overruns - reported_overruns_,
+                 get_overrun_samples(), "samples dropped");
+            reported_overruns_ = overruns;
+        }
+        if (underruns != reported_underruns_) {
+            emit(events, EventType::AUDIO_UNDERRUN, source, underruns - reported_underruns_,
+                 get_underrun_samples(), "samples missing");
+            reported_underruns_ = underruns;
+        }
+    }
+
+    // ---- Any thread -----------------------------------------------------
+
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Samples currently queued
+     */
+    size_t size() const {
+        uint64_t head = producer_.head.load(std::memory_order_acquire);
+        uint64_t tail = consumer_.tail.load(std::memory_order_acquire);
+        return static_cast<size_t>(head - tail);
+    }
+
+    /**
+     * @brief Total samples ever written (running sample index of the producer)
+     */
+    uint64_t get_write_index() const { return producer_.head.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Total samples ever read (running sample index of the consumer)
+     */
+    uint64_t get_read_index() const { return consumer_.tail.load(std::memory_order_acquire); }
+
+    size_t get_high_water_mark() const { return stats_.high_water.load(std::memory_order_relaxed); }
+    uint64_t get_overruns() const { return stats_.overruns.load(std::memory_order_relaxed); }
+    uint64_t get_overrun_samples() const { return stats_.overrun_samples.load(std::memory_order_relaxed); }
+    uint64_t get_underruns() const { return stats_.underruns.load(std::memory_order_relaxed); }
+    uint64_t get_underrun_samples() const { return stats_.underrun_samples.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Reset the high-water mark (e.g. per reporting interval)
+     */
+    void reset_high_water_mark() { stats_.high_water.store(size(), std::memory_order_relaxed); }
+
+private:
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    template <typename U>
+    Regions<U> make_regions(uint64_t start, size_t count) const {
+        Regions<U> r;
+        size_t offset = static_cast<size_t>(start) & mask_;
+        r.first = buffer_.get() + offset;
+        r.first_count = std::min(count, capacity_ - offset);
+        r.second = buffer_.get();
+        r.second_count = count - r.first_count;
+        return r;
+    }
+
+    static void emit(IEventHandler& events, EventType type, const std::string& source,
+                     uint64_t occurrences, uint64_t total_samples, const char* what) {
+        Event event{};
+        event.type = type;
+        event.source = source;
+        event.message = std::to_string(total_samples) + " " + what + " (total)";
+        event.code = static_cast<int32_t>(std::min<uint64_t>(occurrences, INT32_MAX));
+        events.emit(event);
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> buffer_;
+
+    // Producer-owned line
+    struct alignas(PAL_CACHE_LINE) ProducerState {
+        std::atomic<uint64_t> head{0};
+        uint64_t cached_tail = 0;
+    } producer_;
+
+    // Consumer-owned line
+    struct alignas(PAL_CACHE_LINE) ConsumerState {
+        std::atomic<uint64_t> tail{0};
+        uint64_t cached_head = 0;
+    } consumer_;
+
+    // Counters (single writer each), kept off the index lines
+    struct alignas(PAL_CACHE_LINE) Stats {
+        std::atomic<size_t> high_water{0};
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<uint64_t> overrun_samples{0};
+        std::atomic<uint64_t> underruns{0};
+        std::atomic<uint64_t> underrun_samples{0};
+    } stats_;
+
+    // Consumer-side reporting state
+    uint64_t reported_overruns_ = 0;
+    uint64_t reported_underruns_ = 0;
+};
+
+using AudioRing = SpscRing<float>;
+using AudioRing16 = SpscRing<int16_t>;
+
+} // namespace pal
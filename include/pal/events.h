@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace pal {
@@ -32,6 +33,8 @@ enum class EventType {
     AUDIO_ERROR,
     AUDIO_OVERRUN,
     AUDIO_UNDERRUN,
+    AUDIO_LEVEL,
+    AUDIO_TX_DRAINING,
     
     // ALE events
     ALE_CALL_RECEIVED,
@@ -0,0 +1,63 @@
+/**
+ * @file fractional_resampler.h
+ * @brief Variable-ratio resampler for clock drift correction
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace pal {
+
+/**
+ * @brief Cubic-interpolating resampler with a continuously adjustable ratio
+ *
+ * Meant for ratios within a fraction of a percent of 1.0, where two
+ * nominally equal sample clocks drift apart by tens to hundreds of ppm.
+ * Catmull-Rom interpolation over four input samples, no filter design,
+ * two samples of delay. The ratio can be changed between calls without
+ * a glitch. Not a general rate converter: use Resampler for 6:1.
+ */
+class FractionalResampler {
+public:
+    /**
+     * @param ratio Input samples consumed per output sample
+     */
+    explicit FractionalResampler(double ratio = 1.0);
+
+    /**
+     * @brief Set input samples consumed per output sample
+     */
+    void set_ratio(double ratio) { ratio_ = ratio; }
+    double get_ratio() const { return ratio_; }
+
+    /**
+     * @brief Produce up to output_count samples from up to input_count inputs
+     *
+     * Stops when either side runs out; unused input is left for the next
+     * call (see consumed).
+     *
+     * @param consumed Set to the number of input samples used
+     * @return Number of output samples produced
+     */
+    size_t process(const float* input, size_t input_count,
+                   float* output, size_t output_count,
+                   size_t* consumed);
+
+    /**
+     * @brief Clear history
+     */
+    void reset();
+
+private:
+    double ratio_;
+    double mu_;         // Output position past hist_[1], in input samples
+    float hist_[4];
+};
+
+} // namespace pal
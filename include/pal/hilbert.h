@@ -0,0 +1,96 @@
+/**
+ * @file hilbert.h
+ * @brief Hilbert transformer / analytic signal for real SSB audio
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace pal {
+
+class Resampler;
+
+/**
+ * @brief FIR Hilbert transformer producing an analytic signal (I + jQ)
+ *
+ * Designed from a windowed half-band lowpass shifted to Fs/4, so every
+ * even-offset tap (including the center) is exactly zero. Only the
+ * non-zero taps are stored, and the antisymmetry h[-n] = -h[n] folds each
+ * pair into one multiply. The kernel runs tap-by-tap across a block of
+ * outputs so the inner loop is unit-stride and auto-vectorizes.
+ *
+ * I is the input delayed by the filter group delay ((num_taps - 1) / 2),
+ * Q is the Hilbert transform, so I + jQ has its negative frequencies
+ * suppressed.
+ */
+class Hilbert {
+public:
+    /**
+     * @brief Construct Hilbert transformer
+     *
+     * @param num_taps Filter length, rounded up to the next 4k+3
+     *                 (default 63 = ~300 Hz transition at 8 kHz)
+     */
+    explicit Hilbert(int num_taps = 63);
+
+    /**
+     * @brief Produce analytic signal
+     *
+     * @param input Real input samples
+     * @param count Number of samples
+     * @param out_i In-phase output (delayed input), count samples
+     * @param out_q Quadrature output, count samples
+     */
+    void process(const float* input, size_t count, float* out_i, float* out_q);
+
+    /**
+     * @brief Decimate and transform in one pass (48kHz real -> 8kHz analytic)
+     *
+     * The Hilbert filter runs at the decimated rate only.
+     *
+     * @param resampler Resampler performing the decimation
+     * @param input Input samples at high rate
+     * @param input_count Number of input samples
+     * @param out_i In-phase output (must hold input_count/ratio samples)
+     * @param out_q Quadrature output (must hold input_count/ratio samples)
+     * @return Number of output samples produced
+     */
+    size_t decimate(Resampler& resampler, const float* input, size_t input_count,
+                    float* out_i, float* out_q);
+
+    /**
+     * @brief Reset filter state (clear history)
+     */
+    void reset();
+
+    /**
+     * @brief Get filter length
+     */
+    int get_num_taps() const { return num_taps_; }
+
+    /**
+     * @brief Get group delay in samples
+     */
+    int get_delay() const { return half_len_; }
+
+private:
+    static constexpr size_t BLOCK = 64;     // Outputs per kernel pass
+
+    void design_filter();
+    void process_block(size_t count, float* out_i, float* out_q);
+
+    int num_taps_;
+    int half_len_;
+
+    std::vector<float> coeffs_;     // Non-zero taps at offsets 1, 3, 5, ...
+    std::vector<float> work_;       // [history (num_taps-1) | block input]
+};
+
+} // namespace pal
@@ -0,0 +1,189 @@
+/**
+ * @file ptt_scheduler.h
+ * @brief PTT keying scheduled against the TX sample clock
+ *
+ * IRadio::set_ptt() acts when it is called, so the gap between key-up and
+ * the first audio sample depends on whichever thread happened to call it.
+ * PttScheduler converts TX sample indices to ITimer time using the
+ * AudioBlockInfo of each callback and keys the radio so it is settled a
+ * fixed lead before the first sample, then unkeys once the last sample has
+ * left the converter. Guard times can shrink to what the radio needs.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/events.h"
+#include "pal/rt_thread.h"
+#include "pal/serial.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pal {
+
+class IRadio;
+class ITimer;
+struct TxBurst;
+
+/**
+ * @brief Per-radio PTT timing
+ *
+ * The key command is issued at
+ *   t(first sample) - lead_us - key_up_delay_us - wire time of key_command_bytes
+ * and the unkey command at t(end of last sample) + tail_us.
+ */
+struct PttTiming {
+    uint32_t lead_us = 0;               ///< Margin between PTT settled and the first sample
+    uint32_t key_up_delay_us = 0;       ///< Radio's T/R switching time after the command arrives
+    uint32_t tail_us = 0;               ///< Hold after the last sample has played
+    uint32_t key_command_bytes = 0;     ///< CAT key command length (0 = RTS/DTR/GPIO keying)
+    SerialConfig serial;                ///< CAT port framing, for the command's wire time
+};
+
+/**
+ * @brief PTT scheduler configuration
+ */
+struct PttSchedulerConfig {
+    uint32_t sample_rate = 48000;       ///< TX sample rate of the audio driver
+    PttTiming timing;
+    std::string source = "ptt_scheduler";
+    RtThreadPolicy rt;                  ///< Applied to the worker thread at start()
+};
+
+/**
+ * @brief Keys and unkeys a radio at TX sample indices
+ *
+ * Feed the TX clock by calling update_clock() from the timed audio
+ * callback (the driver needs set_timer() with the same ITimer, otherwise
+ * the block times are 0 and are ignored). Transmissions are scheduled as
+ * [first_index, first_index + count) on the AudioBlockInfo::tx_sample_index
+ * timeline, e.g. the same span a TxBurst occupies in TxScheduler.
+ *
+ * A worker thread owns all set_ptt() calls, since CAT keying blocks for
+ * the serial write. Transmissions closer together than the unkey/key
+ * turnaround are merged into one keyed period. A transmission whose key
+ * time has already passed is keyed at once, and counted as late if the
+ * radio can no longer settle before its first sample.
+ *
+ * Thread rules: update_clock() is real-time safe (a seqlock store);
+ * everything else belongs to non-real-time threads.
+ */
+class PttScheduler {
+public:
+    PttScheduler(IRadio& radio, const ITimer& timer,
+                 const PttSchedulerConfig& config = PttSchedulerConfig());
+
+    /**
+     * @brief Stops the worker; a keyed radio is unkeyed first
+     */
+    ~PttScheduler();
+
+    PttScheduler(const PttScheduler&) = delete;
+    PttScheduler& operator=(const PttScheduler&) = delete;
+
+    bool start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    // ---- Real-time side -------------------------------------------------
+
+    /**
+     * @brief Record the TX sample index -> time mapping of one audio block
+     */
+    void update_clock(const AudioBlockInfo& info);
+
+    // ---- Non-real-time side ---------------------------------------------
+
+    /**
+     * @brief Key for TX samples [first_index, first_index + count)
+     * @return false if not running or count is 0
+     */
+    bool schedule(uint64_t first_index, uint64_t count);
+
+    /**
+     * @brief Key for a burst already submitted to TxScheduler
+     * @return false for as-soon-as-possible bursts (TX_START_ASAP) or empty ones
+     */
+    bool schedule(const TxBurst& burst);
+
+    /**
+     * @brief Drop pending transmissions and unkey now
+     */
+    void cancel();
+
+    /**
+     * @brief Emit PTT_ON / PTT_OFF for keying done since the last call
+     *
+     * code carries the timing error in microseconds: when set_ptt()
+     * returned minus when it should have been called.
+     */
+    void emit_events(IEventHandler& events);
+
+    /**
+     * @brief ITimer time at which TX sample index is converted, 0 if unknown
+     */
+    uint64_t index_to_time_us(uint64_t index) const;
+
+    /**
+     * @brief Lead from key command to first sample implied by the timing
+     */
+    uint64_t key_advance_us() const;
+
+    bool is_keyed() const { return keyed_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Keyings that came too late for the radio to settle before the first sample
+     */
+    uint64_t get_late_keys() const { return late_keys_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief What the worker thread was granted from config.rt
+     */
+    RtThreadStatus get_rt_status() const { return rt_status_.load(); }
+
+private:
+    struct Span {
+        uint64_t first;
+        uint64_t end;                   // One past the last sample
+    };
+
+    void run();
+    bool read_clock(uint64_t* index, uint64_t* time_us) const;
+    void set_ptt(bool transmit, uint64_t target_us);
+
+    IRadio& radio_;
+    const ITimer& timer_;
+    PttSchedulerConfig config_;
+
+    // TX clock anchor, written by the audio thread
+    std::atomic<uint32_t> clock_seq_{0};
+    std::atomic<uint64_t> clock_index_{0};
+    std::atomic<uint64_t> clock_time_us_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Span> pending_;
+    std::vector<Event> events_;
+    std::atomic<bool> running_{false};
+    bool stop_requested_ = false;
+    bool cancel_requested_ = false;
+    std::thread thread_;
+    RtStatusCell rt_status_;
+
+    // Worker state
+    uint64_t keyed_end_ = 0;
+    std::atomic<bool> keyed_{false};
+    std::atomic<uint64_t> late_keys_{0};
+};
+
+} // namespace pal
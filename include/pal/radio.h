@@ -55,6 +55,16 @@ struct Channel {
     bool in_use = false;            ///< Channel in use flag
 };
 
+/**
+ * @brief Outcome of an asynchronous radio command
+ */
+struct RadioCompletion {
+    bool ok = false;            ///< Acknowledged / read back as requested
+    bool confirmed = false;     ///< The radio answered (false: completed locally)
+    uint32_t attempts = 0;      ///< Writes made, retries included
+    uint64_t latency_us = 0;    ///< Request to confirmation
+};
+
 /**
  * @brief Radio interface - abstracts all radio control
  * 
@@ -77,6 +87,11 @@ public:
      */
     using AckCallback = std::function<void()>;
     
+    /**
+     * @brief Callback for asynchronous command completion
+     */
+    using CompletionCallback = std::function<void(const RadioCompletion& completion)>;
+    
     // Lifecycle
     virtual bool initialize() = 0;
     virtual void shutdown() = 0;
@@ -91,6 +106,30 @@ public:
     virtual void set_ptt(bool transmit) = 0;
     virtual bool is_transmitting() const = 0;
     
+    // Asynchronous variants: on_complete runs once the radio has acknowledged
+    // the change or a readback confirmed it. They return false (and never
+    // call on_complete) if the command could not be issued. The defaults
+    // call the synchronous versions and complete at once, unconfirmed.
+    
+    virtual bool set_channel_async(const Channel& channel, CompletionCallback on_complete) {
+        if (!set_channel(channel)) return false;
+        RadioCompletion completion;
+        completion.ok = true;
+        completion.attempts = 1;
+        if (on_complete) on_complete(completion);
+        return true;
+    }
+    
+    virtual bool set_ptt_async(bool transmit, CompletionCallback on_complete) {
+        if (!is_ready()) return false;
+        set_ptt(transmit);
+        RadioCompletion completion;
+        completion.ok = true;
+        completion.attempts = 1;
+        if (on_complete) on_complete(completion);
+        return true;
+    }
+    
     // Status
     virtual bool is_ready() const = 0;
     virtual std::string get_port_config() const = 0;  ///< e.g., "9600,n,8,1"
@@ -101,6 +140,32 @@ public:
     
     // Process response from radio
     virtual void process_response(const uint8_t* data, size_t length) = 0;
+    
+    // Pre-encoded channel changes (see ScanList). The defaults make
+    // scan lists fall back to set_channel().
+    
+    /**
+     * @brief Encode every field set_channel manages for a channel, as if the
+     *        radio state were unknown
+     * @return Bytes written to out, 0 if unsupported or capacity is too small
+     */
+    virtual size_t encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const {
+        (void)channel; (void)out; (void)capacity;
+        return 0;
+    }
+    
+    /**
+     * @brief Changes whenever encode_channel output would (address, managed fields)
+     */
+    virtual uint32_t encoding_generation() const { return 0; }
+    
+    /**
+     * @brief Send bytes from encode_channel in one write and adopt the channel
+     */
+    virtual bool send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) {
+        (void)data; (void)length;
+        return set_channel(channel);
+    }
 };
 
 /**
@@ -0,0 +1,266 @@
+/**
+ * @file cat_command_queue.h
+ * @brief Pipelined CAT command queue with reply matching and retries
+ *
+ * IRadio implementations write commands and move on; nothing tells the
+ * caller which command the radio took. CatCommandQueue sits between a
+ * radio and its serial port, keeps up to `window` commands in flight and
+ * matches replies to them in order (radios answer in the order they were
+ * addressed):
+ *
+ * - CI-V: every frame of a request gets FB (ok), FA (NAK) or, for reads,
+ *   a data frame carrying the same command byte. Echoes of our own frames
+ *   on the one-wire bus and frames for other controllers are ignored.
+ * - Kenwood/Elecraft: set commands are silent, so a request completes on
+ *   write unless its last command is a bare query ("FA;"), which completes
+ *   on the reply with that code. Bare actions ("TX;", "RX;", "UP;", ...)
+ *   are not queries. "?;", "E;" and "O;" are NAKs.
+ * - Yaesu 5-byte CAT: replies have no framing; pass the expected length
+ *   (5 for READ_FREQ, 1 for status reads) to submit(), 0 for set commands.
+ *
+ * A timeout or NAK re-sends the command after an exponential backoff, up
+ * to max_retries times; commands queued behind it wait. If newer commands
+ * are already in flight (window > 1) it fails at once instead, since a
+ * re-send would reach the radio after them. Each command reports its
+ * latency when it completes. Keep timeout_us above the radio's worst
+ * turnaround: with window > 1 a reply arriving after its command timed
+ * out is taken by the next one. A NAK on one frame of a multi-frame CI-V
+ * request discards the answers the radio still owes for its other frames.
+ *
+ * Radios that need time between commands get pacing_us: each write is
+ * followed by that gap (after its wire time) before the next, and Yaesu
+ * requests are written one 5-byte command at a time.
+ *
+ * There is no thread inside: feed received bytes to on_receive() and call
+ * poll() regularly (next_deadline_us() says when it is next needed).
+ * All methods are thread-safe; completion callbacks run without the
+ * queue's lock held, on the thread that called submit/on_receive/poll.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radio.h"
+#include "pal/serial.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace pal {
+
+class ITimer;
+
+constexpr size_t CAT_MAX_COMMAND_BYTES = 128;   ///< Longest request accepted by submit()
+constexpr size_t CAT_MAX_REPLY_BYTES = 64;      ///< Longest reply kept for the completion
+
+/**
+ * @brief Wire protocol, for reply framing and matching
+ */
+enum class CatProtocol {
+    CIV,        ///< Icom CI-V
+    KENWOOD,    ///< Kenwood/Elecraft ASCII (and newer Yaesu ASCII CAT)
+    YAESU,      ///< Yaesu 5-byte CAT
+};
+
+/**
+ * @brief How a command finished
+ */
+enum class CatResult {
+    OK,         ///< Acknowledged, data reply received, or written (no reply expected)
+    NAK,        ///< Refused on every attempt
+    TIMEOUT,    ///< No reply on any attempt
+    CANCELLED,  ///< Dropped by cancel_all()
+};
+
+/**
+ * @brief Completion report for one command
+ */
+struct CatCompletion {
+    uint64_t id = 0;                ///< Returned by submit()
+    CatResult result = CatResult::OK;
+    uint32_t attempts = 0;          ///< Writes made (1 = no retries)
+    uint64_t latency_us = 0;        ///< submit() to completion, retries included
+    uint64_t reply_us = 0;          ///< Last write to reply (wire time if no reply is expected)
+    const uint8_t* reply = nullptr; ///< Whole reply frame/text/bytes (valid during the callback only)
+    size_t reply_length = 0;
+};
+
+using CatCompletionCallback = std::function<void(const CatCompletion&)>;
+
+/**
+ * @brief IRadio view of a finished command
+ * @param verified False if the reply arrived but showed another state
+ */
+inline RadioCompletion make_radio_completion(const CatCompletion& completion, bool verified = true) {
+    RadioCompletion result;
+    result.confirmed = completion.result == CatResult::OK;
+    result.ok = result.confirmed && verified;
+    result.attempts = completion.attempts;
+    result.latency_us = completion.latency_us;
+    return result;
+}
+
+/**
+ * @brief CatCommandQueue configuration
+ */
+struct CatQueueConfig {
+    CatProtocol protocol = CatProtocol::CIV;
+    size_t window = 1;                  ///< Commands in flight at once
+    uint32_t timeout_us = 200000;       ///< Reply timeout, counted from the end of the write's wire time
+    uint32_t max_retries = 2;           ///< Re-sends after a timeout or NAK
+    uint32_t backoff_us = 20000;        ///< Delay before the first re-send, doubled each time
+    uint32_t pacing_us = 0;             ///< Gap after each write's wire time (0 = none)
+    SerialConfig serial;                ///< Port framing, for wire time
+};
+
+/**
+ * @brief Counters since construction
+ */
+struct CatQueueStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;             ///< Finished OK
+    uint64_t failed = 0;                ///< Finished NAK or TIMEOUT
+    uint64_t retries = 0;
+    uint64_t naks = 0;                  ///< NAK replies (including retried ones)
+    uint64_t timeouts = 0;              ///< Timed-out attempts (including retried ones)
+    uint64_t unmatched = 0;             ///< Replies with nothing waiting for them
+};
+
+/**
+ * @brief Per-radio CAT command pipeline
+ *
+ * Typical wiring:
+ *   radio.register_send_callback([&](const uint8_t* d, size_t n) { queue.submit(d, n); });
+ *   serial.set_receive_callback([&](const uint8_t* d, size_t n) {
+ *       queue.on_receive(d, n);
+ *       radio.process_response(d, n);
+ *   });
+ */
+class CatCommandQueue {
+public:
+    using WriteFunction = std::function<void(const uint8_t* data, size_t length)>;
+
+    /**
+     * @param write Writes to the radio's port (e.g. ISerial::write)
+     * @param timer Clock for timeouts, backoff and latency
+     */
+    CatCommandQueue(WriteFunction write, const ITimer& timer,
+                    const CatQueueConfig& config = CatQueueConfig());
+
+    CatCommandQueue(const CatCommandQueue&) = delete;
+    CatCommandQueue& operator=(const CatCommandQueue&) = delete;
+
+    /**
+     * @brief Queue a command, writing it now if the window has room
+     * @param reply_length Yaesu only: reply bytes to wait for (0 = none)
+     * @return Command id, 0 if empty or longer than CAT_MAX_COMMAND_BYTES
+     */
+    uint64_t submit(const uint8_t* data, size_t length,
+                    CatCompletionCallback on_complete = nullptr, size_t reply_length = 0);
+
+    /**
+     * @brief Bytes received from the radio
+     */
+    void on_receive(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Handle timeouts and send commands whose backoff has passed
+     */
+    void poll();
+
+    /**
+     * @brief Time poll() next has work to do, 0 if nothing is waiting
+     */
+    uint64_t next_deadline_us() const;
+
+    /**
+     * @brief Drop everything queued or in flight (completes them CANCELLED)
+     */
+    void cancel_all();
+
+    size_t in_flight() const;
+    size_t pending() const;
+    bool idle() const { return in_flight() == 0 && pending() == 0; }
+
+    CatQueueStats get_stats() const;
+    const CatQueueConfig& get_config() const { return config_; }
+
+private:
+    struct Command {
+        uint64_t id = 0;
+        std::array<uint8_t, CAT_MAX_COMMAND_BYTES> bytes;
+        size_t length = 0;
+        size_t written = 0;             // Bytes out on this attempt (paced requests go in pieces)
+        CatCompletionCallback on_complete;
+
+        // What completes it
+        size_t replies_expected = 0;    // CI-V frames, 1 for a Kenwood query, 0 = on write
+        size_t replies_received = 0;
+        size_t reply_length = 0;        // Yaesu fixed reply
+        uint8_t civ_radio = 0;          // CI-V request addresses
+        uint8_t civ_controller = 0;
+        std::array<uint8_t, 16> civ_cmds;   // Command byte of each request frame
+        char kenwood_code[2] = {0, 0};
+
+        uint32_t attempts = 0;
+        uint64_t submit_us = 0;
+        uint64_t write_us = 0;
+        uint64_t deadline_us = 0;       // Reply timeout (in flight) or earliest re-send (pending)
+
+        std::array<uint8_t, CAT_MAX_REPLY_BYTES> reply;
+        size_t reply_size = 0;
+    };
+
+    struct Finished {
+        CatCompletionCallback on_complete;
+        CatCompletion completion;
+        std::array<uint8_t, CAT_MAX_REPLY_BYTES> reply;
+    };
+
+    // All called with mutex_ held; finished commands are collected in done
+    // and their callbacks run by the caller after unlocking
+    void classify(Command& command) const;
+    void pump(uint64_t now, std::vector<Finished>& done);
+    void write(Command& command, uint64_t now, std::vector<Finished>& done);
+    uint64_t write_piece(Command& command, uint64_t now);
+    void written(Command& command, uint64_t now, uint64_t wire_us, std::vector<Finished>& done);
+    bool writing() const { return !in_flight_.empty() && in_flight_.back().written < in_flight_.back().length; }
+    void finish(Command& command, CatResult result, uint64_t now, std::vector<Finished>& done);
+    void fail_head(CatResult result, uint64_t now, std::vector<Finished>& done);
+    void reply_head(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done);
+
+    void receive_civ(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done);
+    void receive_kenwood(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done);
+    void receive_yaesu(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done);
+
+    static void run(std::vector<Finished>& done);
+
+    WriteFunction write_;
+    const ITimer& timer_;
+    CatQueueConfig config_;
+
+    mutable std::mutex mutex_;
+    std::deque<Command> pending_;       // Not yet written, or waiting out a backoff
+    std::deque<Command> in_flight_;     // Written, oldest first
+    uint64_t next_id_ = 1;
+    uint64_t next_write_us_ = 0;        // Pacing: earliest time of the next write
+    CatQueueStats stats_;
+
+    // Reply framing
+    std::array<uint8_t, CAT_MAX_REPLY_BYTES> rx_;
+    size_t rx_size_ = 0;
+
+    // CI-V answers still owed for the later frames of a NAKed request
+    size_t civ_skip_ = 0;
+    uint8_t civ_skip_controller_ = 0;
+    uint8_t civ_skip_radio_ = 0;
+};
+
+} // namespace pal
@@ -0,0 +1,326 @@
+/**
+ * @file civ_codec.h
+ * @brief Allocation-free CI-V frame encoder
+ *
+ * Frames are encoded into fixed-capacity buffers whose size is known at
+ * compile time, so command paths (PTT, channel changes) never touch the
+ * heap and can run on latency-sensitive threads. Several frames can be
+ * packed into one buffer and handed to ISerial::write in one call.
+ * Header-only.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radio.h"
+#include "pal/radios/radio_state_shadow.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pal {
+
+/**
+ * @brief CI-V protocol constants
+ */
+constexpr uint8_t CIV_PREAMBLE = 0xFE;
+constexpr uint8_t CIV_EOM = 0xFD;           // End of message
+constexpr uint8_t CIV_CONTROLLER = 0xE0;    // Default controller address
+constexpr uint8_t CIV_BROADCAST = 0x00;     // Transceive frames are sent to all
+constexpr uint8_t CIV_ACK = 0xFB;
+constexpr uint8_t CIV_NAK = 0xFA;
+constexpr uint8_t CIV_JAM = 0xFC;           // Collision on the bus
+
+/**
+ * @brief CI-V command codes
+ */
+enum class CivCommand : uint8_t {
+    TRANSCEIVE_FREQ = 0x00, // Frequency changed (unsolicited, to 0x00)
+    TRANSCEIVE_MODE = 0x01, // Mode changed (unsolicited, to 0x00)
+    SET_FREQ = 0x05,        // Set frequency (BCD)
+    SET_MODE = 0x06,        // Set mode
+    SET_VFO = 0x07,         // Select VFO
+    SET_MEM = 0x08,         // Select memory channel
+    READ_FREQ = 0x03,       // Read frequency
+    READ_MODE = 0x04,       // Read mode
+    PTT = 0x1C,             // PTT control (subcommand 0x00)
+    SPLIT = 0x0F,           // Split operation
+    VFO_EQUAL = 0x07,       // VFO A=B (subcommand 0xA0)
+    ATTENUATOR = 0x11,      // Attenuator (BCD dB)
+    ANTENNA = 0x12,         // Antenna select
+    LEVEL = 0x14,           // Levels (subcommand 0x0A = RF power)
+    READ_METER = 0x15,      // Meters (subcommand 0x02 = S-meter)
+    UNSELECTED_FREQ = 0x25, // Unselected VFO frequency (subcommand 0x01)
+};
+
+/**
+ * @brief CI-V mode codes
+ */
+enum class CivMode : uint8_t {
+    LSB = 0x00,
+    USB = 0x01,
+    AM = 0x02,
+    CW = 0x03,
+    RTTY = 0x04,
+    FM = 0x05,
+    CW_R = 0x07,
+    RTTY_R = 0x08,
+    DV = 0x17,
+};
+
+constexpr size_t CIV_FREQ_BYTES = 5;        ///< 10 BCD digits, 1 Hz resolution
+constexpr size_t CIV_MAX_PAYLOAD = 8;       ///< Subcommand + data carried by one frame
+constexpr size_t CIV_MAX_FRAME = 6 + CIV_MAX_PAYLOAD;   ///< FE FE to from cmd ... FD
+
+/**
+ * @brief Fixed-capacity buffer holding one or more encoded CI-V frames
+ *
+ * append() either writes a whole frame or leaves the buffer unchanged,
+ * so a buffer never holds a truncated frame.
+ */
+template <size_t Capacity>
+class CivBuffer {
+public:
+    static constexpr size_t CAPACITY = Capacity;
+
+    const uint8_t* data() const { return bytes_.data(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear() { size_ = 0; }
+    void truncate(size_t size) { if (size < size_) size_ = size; }
+
+    /**
+     * @brief Append FE FE to from cmd payload FD
+     * @return False if the frame doesn't fit (buffer unchanged)
+     */
+    bool append(uint8_t to, uint8_t from, uint8_t cmd, const uint8_t* payload, size_t len) {
+        if (len > CIV_MAX_PAYLOAD || size_ + 6 + len > Capacity) return false;
+
+        uint8_t* p = bytes_.data() + size_;
+        p[0] = CIV_PREAMBLE;
+        p[1] = CIV_PREAMBLE;
+        p[2] = to;
+        p[3] = from;
+        p[4] = cmd;
+        if (len) std::memcpy(p + 5, payload, len);
+        p[5 + len] = CIV_EOM;
+        size_ += 6 + len;
+        return true;
+    }
+
+private:
+    std::array<uint8_t, Capacity> bytes_;
+    size_t size_ = 0;
+};
+
+using CivFrameBuffer = CivBuffer<CIV_MAX_FRAME>;        ///< One frame
+using CivChannelBuffer = CivBuffer<2 * CIV_MAX_FRAME>;  ///< Frequency + mode
+using CivStateBuffer = CivBuffer<5 * CIV_MAX_FRAME>;    ///< Every RadioStateField
+
+/**
+ * @brief CI-V command encoder for one radio address
+ *
+ * The encode_* functions append to any CivBuffer and return false if it
+ * is full.
+ */
+class CivCodec {
+public:
+    explicit CivCodec(uint8_t radio_addr, uint8_t controller_addr = CIV_CONTROLLER)
+        : radio_addr_(radio_addr)
+        , controller_addr_(controller_addr)
+    {
+    }
+
+    void set_radio_address(uint8_t addr) { radio_addr_ = addr; }
+    uint8_t get_radio_address() const { return radio_addr_; }
+    void set_controller_address(uint8_t addr) { controller_addr_ = addr; }
+    uint8_t get_controller_address() const { return controller_addr_; }
+
+    /**
+     * @brief Any command with raw payload (subcommand, if any, first)
+     */
+    template <size_t N>
+    bool encode(CivBuffer<N>& out, CivCommand cmd, const uint8_t* payload = nullptr, size_t len = 0) const {
+        return out.append(radio_addr_, controller_addr_, static_cast<uint8_t>(cmd), payload, len);
+    }
+
+    /**
+     * @brief Set operating frequency (0x05)
+     */
+    template <size_t N>
+    bool encode_freq(CivBuffer<N>& out, uint32_t freq_hz) const {
+        uint8_t bcd[CIV_FREQ_BYTES];
+        freq_to_bcd(freq_hz, bcd, CIV_FREQ_BYTES);
+        return encode(out, CivCommand::SET_FREQ, bcd, CIV_FREQ_BYTES);
+    }
+
+    /**
+     * @brief Set operating mode (0x06)
+     */
+    template <size_t N>
+    bool encode_mode(CivBuffer<N>& out, RadioMode mode) const {
+        uint8_t civ = static_cast<uint8_t>(radio_mode_to_civ(mode));
+        return encode(out, CivCommand::SET_MODE, &civ, 1);
+    }
+
+    /**
+     * @brief Transmit/receive (0x1C 0x00)
+     */
+    template <size_t N>
+    bool encode_ptt(CivBuffer<N>& out, bool transmit) const {
+        const uint8_t payload[2] = { 0x00, transmit ? uint8_t(0x01) : uint8_t(0x00) };
+        return encode(out, CivCommand::PTT, payload, 2);
+    }
+
+    /**
+     * @brief RX frequency and mode of a channel, back to back in one buffer
+     *
+     * All or nothing: on failure the buffer is left as it was.
+     */
+    template <size_t N>
+    bool encode_channel(CivBuffer<N>& out, const Channel& channel) const {
+        size_t before = out.size();
+        if (encode_freq(out, channel.rx_frequency) && encode_mode(out, channel.rx_mode)) return true;
+        out.truncate(before);
+        return false;
+    }
+
+    /**
+     * @brief Split off (0x0F 0x00), or TX frequency on the unselected VFO
+     *        (0x25 0x01) followed by split on (0x0F 0x01)
+     *
+     * 0x25 exists on the IC-7300 generation onwards.
+     */
+    template <size_t N>
+    bool encode_split(CivBuffer<N>& out, const Channel& channel) const {
+        size_t before = out.size();
+        bool split = RadioStateShadow::is_split(channel);
+        if (split) {
+            uint8_t payload[1 + CIV_FREQ_BYTES] = { 0x01 };
+            freq_to_bcd(channel.tx_frequency, payload + 1, CIV_FREQ_BYTES);
+            if (!encode(out, CivCommand::UNSELECTED_FREQ, payload, sizeof(payload))) return false;
+        }
+        uint8_t on = split ? 0x01 : 0x00;
+        if (encode(out, CivCommand::SPLIT, &on, 1)) return true;
+        out.truncate(before);
+        return false;
+    }
+
+    /**
+     * @brief Antenna select (0x12), antenna 1 = 0x00
+     */
+    template <size_t N>
+    bool encode_antenna(CivBuffer<N>& out, int antenna) const {
+        uint8_t index = static_cast<uint8_t>(antenna < 1 ? 0 : (antenna > 4 ? 3 : antenna - 1));
+        return encode(out, CivCommand::ANTENNA, &index, 1);
+    }
+
+    /**
+     * @brief RF power (0x14 0x0A), 0-100 % scaled to 0000-0255 BCD
+     */
+    template <size_t N>
+    bool encode_power(CivBuffer<N>& out, int percent) const {
+        int clamped = percent < 0 ? 0 : (percent > 100 ? 100 : percent);
+        int level = (clamped * 255 + 50) / 100;
+        const uint8_t payload[3] = { 0x0A, to_bcd_byte(level / 100), to_bcd_byte(level % 100) };
+        return encode(out, CivCommand::LEVEL, payload, 3);
+    }
+
+    /**
+     * @brief Attenuator (0x11), dB as one BCD byte (0x00 = off)
+     */
+    template <size_t N>
+    bool encode_attenuation(CivBuffer<N>& out, int db) const {
+        uint8_t bcd = to_bcd_byte(db < 0 ? 0 : (db > 99 ? 99 : db));
+        return encode(out, CivCommand::ATTENUATOR, &bcd, 1);
+    }
+
+    /**
+     * @brief The given RadioStateField bits of a channel, back to back
+     *
+     * All or nothing, like encode_channel.
+     */
+    template <size_t N>
+    bool encode_state(CivBuffer<N>& out, const Channel& channel, uint8_t fields) const {
+        size_t before = out.size();
+        bool ok = true;
+        if (ok && (fields & RadioStateField::FREQUENCY)) ok = encode_freq(out, channel.rx_frequency);
+        if (ok && (fields & RadioStateField::MODE)) ok = encode_mode(out, channel.rx_mode);
+        if (ok && (fields & RadioStateField::SPLIT)) ok = encode_split(out, channel);
+        if (ok && (fields & RadioStateField::ANTENNA)) ok = encode_antenna(out, channel.antenna);
+        if (ok && (fields & RadioStateField::POWER)) ok = encode_power(out, channel.power);
+        if (ok && (fields & RadioStateField::ATTENUATION)) ok = encode_attenuation(out, channel.attenuation);
+        if (!ok) out.truncate(before);
+        return ok;
+    }
+
+    // BCD helpers: CI-V frequencies are BCD, least significant byte first
+    // (14.250.000 Hz -> 00 00 25 14 00)
+
+    static void freq_to_bcd(uint32_t freq_hz, uint8_t* bcd, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            uint8_t lo = freq_hz % 10;
+            freq_hz /= 10;
+            uint8_t hi = freq_hz % 10;
+            freq_hz /= 10;
+            bcd[i] = static_cast<uint8_t>((hi << 4) | lo);
+        }
+    }
+
+    static uint8_t to_bcd_byte(int value) {
+        return static_cast<uint8_t>(((value / 10) % 10) << 4 | (value % 10));
+    }
+
+    static uint32_t bcd_to_freq(const uint8_t* bcd, size_t len) {
+        uint32_t freq = 0;
+        uint32_t mult = 1;
+        for (size_t i = 0; i < len; i++) {
+            freq += (bcd[i] & 0x0F) * mult;
+            mult *= 10;
+            freq += ((bcd[i] >> 4) & 0x0F) * mult;
+            mult *= 10;
+        }
+        return freq;
+    }
+
+    static CivMode radio_mode_to_civ(RadioMode mode) {
+        switch (mode) {
+            case RadioMode::LSB:      return CivMode::LSB;
+            case RadioMode::USB:      return CivMode::USB;
+            case RadioMode::AM:       return CivMode::AM;
+            case RadioMode::CW:       return CivMode::CW;
+            case RadioMode::RTTY:     return CivMode::RTTY;
+            case RadioMode::FM:       return CivMode::FM;
+            case RadioMode::CW_R:     return CivMode::CW_R;
+            case RadioMode::FSK:      return CivMode::RTTY;
+            case RadioMode::FSK_R:    return CivMode::RTTY_R;
+            case RadioMode::DATA_LSB: return CivMode::LSB;  // Some radios have DATA modes
+            case RadioMode::DATA_USB: return CivMode::USB;
+            default:                  return CivMode::USB;
+        }
+    }
+
+    static RadioMode civ_to_radio_mode(CivMode mode) {
+        switch (mode) {
+            case CivMode::LSB:    return RadioMode::LSB;
+            case CivMode::USB:    return RadioMode::USB;
+            case CivMode::AM:     return RadioMode::AM;
+            case CivMode::CW:     return RadioMode::CW;
+            case CivMode::RTTY:   return RadioMode::RTTY;
+            case CivMode::FM:     return RadioMode::FM;
+            case CivMode::CW_R:   return RadioMode::CW_R;
+            case CivMode::RTTY_R: return RadioMode::FSK_R;
+            default:              return RadioMode::USB;
+        }
+    }
+
+private:
+    uint8_t radio_addr_;
+    uint8_t controller_addr_;
+};
+
+} // namespace pal
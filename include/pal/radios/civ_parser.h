@@ -0,0 +1,135 @@
+/**
+ * @file civ_parser.h
+ * @brief Fixed-buffer CI-V receive state machine
+ *
+ * Bytes are fed in whatever chunks the serial port delivers. The parser
+ * syncs on FE FE, keeps at most CIV_PARSER_MAX_PAYLOAD payload bytes,
+ * filters by address, drops the echo of our own frames on the one-wire
+ * bus and decodes complete frames through a table indexed by command
+ * byte. Nothing is allocated after construction.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radios/civ_codec.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace pal {
+
+constexpr size_t CIV_PARSER_MAX_PAYLOAD = 32;   ///< Longer frames are dropped
+
+/**
+ * @brief Decoded frame kinds
+ */
+enum class CivMessageType : uint8_t {
+    OTHER,          ///< Valid frame without a decoder (payload only)
+    ACK,            ///< FB
+    NAK,            ///< FA
+    FREQUENCY,      ///< 0x00 transceive / 0x03 read reply
+    MODE,           ///< 0x01 transceive / 0x04 read reply
+    METER,          ///< 0x15 read reply
+};
+
+/**
+ * @brief CI-V meter subcommands (0x15)
+ */
+struct CivMeter {
+    static constexpr uint8_t S_METER = 0x02;
+    static constexpr uint8_t POWER = 0x11;
+    static constexpr uint8_t SWR = 0x12;
+    static constexpr uint8_t ALC = 0x13;
+    static constexpr uint8_t COMP = 0x14;
+    static constexpr uint8_t VD = 0x15;
+    static constexpr uint8_t ID = 0x16;
+};
+
+/**
+ * @brief One decoded frame
+ */
+struct CivMessage {
+    CivMessageType type = CivMessageType::OTHER;
+    uint8_t to = 0;
+    uint8_t from = 0;
+    uint8_t command = 0;
+    bool broadcast = false;         ///< Sent to 0x00 (transceive)
+
+    uint32_t frequency_hz = 0;      ///< FREQUENCY
+    RadioMode mode = RadioMode::UNKNOWN;    ///< MODE
+    uint8_t filter = 0;             ///< MODE: filter 1-3, 0 if not sent
+    uint8_t meter = 0;              ///< METER: CivMeter subcommand
+    uint16_t level = 0;             ///< METER: 0-255
+
+    const uint8_t* payload = nullptr;   ///< Bytes after the command (valid during the handler only)
+    size_t payload_length = 0;
+};
+
+/**
+ * @brief Parser counters
+ */
+struct CivParserStats {
+    uint64_t frames = 0;            ///< Complete, well-formed frames seen
+    uint64_t messages = 0;          ///< Delivered to the handler
+    uint64_t echoes = 0;            ///< Our own frames coming back
+    uint64_t filtered = 0;          ///< For another controller or from another radio
+    uint64_t malformed = 0;         ///< Truncated, bad BCD, jammed (FC) or missing fields
+    uint64_t overflows = 0;         ///< Payload longer than CIV_PARSER_MAX_PAYLOAD
+};
+
+/**
+ * @brief CI-V byte stream to CivMessage
+ *
+ * Accepts frames addressed to the controller or broadcast (0x00), from
+ * the radio address (0 accepts any radio). Not thread-safe.
+ */
+class CivParser {
+public:
+    using MessageHandler = std::function<void(const CivMessage& message)>;
+
+    explicit CivParser(uint8_t radio_addr = 0, uint8_t controller_addr = CIV_CONTROLLER);
+
+    void set_handler(MessageHandler handler) { handler_ = std::move(handler); }
+
+    void set_radio_address(uint8_t addr) { radio_addr_ = addr; }
+    uint8_t get_radio_address() const { return radio_addr_; }
+    void set_controller_address(uint8_t addr) { controller_addr_ = addr; }
+    uint8_t get_controller_address() const { return controller_addr_; }
+
+    /**
+     * @brief Parse received bytes, calling the handler for each accepted frame
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Drop any partial frame
+     */
+    void reset() { state_ = State::HUNT; }
+
+    const CivParserStats& get_stats() const { return stats_; }
+
+private:
+    enum class State : uint8_t { HUNT, PREAMBLE, TO, FROM, COMMAND, DATA, SKIP };
+
+    void dispatch();
+
+    MessageHandler handler_;
+    uint8_t radio_addr_;
+    uint8_t controller_addr_;
+
+    State state_ = State::HUNT;
+    uint8_t to_ = 0;
+    uint8_t from_ = 0;
+    uint8_t command_ = 0;
+    std::array<uint8_t, CIV_PARSER_MAX_PAYLOAD> payload_;
+    size_t payload_size_ = 0;
+
+    CivParserStats stats_;
+};
+
+} // namespace pal
@@ -36,9 +36,6 @@ public:
     // Elecraft-specific commands
     void set_power(int watts);
     void set_antenna(int ant);  // 1 or 2
-    
-private:
-    void send_command(const std::string& cmd);
 };
 
 } // namespace pal
@@ -13,51 +13,16 @@
 #pragma once
 
 #include "pal/radio.h"
+#include "pal/radios/civ_codec.h"
+#include "pal/radios/civ_parser.h"
+#include "pal/radios/radio_state_shadow.h"
 #include "pal/serial.h"
 #include <cstdint>
-#include <vector>
 #include <memory>
 
 namespace pal {
 
-/**
- * @brief CI-V protocol constants
- */
-constexpr uint8_t CIV_PREAMBLE = 0xFE;
-constexpr uint8_t CIV_EOM = 0xFD;           // End of message
-constexpr uint8_t CIV_CONTROLLER = 0xE0;    // Default controller address
-constexpr uint8_t CIV_ACK = 0xFB;
-constexpr uint8_t CIV_NAK = 0xFA;
-
-/**
- * @brief CI-V command codes
- */
-enum class CivCommand : uint8_t {
-    SET_FREQ = 0x05,        // Set frequency (BCD)
-    SET_MODE = 0x06,        // Set mode
-    SET_VFO = 0x07,         // Select VFO
-    SET_MEM = 0x08,         // Select memory channel
-    READ_FREQ = 0x03,       // Read frequency
-    READ_MODE = 0x04,       // Read mode
-    PTT = 0x1C,             // PTT control (subcommand 0x00)
-    SPLIT = 0x0F,           // Split operation
-    VFO_EQUAL = 0x07,       // VFO A=B (subcommand 0xA0)
-};
-
-/**
- * @brief CI-V mode codes
- */
-enum class CivMode : uint8_t {
-    LSB = 0x00,
-    USB = 0x01,
-    AM = 0x02,
-    CW = 0x03,
-    RTTY = 0x04,
-    FM = 0x05,
-    CW_R = 0x07,
-    RTTY_R = 0x08,
-    DV = 0x17,
-};
+class CatCommandQueue;
 
 /**
  * @brief Known Icom radio addresses
@@ -98,6 +63,9 @@ public:
     
     ~IcomCiv() override = default;
     
+    IcomCiv(const IcomCiv&) = delete;
+    IcomCiv& operator=(const IcomCiv&) = delete;
+    
     // IRadio interface
     bool initialize() override;
     void shutdown() override;
@@ -110,6 +78,9 @@ public:
     void set_ptt(bool transmit) override;
     bool is_transmitting() const override;
     
+    bool set_channel_async(const Channel& channel, CompletionCallback on_complete) override;
+    bool set_ptt_async(bool transmit, CompletionCallback on_complete) override;
+    
     bool is_ready() const override;
     std::string get_port_config() const override;
     
@@ -117,29 +88,62 @@ public:
     void register_ack_callback(AckCallback callback) override;
     void process_response(const uint8_t* data, size_t length) override;
     
+    size_t encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const override;
+    uint32_t encoding_generation() const override { return encoding_generation_; }
+    bool send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) override;
+    
     // CI-V specific
-    void set_radio_address(uint8_t addr) { radio_addr_ = addr; }
-    uint8_t get_radio_address() const { return radio_addr_; }
+    /**
+     * @brief Send through a CatCommandQueue instead of writing directly
+     *
+     * With a queue the async variants complete on the radio's FB/FA;
+     * without one they complete at once. nullptr detaches. The radio must
+     * outlive commands still in the queue.
+     */
+    void set_command_queue(CatCommandQueue* queue) { queue_ = queue; }
     
-private:
-    // Build CI-V frame
-    std::vector<uint8_t> build_frame(CivCommand cmd, const uint8_t* data = nullptr, size_t len = 0);
-    std::vector<uint8_t> build_frame(CivCommand cmd, uint8_t subcmd, const uint8_t* data = nullptr, size_t len = 0);
+    void set_radio_address(uint8_t addr) {
+        codec_.set_radio_address(addr);
+        parser_.set_radio_address(addr);
+        shadow_.invalidate();       // Nothing is known about the new radio
+        encoding_generation_++;
+    }
+    uint8_t get_radio_address() const { return codec_.get_radio_address(); }
+    
+    /**
+     * @brief Encoder for this radio's address, for callers building their own batches
+     */
+    const CivCodec& codec() const { return codec_; }
     
-    // Send frame via serial
-    void send_frame(const std::vector<uint8_t>& frame);
+    /**
+     * @brief Fields set_channel sends when they change (RadioStateField bits)
+     *
+     * Defaults to frequency and mode. Split, antenna, power and attenuation
+     * are opt-in so the radio's own settings aren't overridden by defaults.
+     */
+    void set_managed_fields(uint8_t fields) { shadow_.set_managed(fields); encoding_generation_++; }
+    const RadioStateShadow& state_shadow() const { return shadow_; }
+    
+    /**
+     * @brief Called with every frame from this radio (frequency and mode
+     *        changes, meter readings, ACK/NAK) after the radio has handled it
+     */
+    void set_message_callback(CivParser::MessageHandler callback) { message_callback_ = std::move(callback); }
+    const CivParserStats& parser_stats() const { return parser_.get_stats(); }
     
-    // Frequency encoding (BCD)
-    static void freq_to_bcd(uint32_t freq_hz, uint8_t* bcd, size_t len);
-    static uint32_t bcd_to_freq(const uint8_t* bcd, size_t len);
+private:
+    void handle_message(const CivMessage& message);
     
-    // Mode conversion
-    static CivMode radio_mode_to_civ(RadioMode mode);
-    static RadioMode civ_to_radio_mode(CivMode mode);
+    // Send encoded frames in one write
+    template <size_t N>
+    void send(const CivBuffer<N>& frames) { send_bytes(frames.data(), frames.size()); }
+    void send_bytes(const uint8_t* data, size_t length);
     
     ISerial* serial_;
-    uint8_t radio_addr_;
-    uint8_t controller_addr_ = CIV_CONTROLLER;
+    CatCommandQueue* queue_ = nullptr;
+    CivCodec codec_;
+    RadioStateShadow shadow_;
+    uint32_t encoding_generation_ = 0;
     
     Channel current_channel_;
     bool transmitting_ = false;
@@ -147,9 +151,10 @@ private:
     
     SendCommandCallback send_callback_;
     AckCallback ack_callback_;
+    CivParser::MessageHandler message_callback_;
     
-    // Response buffer for parsing
-    std::vector<uint8_t> rx_buffer_;
+    // Received frames, filtered to this radio
+    CivParser parser_;
 };
 
 } // namespace pal
@@ -18,26 +18,16 @@
 #pragma once
 
 #include "pal/radio.h"
+#include "pal/radios/kenwood_codec.h"
+#include "pal/radios/kenwood_parser.h"
+#include "pal/radios/radio_state_shadow.h"
 #include "pal/serial.h"
 #include <cstdint>
 #include <string>
-#include <vector>
 
 namespace pal {
 
-/**
- * @brief Kenwood mode codes
- */
-enum class KenwoodMode : uint8_t {
-    LSB = 1,
-    USB = 2,
-    CW = 3,
-    FM = 4,
-    AM = 5,
-    FSK = 6,
-    CW_R = 7,
-    FSK_R = 9,
-};
+class CatCommandQueue;
 
 /**
  * @brief Kenwood CAT radio implementation
@@ -52,6 +42,9 @@ public:
     
     ~Kenwood() override = default;
     
+    Kenwood(const Kenwood&) = delete;
+    Kenwood& operator=(const Kenwood&) = delete;
+    
     // IRadio interface
     bool initialize() override;
     void shutdown() override;
@@ -64,6 +57,9 @@ public:
     void set_ptt(bool transmit) override;
     bool is_transmitting() const override;
     
+    bool set_channel_async(const Channel& channel, CompletionCallback on_complete) override;
+    bool set_ptt_async(bool transmit, CompletionCallback on_complete) override;
+    
     bool is_ready() const override;
     std::string get_port_config() const override;
     
@@ -71,33 +67,73 @@ public:
     void register_ack_callback(AckCallback callback) override;
     void process_response(const uint8_t* data, size_t length) override;
     
-protected:
-    // Send ASCII command with semicolon terminator
-    void send_command(const std::string& cmd);
+    size_t encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const override;
+    uint32_t encoding_generation() const override { return encoding_generation_; }
+    bool send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) override;
     
-private:
+    /**
+     * @brief Send through a CatCommandQueue instead of writing directly
+     *
+     * With a queue the async variants complete on an IF; readback that
+     * shows the new frequency/mode or TX state; without one they complete
+     * at once. nullptr detaches. The radio must outlive commands still in
+     * the queue.
+     */
+    void set_command_queue(CatCommandQueue* queue) { queue_ = queue; }
+    
+    /**
+     * @brief Fields set_channel sends when they change (RadioStateField bits)
+     *
+     * Defaults to frequency and mode. Split, antenna, power and attenuation
+     * are opt-in so the radio's own settings aren't overridden by defaults.
+     */
+    void set_managed_fields(uint8_t fields) { shadow_.set_managed(fields); encoding_generation_++; }
+    const RadioStateShadow& state_shadow() const { return shadow_; }
+    
+    /**
+     * @brief Have the radio report frequency, mode and TX changes unasked
+     *
+     * Sends AI<level>; now (if initialized) and again on every start().
+     * Changes made from the front panel then re-sync the state shadow and
+     * reach the message callback without polling.
+     * @param level KenwoodAutoInfo value (AI0-AI4)
+     */
+    bool set_auto_info(uint8_t level);
+    uint8_t get_auto_info() const { return auto_info_; }
     
-    // Build frequency command: FA00014250000;
-    std::string build_freq_command(char vfo, uint32_t freq_hz);
+    /**
+     * @brief Called with every answer from the radio after it has been handled
+     */
+    void set_message_callback(KenwoodParser::MessageHandler callback) { message_callback_ = std::move(callback); }
+    const KenwoodParserStats& parser_stats() const { return parser_.get_stats(); }
     
-    // Build mode command: MD2;
-    std::string build_mode_command(RadioMode mode);
+protected:
+    // Send encoded commands in one write
+    template <size_t N>
+    void send(const KenwoodBuffer<N>& commands) { send_bytes(commands.data(), commands.size()); }
+    void send_bytes(const uint8_t* data, size_t length);
     
-    // Mode conversion
-    static KenwoodMode radio_mode_to_kenwood(RadioMode mode);
-    static RadioMode kenwood_to_radio_mode(KenwoodMode mode);
+    // Commands sent outside set_channel make these fields unknown
+    void forget_state(uint8_t fields) { shadow_.invalidate(fields); }
+    
+private:
+    void handle_message(const KenwoodMessage& message);
     
     ISerial* serial_;
+    CatCommandQueue* queue_ = nullptr;
+    RadioStateShadow shadow_;
+    uint32_t encoding_generation_ = 0;
     
     Channel current_channel_;
     bool transmitting_ = false;
     bool ready_ = false;
+    uint8_t auto_info_ = KenwoodAutoInfo::OFF;
     
     SendCommandCallback send_callback_;
     AckCallback ack_callback_;
+    KenwoodParser::MessageHandler message_callback_;
     
-    // Response buffer for parsing
-    std::string rx_buffer_;
+    KenwoodParser parser_;
 };
 
 } // namespace pal
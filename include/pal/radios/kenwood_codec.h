@@ -0,0 +1,279 @@
+/**
+ * @file kenwood_codec.h
+ * @brief Allocation-free Kenwood/Elecraft ASCII command encoder
+ *
+ * Numeric fields are written with a two-digit lookup table instead of
+ * snprintf, fixed commands are compile-time literals, and everything goes
+ * into fixed-capacity buffers on the stack. Commands can be packed back
+ * to back ("FA00014250000;MD2;") and sent in one write, which is what a
+ * fast-scan loop retuning several times a second wants. Header-only.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radio.h"
+#include "pal/radios/radio_state_shadow.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pal {
+
+/**
+ * @brief Kenwood mode codes
+ */
+enum class KenwoodMode : uint8_t {
+    LSB = 1,
+    USB = 2,
+    CW = 3,
+    FM = 4,
+    AM = 5,
+    FSK = 6,
+    CW_R = 7,
+    FSK_R = 9,
+};
+
+constexpr size_t KENWOOD_FREQ_DIGITS = 11;      ///< FA/FB field width, Hz
+constexpr size_t KENWOOD_MAX_COMMAND = 16;      ///< Longest encoded command ("FA" + 11 digits + ";")
+
+/**
+ * @brief Fixed Kenwood commands
+ */
+namespace kenwood_cmd {
+constexpr char TX[] = "TX;";
+constexpr char RX[] = "RX;";
+constexpr char SPLIT_ON[] = "FT1;";     ///< Transmit on VFO B
+constexpr char SPLIT_OFF[] = "FT0;";
+constexpr char READ_FREQ_A[] = "FA;";
+constexpr char READ_MODE[] = "MD;";
+constexpr char READ_INFO[] = "IF;";
+} // namespace kenwood_cmd
+
+/**
+ * @brief "00" "01" ... "99", two characters per value
+ */
+inline constexpr char KENWOOD_DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * @brief Fixed-capacity buffer holding one or more ASCII commands
+ *
+ * Appends either fit whole or leave the buffer unchanged.
+ */
+template <size_t Capacity>
+class KenwoodBuffer {
+public:
+    static constexpr size_t CAPACITY = Capacity;
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(chars_.data()); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear() { size_ = 0; }
+    void truncate(size_t size) { if (size < size_) size_ = size; }
+
+    bool append(const char* text, size_t len) {
+        if (size_ + len > Capacity) return false;
+        std::memcpy(chars_.data() + size_, text, len);
+        size_ += len;
+        return true;
+    }
+
+    /**
+     * @brief Append a string literal without its terminating NUL
+     */
+    template <size_t N>
+    bool append(const char (&literal)[N]) { return append(literal, N - 1); }
+
+    /**
+     * @brief Reserve len characters at the end for the caller to fill
+     * @return Pointer to them, nullptr if they don't fit
+     */
+    char* extend(size_t len) {
+        if (size_ + len > Capacity) return nullptr;
+        char* p = chars_.data() + size_;
+        size_ += len;
+        return p;
+    }
+
+private:
+    std::array<char, Capacity> chars_;
+    size_t size_ = 0;
+};
+
+using KenwoodCommandBuffer = KenwoodBuffer<KENWOOD_MAX_COMMAND>;   ///< One command
+using KenwoodChannelBuffer = KenwoodBuffer<2 * KENWOOD_MAX_COMMAND>; ///< Frequency + mode
+using KenwoodStateBuffer = KenwoodBuffer<4 * KENWOOD_MAX_COMMAND>;   ///< Every RadioStateField
+
+/**
+ * @brief Kenwood/Elecraft command encoder
+ *
+ * The encode_* functions append to any KenwoodBuffer and return false
+ * (buffer unchanged) if it is full.
+ */
+class KenwoodCodec {
+public:
+    /**
+     * @brief Zero-padded decimal, exactly width digits (upper digits dropped)
+     */
+    static void write_digits(char* out, uint32_t value, size_t width) {
+        char* p = out + width;
+        while (p - out >= 2) {
+            p -= 2;
+            std::memcpy(p, &KENWOOD_DIGIT_PAIRS[2 * (value % 100)], 2);
+            value /= 100;
+        }
+        if (p != out) *--p = static_cast<char>('0' + value % 10);
+    }
+
+    /**
+     * @brief Set VFO frequency: FA00014250000; (vfo 'A' or 'B')
+     */
+    template <size_t N>
+    static bool encode_freq(KenwoodBuffer<N>& out, char vfo, uint32_t freq_hz) {
+        char* p = out.extend(3 + KENWOOD_FREQ_DIGITS);
+        if (!p) return false;
+        p[0] = 'F';
+        p[1] = vfo;
+        write_digits(p + 2, freq_hz, KENWOOD_FREQ_DIGITS);
+        p[2 + KENWOOD_FREQ_DIGITS] = ';';
+        return true;
+    }
+
+    /**
+     * @brief Set mode: MD2;
+     */
+    template <size_t N>
+    static bool encode_mode(KenwoodBuffer<N>& out, RadioMode mode) {
+        char* p = out.extend(4);
+        if (!p) return false;
+        p[0] = 'M';
+        p[1] = 'D';
+        p[2] = static_cast<char>('0' + static_cast<int>(radio_mode_to_kenwood(mode)));
+        p[3] = ';';
+        return true;
+    }
+
+    template <size_t N>
+    static bool encode_ptt(KenwoodBuffer<N>& out, bool transmit) {
+        return transmit ? out.append(kenwood_cmd::TX) : out.append(kenwood_cmd::RX);
+    }
+
+    /**
+     * @brief Auto information level: AI0; (off) AI2; AI4;
+     */
+    template <size_t N>
+    static bool encode_auto_info(KenwoodBuffer<N>& out, uint8_t level) {
+        return encode_number(out, "AI", level > 9 ? 9 : level, 1);
+    }
+
+    /**
+     * @brief Two letters followed by a zero-padded number: PC050; AN1;
+     */
+    template <size_t N>
+    static bool encode_number(KenwoodBuffer<N>& out, const char (&code)[3], uint32_t value, size_t width) {
+        char* p = out.extend(3 + width);
+        if (!p) return false;
+        p[0] = code[0];
+        p[1] = code[1];
+        write_digits(p + 2, value, width);
+        p[2 + width] = ';';
+        return true;
+    }
+
+    /**
+     * @brief RX frequency on VFO A and mode, back to back (all or nothing)
+     */
+    template <size_t N>
+    static bool encode_channel(KenwoodBuffer<N>& out, const Channel& channel) {
+        size_t before = out.size();
+        if (encode_freq(out, 'A', channel.rx_frequency) && encode_mode(out, channel.rx_mode)) return true;
+        out.truncate(before);
+        return false;
+    }
+
+    /**
+     * @brief Split off (FT0;), or TX frequency on VFO B and split on (FB...;FT1;)
+     */
+    template <size_t N>
+    static bool encode_split(KenwoodBuffer<N>& out, const Channel& channel) {
+        if (!RadioStateShadow::is_split(channel)) return out.append(kenwood_cmd::SPLIT_OFF);
+        size_t before = out.size();
+        if (encode_freq(out, 'B', channel.tx_frequency) && out.append(kenwood_cmd::SPLIT_ON)) return true;
+        out.truncate(before);
+        return false;
+    }
+
+    /**
+     * @brief The given RadioStateField bits of a channel, back to back
+     *
+     * Antenna AN#;, power PC###; (percent), attenuator RA00;/RA01;.
+     * All or nothing, like encode_channel.
+     */
+    template <size_t N>
+    static bool encode_state(KenwoodBuffer<N>& out, const Channel& channel, uint8_t fields) {
+        size_t before = out.size();
+        bool ok = true;
+        if (ok && (fields & RadioStateField::FREQUENCY)) ok = encode_freq(out, 'A', channel.rx_frequency);
+        if (ok && (fields & RadioStateField::MODE)) ok = encode_mode(out, channel.rx_mode);
+        if (ok && (fields & RadioStateField::SPLIT)) ok = encode_split(out, channel);
+        if (ok && (fields & RadioStateField::ANTENNA)) {
+            ok = encode_number(out, "AN", static_cast<uint32_t>(channel.antenna < 0 ? 0 : channel.antenna), 1);
+        }
+        if (ok && (fields & RadioStateField::POWER)) {
+            int power = channel.power < 0 ? 0 : (channel.power > 100 ? 100 : channel.power);
+            ok = encode_number(out, "PC", static_cast<uint32_t>(power), 3);
+        }
+        if (ok && (fields & RadioStateField::ATTENUATION)) {
+            ok = encode_number(out, "RA", channel.attenuation > 0 ? 1 : 0, 2);
+        }
+        if (!ok) out.truncate(before);
+        return ok;
+    }
+
+    static KenwoodMode radio_mode_to_kenwood(RadioMode mode) {
+        switch (mode) {
+            case RadioMode::LSB:      return KenwoodMode::LSB;
+            case RadioMode::USB:      return KenwoodMode::USB;
+            case RadioMode::CW:       return KenwoodMode::CW;
+            case RadioMode::FM:       return KenwoodMode::FM;
+            case RadioMode::AM:       return KenwoodMode::AM;
+            case RadioMode::FSK:      return KenwoodMode::FSK;
+            case RadioMode::RTTY:     return KenwoodMode::FSK;
+            case RadioMode::CW_R:     return KenwoodMode::CW_R;
+            case RadioMode::FSK_R:    return KenwoodMode::FSK_R;
+            case RadioMode::DATA_USB: return KenwoodMode::USB;
+            case RadioMode::DATA_LSB: return KenwoodMode::LSB;
+            default:                  return KenwoodMode::USB;
+        }
+    }
+
+    static RadioMode kenwood_to_radio_mode(KenwoodMode mode) {
+        switch (mode) {
+            case KenwoodMode::LSB:   return RadioMode::LSB;
+            case KenwoodMode::USB:   return RadioMode::USB;
+            case KenwoodMode::CW:    return RadioMode::CW;
+            case KenwoodMode::FM:    return RadioMode::FM;
+            case KenwoodMode::AM:    return RadioMode::AM;
+            case KenwoodMode::FSK:   return RadioMode::FSK;
+            case KenwoodMode::CW_R:  return RadioMode::CW_R;
+            case KenwoodMode::FSK_R: return RadioMode::FSK_R;
+            default:                 return RadioMode::USB;
+        }
+    }
+};
+
+} // namespace pal
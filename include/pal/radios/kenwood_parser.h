@@ -0,0 +1,135 @@
+/**
+ * @file kenwood_parser.h
+ * @brief Kenwood/Elecraft answer parser
+ *
+ * Answers are split on ';' and decoded straight from the received bytes;
+ * only an answer split across two reads is copied, into a fixed buffer.
+ * The two-letter code selects the decoder (one switch on both characters):
+ *
+ *   FA/FB  frequency        FA00014250000;
+ *   MD     mode             MD2;
+ *   IF     status           IF00014250000     +00000000002000000 ;
+ *   SM     S-meter          SM00015; (Kenwood) / SM0015; (Elecraft)
+ *   TX/RX  transmit state   TX0; RX;
+ *   ?/E/O  command refused  ?;
+ *
+ * With auto information on (AI2/AI4) the radio sends these unasked
+ * whenever its state changes, so nothing has to be polled.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radios/kenwood_codec.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace pal {
+
+constexpr size_t KENWOOD_PARSER_MAX_ANSWER = 64;    ///< Longer answers are dropped
+
+/**
+ * @brief Decoded answer kinds
+ */
+enum class KenwoodMessageType : uint8_t {
+    OTHER,          ///< Well-formed answer without a decoder (text only)
+    ERROR,          ///< "?;", "E;" or "O;"
+    FREQUENCY,      ///< FA/FB
+    MODE,           ///< MD
+    INFO,           ///< IF: frequency, mode and TX state
+    METER,          ///< SM
+    TRANSMIT,       ///< TX/RX
+};
+
+/**
+ * @brief Auto information levels (AI command)
+ */
+struct KenwoodAutoInfo {
+    static constexpr uint8_t OFF = 0;
+    static constexpr uint8_t ON = 2;        ///< Until power off
+    static constexpr uint8_t ON_SAVED = 4;  ///< Kept across power cycles (Kenwood)
+};
+
+/**
+ * @brief One decoded answer
+ */
+struct KenwoodMessage {
+    KenwoodMessageType type = KenwoodMessageType::OTHER;
+    char code[2] = {0, 0};          ///< Two-letter command ('?', 'E' or 'O' and 0 for errors)
+
+    char vfo = 0;                   ///< FREQUENCY: 'A' or 'B'
+    uint32_t frequency_hz = 0;      ///< FREQUENCY, INFO
+    RadioMode mode = RadioMode::UNKNOWN;    ///< MODE, INFO
+    bool transmitting = false;      ///< TRANSMIT, INFO
+    uint8_t meter = 0;              ///< METER: main (0) or sub (1) receiver
+    uint16_t level = 0;             ///< METER: radio units (0-30 Kenwood, 0-21 Elecraft)
+
+    const char* text = nullptr;     ///< Whole answer including ';' (valid during the handler only)
+    size_t length = 0;
+};
+
+/**
+ * @brief Parser counters
+ */
+struct KenwoodParserStats {
+    uint64_t answers = 0;           ///< ';'-terminated answers seen
+    uint64_t messages = 0;          ///< Delivered to the handler
+    uint64_t malformed = 0;         ///< Known code with a bad field
+    uint64_t overflows = 0;         ///< Longer than KENWOOD_PARSER_MAX_ANSWER
+    uint64_t copied = 0;            ///< Answers that had to be reassembled
+};
+
+/**
+ * @brief Kenwood/Elecraft byte stream to KenwoodMessage
+ *
+ * Not thread-safe.
+ */
+class KenwoodParser {
+public:
+    using MessageHandler = std::function<void(const KenwoodMessage& message)>;
+
+    KenwoodParser() = default;
+
+    void set_handler(MessageHandler handler) { handler_ = std::move(handler); }
+
+    /**
+     * @brief Parse received bytes, calling the handler for each answer
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Drop any partial answer
+     */
+    void reset() { size_ = 0; discarding_ = false; }
+
+    /**
+     * @brief Decode one complete answer (including ';')
+     * @return false if it is not a well-formed answer
+     */
+    static bool decode(const uint8_t* answer, size_t length, KenwoodMessage& message);
+
+    static constexpr uint16_t code(char first, char second) {
+        return static_cast<uint16_t>(static_cast<uint8_t>(first) << 8 | static_cast<uint8_t>(second));
+    }
+
+    const KenwoodParserStats& get_stats() const { return stats_; }
+
+private:
+    void deliver(const uint8_t* answer, size_t length);
+
+    MessageHandler handler_;
+
+    // Start of an answer not yet terminated
+    std::array<uint8_t, KENWOOD_PARSER_MAX_ANSWER> buffer_;
+    size_t size_ = 0;
+    bool discarding_ = false;       // Rest of an overlong answer
+
+    KenwoodParserStats stats_;
+};
+
+} // namespace pal
@@ -0,0 +1,95 @@
+/**
+ * @file radio_state_shadow.h
+ * @brief Shadow of the radio state last sent over CAT
+ *
+ * set_channel() compares the requested channel with what the radio was
+ * last told and sends only the fields that differ. Scanning channels that
+ * share a mode then costs one frequency command per hop instead of two.
+ * The shadow is optimistic: a field counts as known once it was sent, and
+ * the radio drivers invalidate it on (re)connect, when the radio NAKs, or
+ * when a command sent through a CatCommandQueue finishes other than OK.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radio.h"
+#include <cstdint>
+
+namespace pal {
+
+/**
+ * @brief Channel fields tracked by RadioStateShadow (bit mask)
+ */
+struct RadioStateField {
+    static constexpr uint8_t FREQUENCY = 0x01;    ///< RX frequency
+    static constexpr uint8_t MODE = 0x02;         ///< RX mode
+    static constexpr uint8_t SPLIT = 0x04;        ///< Split on/off and TX frequency while split
+    static constexpr uint8_t ANTENNA = 0x08;
+    static constexpr uint8_t POWER = 0x10;
+    static constexpr uint8_t ATTENUATION = 0x20;
+
+    static constexpr uint8_t NONE = 0x00;
+    static constexpr uint8_t ALL = 0x3F;
+    static constexpr uint8_t DEFAULT = FREQUENCY | MODE;   ///< What set_channel always sent
+};
+
+/**
+ * @brief Last radio state sent, per field
+ */
+class RadioStateShadow {
+public:
+    /**
+     * @param supported Fields the protocol can set
+     * @param managed Fields set_channel sends (masked by supported)
+     */
+    explicit RadioStateShadow(uint8_t supported = RadioStateField::ALL,
+                              uint8_t managed = RadioStateField::DEFAULT);
+
+    void set_managed(uint8_t fields) { managed_ = fields & supported_; }
+    uint8_t managed() const { return managed_; }
+    uint8_t supported() const { return supported_; }
+
+    /**
+     * @brief Managed fields that are unknown or differ from target
+     */
+    uint8_t changed(const Channel& target) const;
+
+    /**
+     * @brief Record that fields of target were sent
+     */
+    void commit(const Channel& target, uint8_t fields);
+
+    /**
+     * @brief Forget fields so the next set_channel sends them again
+     */
+    void invalidate(uint8_t fields = RadioStateField::ALL) { known_ &= static_cast<uint8_t>(~fields); }
+
+    uint8_t known() const { return known_; }
+    const Channel& state() const { return state_; }   ///< RX frequency/mode, antenna, power, attenuation
+    bool split() const { return split_; }
+    uint32_t split_tx_frequency() const { return split_tx_frequency_; }
+
+    uint64_t fields_sent() const { return fields_sent_; }
+    uint64_t fields_suppressed() const { return fields_suppressed_; }
+
+    static bool is_split(const Channel& channel) { return channel.tx_frequency != channel.rx_frequency; }
+
+private:
+    bool same(const Channel& target, uint8_t field) const;
+
+    Channel state_;
+    bool split_ = false;
+    uint32_t split_tx_frequency_ = 0;
+    uint8_t supported_;
+    uint8_t managed_;
+    uint8_t known_ = RadioStateField::NONE;
+
+    uint64_t fields_sent_ = 0;
+    uint64_t fields_suppressed_ = 0;
+};
+
+} // namespace pal
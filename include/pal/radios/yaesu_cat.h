@@ -15,57 +15,26 @@
 #pragma once
 
 #include "pal/radio.h"
+#include "pal/radios/radio_state_shadow.h"
+#include "pal/radios/yaesu_parser.h"
 #include "pal/serial.h"
 #include <cstdint>
+#include <functional>
 #include <vector>
 
 namespace pal {
 
-/**
- * @brief Yaesu CAT command codes
- */
-enum class YaesuCommand : uint8_t {
-    SET_FREQ = 0x01,        // Set frequency
-    SPLIT_ON = 0x02,        // Split on
-    SPLIT_OFF = 0x82,       // Split off
-    READ_FREQ = 0x03,       // Read frequency/mode
-    SET_MODE = 0x07,        // Set mode
-    PTT_ON = 0x08,          // PTT on
-    PTT_OFF = 0x88,         // PTT off
-    READ_RX_STATUS = 0xE7,  // Read RX status
-    READ_TX_STATUS = 0xF7,  // Read TX status
-    LOCK_ON = 0x00,         // Lock on
-    LOCK_OFF = 0x80,        // Lock off
-    CLAR_ON = 0x05,         // Clarifier on
-    CLAR_OFF = 0x85,        // Clarifier off
-    VFO_A = 0x81,           // Select VFO A
-    VFO_B = 0x81,           // Select VFO B (with param)
-    POWER_ON = 0x0F,        // Power on
-    POWER_OFF = 0x8F,       // Power off
-};
+class CatCommandQueue;
 
-/**
- * @brief Yaesu mode codes
- */
-enum class YaesuMode : uint8_t {
-    LSB = 0x00,
-    USB = 0x01,
-    CW = 0x02,
-    CW_R = 0x03,
-    AM = 0x04,
-    FM = 0x08,
-    DIG = 0x0A,
-    PKT = 0x0C,
-    FM_N = 0x88,    // FM Narrow
-    DIG_USB = 0x0A, // Digital USB
-    DIG_LSB = 0x0A, // Digital LSB (with filter param)
-};
+constexpr size_t YAESU_MAX_CHANNEL_COMMANDS = 3;   ///< Frequency, mode, split
 
 /**
  * @brief Yaesu CAT radio implementation
  */
 class YaesuCat : public IRadio {
 public:
+    using StatusCallback = std::function<void(const YaesuStatus& status)>;
+    
     /**
      * @brief Constructor
      * @param serial Serial port interface (injected)
@@ -74,6 +43,9 @@ public:
     
     ~YaesuCat() override = default;
     
+    YaesuCat(const YaesuCat&) = delete;
+    YaesuCat& operator=(const YaesuCat&) = delete;
+    
     // IRadio interface
     bool initialize() override;
     void shutdown() override;
@@ -86,6 +58,9 @@ public:
     void set_ptt(bool transmit) override;
     bool is_transmitting() const override;
     
+    bool set_channel_async(const Channel& channel, CompletionCallback on_complete) override;
+    bool set_ptt_async(bool transmit, CompletionCallback on_complete) override;
+    
     bool is_ready() const override;
     std::string get_port_config() const override;
     
@@ -93,24 +68,81 @@ public:
     void register_ack_callback(AckCallback callback) override;
     void process_response(const uint8_t* data, size_t length) override;
     
+    size_t encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const override;
+    uint32_t encoding_generation() const override { return encoding_generation_; }
+    bool send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) override;
+    
+    /**
+     * @brief Send through a CatCommandQueue instead of writing directly
+     *
+     * The 5-byte command set has no acknowledgements, so with a queue the
+     * async variants append a READ_FREQ / READ_TX_STATUS readback and
+     * complete when it shows the new state; without one they complete at
+     * once. nullptr detaches. The radio must outlive commands still in
+     * the queue.
+     *
+     * Without a queue, set_channel and scan-list hops write one command
+     * per write but back to back; FT-817/857/897 need a queue with
+     * pacing_us = YAESU_PACING_US to get the gap between them.
+     */
+    void set_command_queue(CatCommandQueue* queue) { queue_ = queue; }
+    
+    /**
+     * @brief Fields set_channel sends when they change (RadioStateField bits)
+     *
+     * Defaults to frequency and mode. The 5-byte command set can also
+     * switch split (the TX frequency must already be on VFO B); antenna,
+     * power and attenuation are not settable and are ignored.
+     */
+    void set_managed_fields(uint8_t fields) { shadow_.set_managed(fields); encoding_generation_++; }
+    const RadioStateShadow& state_shadow() const { return shadow_; }
+    
+    /**
+     * @brief Ask for frequency/mode, RX status and TX status
+     *
+     * Replies update get_status() and reach the status callback as they
+     * arrive: through the CatCommandQueue's completions if one is attached
+     * (use pacing_us = YAESU_PACING_US), otherwise through
+     * process_response(). A reported frequency or mode that differs from
+     * the last one sent makes set_channel send it again.
+     */
+    bool read_status();
+    
+    const YaesuStatus& get_status() const { return parser_.get_status(); }
+    void set_status_callback(StatusCallback callback) { status_callback_ = std::move(callback); }
+    const YaesuParserStats& parser_stats() const { return parser_.get_stats(); }
+    
 private:
+    void handle_status(YaesuCommand read, const YaesuStatus& status);
+    
     // Build 5-byte CAT command
     std::vector<uint8_t> build_command(YaesuCommand cmd, 
                                         uint8_t p1 = 0, uint8_t p2 = 0, 
                                         uint8_t p3 = 0, uint8_t p4 = 0);
     
+    // 5-byte commands for the given RadioStateField bits; out holds
+    // YAESU_MAX_CHANNEL_COMMANDS commands. Returns bytes written.
+    static size_t encode_fields(const Channel& channel, uint8_t fields, uint8_t* out);
+    
+    // Write one 5-byte command to out
+    static void write_command(uint8_t* out, YaesuCommand cmd,
+                              uint8_t p1 = 0, uint8_t p2 = 0,
+                              uint8_t p3 = 0, uint8_t p4 = 0);
+    
     // Send command via serial
     void send_command(const std::vector<uint8_t>& cmd);
+    void send_bytes(const uint8_t* data, size_t length);
     
-    // Frequency encoding (packed BCD, MSB first)
+    // Frequency encoding (packed BCD, MSB first); decoding is in YaesuParser
     static void freq_to_packed_bcd(uint32_t freq_hz, uint8_t* bcd);
-    static uint32_t packed_bcd_to_freq(const uint8_t* bcd);
     
     // Mode conversion
     static YaesuMode radio_mode_to_yaesu(RadioMode mode);
-    static RadioMode yaesu_to_radio_mode(YaesuMode mode);
     
     ISerial* serial_;
+    CatCommandQueue* queue_ = nullptr;
+    RadioStateShadow shadow_;
+    uint32_t encoding_generation_ = 0;
     
     Channel current_channel_;
     bool transmitting_ = false;
@@ -118,6 +150,10 @@ private:
     
     SendCommandCallback send_callback_;
     AckCallback ack_callback_;
+    StatusCallback status_callback_;
+    
+    // Replies to reads written directly (not through a queue)
+    YaesuParser parser_;
 };
 
 } // namespace pal
@@ -0,0 +1,182 @@
+/**
+ * @file yaesu_parser.h
+ * @brief Yaesu 5-byte CAT reply framing and status decoding
+ *
+ * Replies carry no framing: their length follows from the command that
+ * asked for them, and they come back in order.
+ *
+ *   READ_FREQ (0x03)       5 bytes: frequency (4 packed BCD, 10 Hz), mode
+ *   READ_RX_STATUS (0xE7)  1 byte:  S-meter (bits 0-3), squelched (bit 7)
+ *   READ_TX_STATUS (0xF7)  1 byte:  PO meter (bits 0-3), split off (bit 5),
+ *                                   high SWR (bit 6), not transmitting (bit 7)
+ *
+ * YaesuParser is told which reads were written (on_write) and assigns
+ * received bytes to them. These radios also need a few milliseconds
+ * between commands (YAESU_PACING_US); CatCommandQueue's pacing_us does
+ * that and frames replies from the reply length given to submit().
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radio.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace pal {
+
+/**
+ * @brief Yaesu CAT command codes
+ */
+enum class YaesuCommand : uint8_t {
+    SET_FREQ = 0x01,        // Set frequency
+    SPLIT_ON = 0x02,        // Split on
+    SPLIT_OFF = 0x82,       // Split off
+    READ_FREQ = 0x03,       // Read frequency/mode
+    SET_MODE = 0x07,        // Set mode
+    PTT_ON = 0x08,          // PTT on
+    PTT_OFF = 0x88,         // PTT off
+    READ_RX_STATUS = 0xE7,  // Read RX status
+    READ_TX_STATUS = 0xF7,  // Read TX status
+    LOCK_ON = 0x00,         // Lock on
+    LOCK_OFF = 0x80,        // Lock off
+    CLAR_ON = 0x05,         // Clarifier on
+    CLAR_OFF = 0x85,        // Clarifier off
+    VFO_A = 0x81,           // Select VFO A
+    VFO_B = 0x81,           // Select VFO B (with param)
+    POWER_ON = 0x0F,        // Power on
+    POWER_OFF = 0x8F,       // Power off
+};
+
+/**
+ * @brief Yaesu mode codes
+ */
+enum class YaesuMode : uint8_t {
+    LSB = 0x00,
+    USB = 0x01,
+    CW = 0x02,
+    CW_R = 0x03,
+    AM = 0x04,
+    FM = 0x08,
+    DIG = 0x0A,
+    PKT = 0x0C,
+    FM_N = 0x88,    // FM Narrow
+    DIG_USB = 0x0A, // Digital USB
+    DIG_LSB = 0x0A, // Digital LSB (with filter param)
+};
+
+constexpr size_t YAESU_COMMAND_BYTES = 5;
+constexpr size_t YAESU_MAX_REPLY = 5;           ///< READ_FREQ
+constexpr size_t YAESU_MAX_OUTSTANDING = 8;     ///< Reads awaiting replies
+constexpr uint32_t YAESU_PACING_US = 5000;      ///< Gap FT-817/857/897 need after a command
+
+/**
+ * @brief Radio state from the status reads
+ */
+struct YaesuStatus {
+    // valid bits: which reads have been decoded
+    static constexpr uint8_t FREQUENCY = 0x01;  ///< frequency_hz, mode
+    static constexpr uint8_t RX = 0x02;         ///< s_meter, squelched
+    static constexpr uint8_t TX = 0x04;         ///< transmitting, high_swr, split, power_meter
+
+    uint8_t valid = 0;
+
+    uint32_t frequency_hz = 0;      ///< 10 Hz resolution
+    RadioMode mode = RadioMode::UNKNOWN;
+
+    uint8_t s_meter = 0;            ///< 0-15: S0-S9, then +10 to +60 dB
+    bool squelched = false;
+
+    bool transmitting = false;
+    bool high_swr = false;          ///< Transmitting only
+    bool split = false;             ///< Transmitting only
+    uint8_t power_meter = 0;        ///< 0-15, transmitting only
+};
+
+/**
+ * @brief Parser counters
+ */
+struct YaesuParserStats {
+    uint64_t replies = 0;           ///< Complete replies decoded
+    uint64_t malformed = 0;         ///< Complete but undecodable (bad BCD)
+    uint64_t unexpected = 0;        ///< Bytes with no read waiting for them
+    uint64_t dropped = 0;           ///< Reads forgotten (outstanding list full)
+};
+
+/**
+ * @brief Yaesu reply bytes to YaesuStatus
+ *
+ * Not thread-safe. Call reset() after a reply was lost (e.g. on a
+ * timeout) so later replies are not taken for earlier reads.
+ */
+class YaesuParser {
+public:
+    using StatusHandler = std::function<void(YaesuCommand read, const YaesuStatus& status)>;
+
+    YaesuParser() = default;
+
+    void set_handler(StatusHandler handler) { handler_ = std::move(handler); }
+
+    /**
+     * @brief Reply length for a command opcode (0 if it has none)
+     */
+    static size_t reply_length(YaesuCommand command);
+
+    /**
+     * @brief Commands written to the radio: reads among them expect replies
+     */
+    void on_write(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Bytes received from the radio
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Decode a complete reply to read into the status and report it
+     * @return false if the reply is the wrong length or malformed
+     */
+    bool apply(YaesuCommand read, const uint8_t* reply, size_t length);
+
+    /**
+     * @brief Forget outstanding reads and any partial reply
+     */
+    void reset() { count_ = 0; size_ = 0; }
+
+    size_t outstanding() const { return count_; }
+    const YaesuStatus& get_status() const { return status_; }
+    const YaesuParserStats& get_stats() const { return stats_; }
+
+    /**
+     * @brief Decode one reply into status (other fields are left alone)
+     */
+    static bool decode(YaesuCommand read, const uint8_t* reply, size_t length, YaesuStatus& status);
+
+    // Frequency decoding (packed BCD, MSB first, 10 Hz resolution)
+    static bool packed_bcd_to_freq(const uint8_t* bcd, uint32_t& freq_hz);
+    static uint32_t packed_bcd_to_freq(const uint8_t* bcd);
+
+    static RadioMode yaesu_to_radio_mode(YaesuMode mode);
+
+private:
+    StatusHandler handler_;
+
+    // Reads written and not yet answered, oldest first (ring)
+    std::array<YaesuCommand, YAESU_MAX_OUTSTANDING> expected_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+
+    // Reply to the oldest read so far
+    std::array<uint8_t, YAESU_MAX_REPLY> reply_;
+    size_t size_ = 0;
+
+    YaesuStatus status_;
+    YaesuParserStats stats_;
+};
+
+} // namespace pal
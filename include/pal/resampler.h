@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "pal/sample_format.h"
 #include <vector>
 #include <cstdint>
 #include <cstddef>
@@ -51,6 +52,36 @@ public:
      */
     size_t interpolate(const float* input, size_t input_count, float* output);
     
+    /**
+     * @brief Decimate one channel of interleaved device frames
+     * 
+     * Reads format.radio_channel straight out of the native buffer, so a
+     * driver's native callback needs no float staging buffer.
+     * 
+     * @param input Interleaved frames in format
+     * @param format Frame layout of input
+     * @param input_frames Number of input frames
+     * @param output Output buffer (must hold input_frames/ratio samples)
+     * @return Number of output samples produced
+     */
+    size_t decimate(const void* input, const AudioFormat& format,
+                    size_t input_frames, float* output);
+    
+    /**
+     * @brief Interpolate into one channel of interleaved device frames
+     * 
+     * Writes format.radio_channel (clipped for integer formats); the other
+     * channels of each frame are left untouched.
+     * 
+     * @param input Input samples at low rate
+     * @param input_count Number of input samples
+     * @param output Interleaved frames (must hold input_count*ratio frames)
+     * @param format Frame layout of output
+     * @return Number of output frames produced
+     */
+    size_t interpolate(const float* input, size_t input_count,
+                       void* output, const AudioFormat& format);
+    
     /**
      * @brief Reset filter state (clear history)
      */
@@ -65,6 +96,12 @@ private:
     void design_filter();
     float apply_filter() const;
     
+    template <typename T>
+    size_t decimate_strided(const T* input, size_t stride, size_t count, float* output);
+    
+    template <typename T>
+    size_t interpolate_strided(const float* input, size_t count, T* output, size_t stride);
+    
     int ratio_;
     int taps_per_phase_;
     int total_taps_;
@@ -0,0 +1,123 @@
+/**
+ * @file rt_thread.h
+ * @brief Real-time scheduling, CPU pinning and memory locking for PAL threads
+ *
+ * Audio and serial threads on small multi-core boxes xrun when the
+ * scheduler migrates them or a page fault lands mid-period. An
+ * RtThreadPolicy says what the thread should get; apply_rt_policy() is
+ * called on the thread itself when it starts and reports what the OS
+ * actually granted (unprivileged processes typically get none of the
+ * scheduling part).
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pal {
+
+/**
+ * @brief Scheduling class for a PAL thread
+ */
+enum class RtSchedClass {
+    DEFAULT,    ///< Leave the thread's policy alone
+    OTHER,      ///< Time-sharing (SCHED_OTHER)
+    FIFO,       ///< SCHED_FIFO
+    RR          ///< SCHED_RR
+};
+
+/**
+ * @brief Requested real-time settings for one thread
+ *
+ * The default policy changes nothing.
+ */
+struct RtThreadPolicy {
+    RtSchedClass sched = RtSchedClass::DEFAULT;
+    int priority = 0;                   ///< 1..99 for FIFO/RR
+    std::vector<int> cpus;              ///< CPUs the thread may run on; empty = any
+    bool lock_memory = false;           ///< mlockall(CURRENT | FUTURE), process wide
+    size_t prefault_stack_bytes = 0;    ///< Stack touched up front so it is resident (capped to the free stack)
+    size_t prefault_heap_bytes = 0;     ///< Heap touched and kept (glibc: no trim/mmap)
+
+    /**
+     * @brief FIFO at the given priority, optionally pinned to one CPU
+     */
+    static RtThreadPolicy fifo(int priority, int cpu = -1) {
+        RtThreadPolicy policy;
+        policy.sched = RtSchedClass::FIFO;
+        policy.priority = priority;
+        if (cpu >= 0) policy.cpus.push_back(cpu);
+        return policy;
+    }
+
+    bool is_default() const {
+        return sched == RtSchedClass::DEFAULT && cpus.empty() && !lock_memory &&
+               prefault_stack_bytes == 0 && prefault_heap_bytes == 0;
+    }
+};
+
+/**
+ * @brief What a thread was granted by apply_rt_policy()
+ */
+struct RtThreadStatus {
+    bool applied = false;               ///< apply_rt_policy() has run on the thread
+    bool sched_granted = false;         ///< Requested class and priority are in effect
+    RtSchedClass sched = RtSchedClass::DEFAULT; ///< Class the thread ended up with
+    int priority = 0;                   ///< Priority the thread ended up with
+    bool affinity_granted = false;      ///< Thread is pinned to the requested CPUs
+    int cpu_count = 0;                  ///< CPUs the thread may run on (0 = unknown)
+    bool memory_locked = false;         ///< mlockall() succeeded
+    size_t stack_prefaulted = 0;        ///< Bytes of stack touched
+    size_t heap_prefaulted = 0;         ///< Bytes of heap touched and retained
+
+    /**
+     * @brief True if every part of the policy was granted
+     */
+    bool satisfies(const RtThreadPolicy& policy) const;
+
+    /**
+     * @brief One-line summary for logs, e.g. "FIFO/70 cpus=1 mlock"
+     */
+    std::string describe() const;
+};
+
+/**
+ * @brief Apply policy to the calling thread
+ *
+ * Each part is attempted independently; a refused priority doesn't stop
+ * pinning or locking. Not real-time safe: call once at thread start,
+ * before the processing loop. Parts the platform lacks are reported as
+ * not granted.
+ */
+RtThreadStatus apply_rt_policy(const RtThreadPolicy& policy);
+
+/**
+ * @brief RtThreadStatus shared between the thread that applied it and readers
+ *
+ * Written once per thread start, read from any thread.
+ */
+class RtStatusCell {
+public:
+    void store(const RtThreadStatus& status) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = status;
+    }
+
+    RtThreadStatus load() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return status_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    RtThreadStatus status_;
+};
+
+} // namespace pal
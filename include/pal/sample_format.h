@@ -0,0 +1,107 @@
+/**
+ * @file sample_format.h
+ * @brief PCM sample formats, device frame layout and conversion to/from mono float
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+namespace pal {
+
+/**
+ * @brief Interleaved PCM sample formats (native endian)
+ */
+enum class SampleFormat : uint8_t {
+    S16 = 0,    ///< Signed 16-bit
+    S32 = 1,    ///< Signed 32-bit
+    F32 = 2     ///< 32-bit float, -1.0 to 1.0
+};
+
+/**
+ * @brief Bytes per sample of a format
+ */
+size_t sample_format_bytes(SampleFormat format);
+
+/**
+ * @brief Interleaved frame layout of an audio device
+ */
+struct AudioFormat {
+    SampleFormat format = SampleFormat::F32;
+    uint16_t channels = 1;
+    uint16_t radio_channel = 0;     ///< Channel that carries the radio's audio
+
+    size_t frame_bytes() const { return sample_format_bytes(format) * channels; }
+    bool is_mono_float() const { return format == SampleFormat::F32 && channels == 1; }
+};
+
+inline bool operator==(const AudioFormat& a, const AudioFormat& b) {
+    return a.format == b.format && a.channels == b.channels && a.radio_channel == b.radio_channel;
+}
+
+inline bool operator!=(const AudioFormat& a, const AudioFormat& b) {
+    return !(a == b);
+}
+
+/**
+ * @brief One native sample as float (integer full scale = 1.0)
+ */
+inline float sample_to_float(int16_t s) { return static_cast<float>(s) * (1.0f / 32768.0f); }
+inline float sample_to_float(int32_t s) { return static_cast<float>(s) * (1.0f / 2147483648.0f); }
+inline float sample_to_float(float s) { return s; }
+
+/**
+ * @brief One float as a native sample, clipped to [-1, 1] for integers
+ */
+template <typename T> T float_to_sample(float v);
+
+template <> inline int16_t float_to_sample<int16_t>(float v) {
+    return static_cast<int16_t>(std::lrint(std::min(std::max(v, -1.0f), 1.0f) * 32767.0f));
+}
+
+template <> inline int32_t float_to_sample<int32_t>(float v) {
+    // Scale in double: float can't represent INT32_MAX exactly
+    return static_cast<int32_t>(std::lrint(std::min(std::max(v, -1.0f), 1.0f) * 2147483647.0));
+}
+
+template <> inline float float_to_sample<float>(float v) { return v; }
+
+/**
+ * @brief Extract one channel of interleaved PCM as float
+ *
+ * @param input Interleaved frames
+ * @param format Sample format of input
+ * @param channels Channels per frame
+ * @param channel Channel to extract
+ * @param output Float output, frames samples
+ * @param frames Frame count
+ */
+void convert_to_float(const void* input, SampleFormat format,
+                      size_t channels, size_t channel,
+                      float* output, size_t frames);
+
+/**
+ * @brief Write float samples into one channel of interleaved PCM
+ *
+ * Values are clipped to [-1, 1] for integer formats. Other channels in
+ * the frame are left untouched.
+ *
+ * @param input Float samples
+ * @param frames Frame count
+ * @param output Interleaved frames
+ * @param format Sample format of output
+ * @param channels Channels per frame
+ * @param channel Channel to write
+ */
+void convert_from_float(const float* input, size_t frames,
+                        void* output, SampleFormat format,
+                        size_t channels, size_t channel);
+
+} // namespace pal
@@ -0,0 +1,133 @@
+/**
+ * @file scan_list.h
+ * @brief Pre-encoded scan list for one-write channel hops
+ *
+ * ALE scanning cycles a fixed channel list several times a second. A
+ * ScanList asks the radio to encode every channel once (IRadio::
+ * encode_channel) and keeps the bytes back to back in one buffer, so a
+ * hop is an index lookup and a single serial write. The encoding is
+ * redone automatically when the radio's encoding_generation() changes
+ * (address, managed fields) or the list is bound to another radio.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/radio.h"
+#include "pal/serial.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pal {
+
+constexpr size_t SCAN_MAX_CHANNEL_BYTES = 128;  ///< Encoded bytes one channel may take
+
+/**
+ * @brief Result of one hop
+ */
+struct ScanHop {
+    size_t index = 0;               ///< Channel hopped to
+    size_t bytes = 0;               ///< Bytes written (0 = sent through set_channel)
+    uint32_t wire_time_us = 0;      ///< Time to clock the bytes out at the port framing
+    bool ok = false;
+};
+
+/**
+ * @brief Channel list with the CAT bytes for each channel pre-encoded
+ *
+ * Radios that can't pre-encode (encode_channel returns 0) are hopped
+ * through set_channel() instead. Not thread-safe: use from one thread.
+ */
+class ScanList {
+public:
+    /**
+     * @param radio Radio the channels are encoded for
+     * @param serial CAT port framing, for wire times
+     */
+    ScanList(IRadio& radio, const SerialConfig& serial = SerialConfig());
+
+    void set_channels(const std::vector<Channel>& channels);
+    void add(const Channel& channel);
+    void clear();
+
+    size_t size() const { return channels_.size(); }
+    const Channel& channel(size_t index) const { return channels_[index]; }
+
+    /**
+     * @brief Encode for another radio (protocol change)
+     */
+    void set_radio(IRadio& radio);
+    IRadio& radio() const { return *radio_; }
+
+    void set_serial_config(const SerialConfig& serial);
+
+    /**
+     * @brief Encode every channel now, off the hop path
+     * @return False if the radio can't pre-encode some channel (those hop via set_channel)
+     */
+    bool compile();
+
+    /**
+     * @brief Compiled and still matching the radio's encoding
+     */
+    bool is_compiled() const;
+
+    /**
+     * @brief Change to channel index with one write
+     *
+     * Recompiles first if the encoding went stale.
+     */
+    ScanHop hop(size_t index);
+
+    /**
+     * @brief Hop to the channel after the last one, wrapping around
+     */
+    ScanHop next();
+
+    /**
+     * @brief Pre-encoded bytes of a channel (nullptr/0 if not compiled or not encodable)
+     */
+    const uint8_t* bytes(size_t index) const;
+    size_t length(size_t index) const;
+
+    /**
+     * @brief Wire time of a channel's pre-encoded bytes
+     */
+    uint32_t wire_time_us(size_t index) const;
+
+    const ScanHop& last_hop() const { return last_hop_; }
+
+    /**
+     * @brief Number of times the list has been encoded
+     */
+    uint64_t get_compile_count() const { return compile_count_; }
+
+private:
+    struct Entry {
+        size_t offset;
+        size_t length;              // 0 = hop through set_channel
+        uint32_t wire_time_us;
+    };
+
+    void invalidate() { compiled_ = false; }
+
+    IRadio* radio_;
+    SerialConfig serial_;
+    std::vector<Channel> channels_;
+
+    std::vector<uint8_t> bytes_;    // All channels back to back
+    std::vector<Entry> entries_;
+    bool compiled_ = false;
+    const IRadio* compiled_radio_ = nullptr;
+    uint32_t compiled_generation_ = 0;
+    uint64_t compile_count_ = 0;
+
+    size_t position_ = 0;           // Next channel for next()
+    ScanHop last_hop_;
+};
+
+} // namespace pal
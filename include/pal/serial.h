@@ -49,6 +49,22 @@ struct SerialConfig {
     uint32_t timeout_ms = 1000;     ///< Read timeout
 };
 
+/**
+ * @brief Time to clock bytes out of the UART at the configured framing
+ * 
+ * One start bit, data bits, optional parity bit and stop bits per byte.
+ * 
+ * @return Wire time in microseconds
+ */
+inline uint32_t serial_wire_time_us(const SerialConfig& config, size_t bytes) {
+    if (config.baud_rate == 0) return 0;
+    uint32_t bits_per_byte = 1 + config.data_bits +
+                             (config.parity == Parity::NONE ? 0 : 1) +
+                             (config.stop_bits == StopBits::TWO ? 2 : 1);
+    uint64_t bits = static_cast<uint64_t>(bytes) * bits_per_byte;
+    return static_cast<uint32_t>((bits * 1000000 + config.baud_rate - 1) / config.baud_rate);
+}
+
 /**
  * @brief Serial port interface
  * 
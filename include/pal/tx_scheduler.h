@@ -0,0 +1,150 @@
+/**
+ * @file tx_scheduler.h
+ * @brief Pre-rendered TX burst queue played out by the audio callback
+ *
+ * The modem renders complete bursts (a whole ALE call, a sounding) off
+ * the real-time thread and submits them tagged with a TX sample index.
+ * The audio callback only copies queued samples into the TX buffer, so a
+ * slow frame in the modem can no longer become an underrun on air.
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#pragma once
+
+#include "pal/audio_driver.h"
+#include "pal/audio_ring.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pal {
+
+class IEventHandler;
+
+constexpr uint64_t TX_START_ASAP = UINT64_MAX;  ///< start_index: play as soon as possible (0 is a real index)
+
+/**
+ * @brief One pre-rendered transmission
+ */
+struct TxBurst {
+    std::vector<float> samples;     ///< Audio at the driver's sample rate
+    uint64_t start_index = TX_START_ASAP;   ///< AudioBlockInfo::tx_sample_index of samples[0]
+    uint32_t id = 0;                ///< Caller's tag, untouched by the scheduler
+};
+
+/**
+ * @brief What to do with a burst whose start index has already passed
+ */
+enum class TxLatePolicy {
+    SHIFT,      ///< Play it whole, starting now
+    TRUNCATE    ///< Keep the timing, skip the samples that are already due
+};
+
+/**
+ * @brief TX scheduler configuration
+ */
+struct TxSchedulerConfig {
+    size_t max_bursts = 64;                     ///< Bursts queued or awaiting reclaim
+    uint32_t drain_warning_frames = 4800;       ///< Raise AUDIO_TX_DRAINING below this many queued frames
+    TxLatePolicy late_policy = TxLatePolicy::SHIFT;
+};
+
+/**
+ * @brief Gapless TX playout from a queue of bursts
+ *
+ * Bursts must be submitted in start_index order and must not overlap; a
+ * burst that starts before the previous one ended is treated as late.
+ * Between bursts the TX buffer is zero-filled.
+ *
+ * Thread rules: submit/reclaim/abort/emit_events belong to one non-real-time
+ * control thread, render() to the audio thread. Bursts move between them
+ * through two SPSC rings, so render() never allocates or frees; the control
+ * calls are their other end and are not safe to make from two threads at
+ * once (serialize them with your own mutex if they must be). Played bursts
+ * are handed back through reclaim() so their sample vectors can be reused.
+ */
+class TxScheduler {
+public:
+    explicit TxScheduler(const TxSchedulerConfig& config = TxSchedulerConfig());
+
+    ~TxScheduler();
+
+    TxScheduler(const TxScheduler&) = delete;
+    TxScheduler& operator=(const TxScheduler&) = delete;
+
+    // ---- Control thread (one at a time) ----------------------------------
+
+    /**
+     * @brief Queue a burst for playout
+     * @return false (and the burst is dropped) if max_bursts are outstanding
+     */
+    bool submit(std::unique_ptr<TxBurst> burst);
+
+    /**
+     * @brief Take back one played (or aborted) burst, nullptr if none
+     */
+    std::unique_ptr<TxBurst> reclaim();
+
+    /**
+     * @brief Drop everything queued; takes effect at the next render()
+     */
+    void abort();
+
+    /**
+     * @brief Emit AUDIO_TX_DRAINING once each time the queue runs low
+     *
+     * Call from a non-real-time thread; code carries the frames that were
+     * still queued when the audio thread noticed.
+     */
+    void emit_events(IEventHandler& events);
+
+    /**
+     * @brief Install a timed callback that renders TX and passes RX on
+     * @param rx_callback Optional RX consumer; its tx argument is already rendered
+     */
+    void attach(IAudioDriver& driver, IAudioDriver::TimedAudioCallback rx_callback = nullptr);
+
+    // ---- Real-time side -------------------------------------------------
+
+    /**
+     * @brief Fill tx with the queued audio for [tx_index, tx_index + count)
+     */
+    void render(uint64_t tx_index, float* tx_samples, size_t count);
+
+    // ---- Any thread -----------------------------------------------------
+
+    /**
+     * @brief Frames submitted but not yet played
+     */
+    uint64_t get_queued_frames() const;
+
+    uint64_t get_bursts_played() const { return bursts_played_.load(std::memory_order_relaxed); }
+    uint64_t get_late_bursts() const { return late_bursts_.load(std::memory_order_relaxed); }
+
+private:
+    void retire_head();
+
+    TxSchedulerConfig config_;
+
+    SpscRing<TxBurst*> queue_;      // Modem -> audio thread
+    SpscRing<TxBurst*> done_;       // Audio thread -> modem
+    std::atomic<size_t> outstanding_{0};
+    std::atomic<int64_t> queued_frames_{0};
+    std::atomic<bool> abort_requested_{false};
+
+    // Audio thread state
+    bool head_started_ = false;     // Start index of the head burst is settled
+    size_t head_consumed_ = 0;      // Head burst samples played or skipped
+    bool drain_armed_ = true;
+
+    std::atomic<bool> drain_pending_{false};
+    std::atomic<int64_t> drain_frames_{0};      // Frames queued at the low-water crossing
+    std::atomic<uint64_t> bursts_played_{0};
+    std::atomic<uint64_t> late_bursts_{0};
+};
+
+} // namespace pal
@@ -0,0 +1,418 @@
+/**
+ * @file aggregate_audio_driver.cpp
+ * @brief Multi-device aggregate driver with drift compensation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/aggregate_audio_driver.h"
+#include "pal/events.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace pal {
+
+namespace {
+
+// Fill controller, run once per master block. A PI loop on the smoothed
+// ring fill: LOOP_GAIN is the fraction of a fill error removed per block,
+// INTEGRAL_GAIN = LOOP_GAIN^2 / 4 keeps it critically damped. The
+// integral term converges on the slave's clock error.
+constexpr double FILL_SMOOTHING = 0.05;
+constexpr double LOOP_GAIN = 0.01;
+constexpr double INTEGRAL_GAIN = LOOP_GAIN * LOOP_GAIN / 4.0;
+
+uint64_t steady_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+/**
+ * @brief One slave device and its clock tracking state
+ */
+struct AggregateAudioDriver::Slave {
+    Slave(AggregateAudioDriver* o, std::unique_ptr<IAudioDriver> d, const std::string& n)
+        : owner(o), driver(std::move(d)), name(n) {}
+
+    AggregateAudioDriver* owner;
+    std::unique_ptr<IAudioDriver> driver;
+    std::string name;
+
+    std::unique_ptr<SpscRing<float>> rx_ring;   // Slave -> master, slave clock
+    std::unique_ptr<SpscRing<float>> tx_ring;   // Master -> slave, slave clock
+
+    // Position of the slave's last callback, so the master can interpolate
+    // the fill between the slave's bursts (seqlock, slave thread writes)
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint64_t> rx_written{0};
+    std::atomic<uint64_t> tx_read{0};
+    std::atomic<uint64_t> time_us{0};
+
+    // Master thread state
+    FractionalResampler rx_resampler;
+    FractionalResampler tx_resampler;
+    bool primed = false;
+    double rx_fill = 0.0;
+    double tx_fill = 0.0;
+    double integral = 0.0;      // Clock error estimate (slave/master - 1)
+
+    // Published for get_device_stats()
+    std::atomic<double> drift_ppm{0.0};
+    std::atomic<double> rx_fill_out{0.0};
+    std::atomic<double> tx_fill_out{0.0};
+};
+
+AggregateAudioDriver::AggregateAudioDriver(std::unique_ptr<IAudioDriver> master,
+                                           const AggregateAudioConfig& config)
+    : master_(std::move(master))
+    , config_(config)
+{
+    master_->set_timed_audio_callback(
+        [this](const AudioBlockInfo& info, const float* rx, float* tx, size_t n) {
+            process(info, rx, tx, n);
+        });
+}
+
+AggregateAudioDriver::~AggregateAudioDriver() {
+    // Stop every device before the slaves' callback contexts go away
+    shutdown();
+}
+
+size_t AggregateAudioDriver::add_device(std::unique_ptr<IAudioDriver> device,
+                                        const std::string& device_name) {
+    slaves_.emplace_back(new Slave(this, std::move(device), device_name));
+    Slave* slave = slaves_.back().get();
+    slave->driver->set_timer(timer_);
+    slave->driver->set_rt_policy(rt_policy_);
+    slave->driver->set_audio_callback(&AggregateAudioDriver::slave_callback, slave);
+    return slaves_.size();
+}
+
+bool AggregateAudioDriver::initialize(const std::string& device_name,
+                                      uint32_t sample_rate,
+                                      uint32_t buffer_frames) {
+    shutdown();
+    if (!master_->initialize(device_name, sample_rate, buffer_frames)) return false;
+
+    // Slaves follow whatever the master settled on
+    uint32_t rate = master_->get_sample_rate();
+    uint32_t period = master_->get_buffer_frames();
+    for (auto& slave : slaves_) {
+        if (!slave->driver->initialize(slave->name, rate, period) ||
+            slave->driver->get_sample_rate() != rate) {
+            shutdown();
+            return false;
+        }
+    }
+
+    target_fill_ = config_.target_fill_frames ? config_.target_fill_frames : 2 * period;
+    block_frames_ = period;
+    size_t channels = get_device_count();
+    rx_planes_.assign(channels, std::vector<float>(block_frames_, 0.0f));
+    tx_planes_.assign(channels, std::vector<float>(block_frames_, 0.0f));
+    rx_frames_.assign(block_frames_ * channels, 0.0f);
+    tx_frames_.assign(block_frames_ * channels, 0.0f);
+    return true;
+}
+
+void AggregateAudioDriver::shutdown() {
+    stop();
+    master_->shutdown();
+    for (auto& slave : slaves_) slave->driver->shutdown();
+}
+
+bool AggregateAudioDriver::start() {
+    if (master_->is_running()) return false;
+
+    uint32_t period = master_->get_buffer_frames();
+    size_t ring = config_.ring_frames ? config_.ring_frames : 8 * period;
+    ring = std::max<size_t>(ring, 2 * (target_fill_ + period));
+
+    // Fresh rings and controllers: nothing else touches them while stopped
+    for (auto& slave : slaves_) {
+        slave->rx_ring.reset(new SpscRing<float>(ring));
+        slave->tx_ring.reset(new SpscRing<float>(ring));
+        slave->seq.store(0, std::memory_order_relaxed);
+        slave->rx_written.store(0, std::memory_order_relaxed);
+        slave->tx_read.store(0, std::memory_order_relaxed);
+        slave->time_us.store(0, std::memory_order_relaxed);
+        slave->rx_resampler.reset();
+        slave->tx_resampler.reset();
+        slave->primed = false;
+        slave->rx_fill = target_fill_;
+        slave->tx_fill = target_fill_;
+
+        // TX starts one target ahead, so the slave plays silence first
+        std::vector<float> silence(target_fill_, 0.0f);
+        slave->tx_ring->write(silence.data(), silence.size());
+    }
+
+    for (size_t i = 0; i < slaves_.size(); i++) {
+        if (!slaves_[i]->driver->start()) {
+            for (size_t j = 0; j < i; j++) slaves_[j]->driver->stop();
+            return false;
+        }
+    }
+    if (!master_->start()) {
+        for (auto& slave : slaves_) slave->driver->stop();
+        return false;
+    }
+    return true;
+}
+
+void AggregateAudioDriver::stop() {
+    master_->stop();
+    for (auto& slave : slaves_) slave->driver->stop();
+}
+
+void AggregateAudioDriver::slave_callback(void* context, const float* rx, float* tx, size_t n) {
+    Slave* slave = static_cast<Slave*>(context);
+    if (!slave->rx_ring) {
+        std::fill(tx, tx + n, 0.0f);
+        return;
+    }
+
+    slave->rx_ring->write(rx, n);
+    size_t got = slave->tx_ring->read(tx, n);
+    std::fill(tx + got, tx + n, 0.0f);
+
+    const ITimer* timer = slave->owner->timer_;
+    uint64_t now = timer ? timer->get_time_us() : steady_us();
+    uint32_t seq = slave->seq.load(std::memory_order_relaxed);
+    slave->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slave->rx_written.store(slave->rx_ring->get_write_index(), std::memory_order_relaxed);
+    slave->tx_read.store(slave->tx_ring->get_read_index(), std::memory_order_relaxed);
+    slave->time_us.store(now, std::memory_order_relaxed);
+    slave->seq.store(seq + 2, std::memory_order_release);
+}
+
+void AggregateAudioDriver::pull_rx(Slave& slave, float* out, size_t n) {
+    SpscRing<float>& ring = *slave.rx_ring;
+
+    if (!slave.primed) {
+        // Wait for a target's worth, then drop anything beyond it
+        size_t avail = ring.size();
+        if (avail < target_fill_) {
+            std::fill(out, out + n, 0.0f);
+            return;
+        }
+        ring.commit_read(ring.read_regions(avail - target_fill_).total());
+        slave.rx_resampler.reset();
+        slave.rx_fill = target_fill_;
+        slave.primed = true;
+    }
+
+    // Slave position at its last callback, advanced to now at the nominal
+    // rate: removes the sawtooth the slave's period bursts put on the fill
+    uint64_t written = 0, tx_read = 0, time_us = 0;
+    for (;;) {
+        uint32_t seq = slave.seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        written = slave.rx_written.load(std::memory_order_relaxed);
+        tx_read = slave.tx_read.load(std::memory_order_relaxed);
+        time_us = slave.time_us.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slave.seq.load(std::memory_order_relaxed) == seq) break;
+    }
+    const ITimer* timer = timer_;
+    uint64_t now = timer ? timer->get_time_us() : steady_us();
+    double since = now > time_us ? (now - time_us) * 1e-6 * master_->get_sample_rate() : 0.0;
+    since = std::min(since, static_cast<double>(slave.driver->get_buffer_frames()));
+
+    double rx_fill = static_cast<double>(written) + since - static_cast<double>(ring.get_read_index());
+    double tx_fill = static_cast<double>(slave.tx_ring->get_write_index()) - (tx_read + since);
+    slave.rx_fill += FILL_SMOOTHING * (rx_fill - slave.rx_fill);
+    slave.tx_fill += FILL_SMOOTHING * (tx_fill - slave.tx_fill);
+
+    // PI on the RX fill; gains are per block, scaled to per frame
+    double limit = config_.max_drift_ppm * 1e-6;
+    double error = (slave.rx_fill - target_fill_) / static_cast<double>(n);
+    slave.integral = std::min(std::max(slave.integral + INTEGRAL_GAIN * error, -limit), limit);
+    double correction = std::min(std::max(LOOP_GAIN * error + slave.integral, -2 * limit), 2 * limit);
+    slave.rx_resampler.set_ratio(1.0 + correction);
+
+    // TX reuses the clock estimate, trimmed by its own fill error
+    double tx_error = (slave.tx_fill - target_fill_) / static_cast<double>(n);
+    slave.tx_resampler.set_ratio((1.0 + LOOP_GAIN * tx_error) / (1.0 + slave.integral));
+
+    slave.drift_ppm.store(slave.integral * 1e6, std::memory_order_relaxed);
+    slave.rx_fill_out.store(slave.rx_fill, std::memory_order_relaxed);
+    slave.tx_fill_out.store(slave.tx_fill, std::memory_order_relaxed);
+
+    // Resample straight out of the ring
+    SpscRing<float>::ReadRegions r = ring.read_regions();
+    size_t used = 0, used2 = 0;
+    size_t produced = slave.rx_resampler.process(r.first, r.first_count, out, n, &used);
+    if (produced < n && used == r.first_count) {
+        produced += slave.rx_resampler.process(r.second, r.second_count, out + produced,
+                                               n - produced, &used2);
+    }
+    ring.commit_read(used + used2);
+
+    if (produced < n) {
+        std::fill(out + produced, out + n, 0.0f);
+        ring.note_underrun(n - produced);
+        slave.primed = false;   // Slave stalled: re-prime, keep the clock estimate
+    }
+}
+
+void AggregateAudioDriver::push_tx(Slave& slave, const float* in, size_t n) {
+    SpscRing<float>& ring = *slave.tx_ring;
+
+    // Room for a bit more than n outputs; whatever doesn't fit is dropped
+    SpscRing<float>::WriteRegions w = ring.write_regions(n + n / 64 + 4);
+    size_t used = 0, used2 = 0;
+    size_t produced = slave.tx_resampler.process(in, n, w.first, w.first_count, &used);
+    if (used < n) {
+        produced += slave.tx_resampler.process(in + used, n - used, w.second, w.second_count, &used2);
+    }
+    ring.commit_write(produced);
+    if (used + used2 < n) ring.note_overrun(n - used - used2);
+}
+
+void AggregateAudioDriver::process(const AudioBlockInfo& info, const float* rx,
+                                   float* tx, size_t num_frames) {
+    const size_t channels = get_device_count();
+    const uint32_t rate = master_->get_sample_rate();
+    const bool native = callback_.is_native();
+
+    for (size_t offset = 0; offset < num_frames; offset += block_frames_) {
+        size_t n = std::min(block_frames_, num_frames - offset);
+
+        AudioBlockInfo block = info;
+        block.rx_sample_index += offset;
+        block.tx_sample_index += offset;
+        if (info.rx_time_us) block.rx_time_us += offset * 1000000 / rate;
+        if (info.tx_time_us) block.tx_time_us += offset * 1000000 / rate;
+
+        std::memcpy(rx_planes_[0].data(), rx + offset, n * sizeof(float));
+        for (size_t k = 0; k < slaves_.size(); k++) {
+            pull_rx(*slaves_[k], rx_planes_[k + 1].data(), n);
+        }
+        for (auto& plane : tx_planes_) std::fill(plane.begin(), plane.begin() + n, 0.0f);
+
+        if (native) {
+            for (size_t i = 0; i < n; i++) {
+                for (size_t c = 0; c < channels; c++) rx_frames_[i * channels + c] = rx_planes_[c][i];
+            }
+            std::fill(tx_frames_.begin(), tx_frames_.begin() + n * channels, 0.0f);
+            callback_.call_native(block, rx_frames_.data(), tx_frames_.data(), n);
+            for (size_t i = 0; i < n; i++) {
+                for (size_t c = 0; c < channels; c++) tx_planes_[c][i] = tx_frames_[i * channels + c];
+            }
+        } else {
+            callback_(block, rx_planes_[radio_channel_].data(), tx_planes_[radio_channel_].data(), n);
+        }
+
+        std::memcpy(tx + offset, tx_planes_[0].data(), n * sizeof(float));
+        for (size_t k = 0; k < slaves_.size(); k++) {
+            push_tx(*slaves_[k], tx_planes_[k + 1].data(), n);
+        }
+    }
+}
+
+void AggregateAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+}
+
+void AggregateAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+}
+
+void AggregateAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+}
+
+bool AggregateAudioDriver::set_native_audio_callback(NativeAudioCallback callback) {
+    callback_.set_native(std::move(callback));
+    return true;
+}
+
+bool AggregateAudioDriver::set_native_format(const AudioFormat& format) {
+    if (format.format != SampleFormat::F32 || format.channels != get_device_count() ||
+        format.radio_channel >= format.channels) {
+        return false;
+    }
+    radio_channel_ = format.radio_channel;
+    return true;
+}
+
+AudioFormat AggregateAudioDriver::get_native_format() const {
+    AudioFormat format;
+    format.format = SampleFormat::F32;
+    format.channels = static_cast<uint16_t>(get_device_count());
+    format.radio_channel = radio_channel_;
+    return format;
+}
+
+void AggregateAudioDriver::set_timer(const ITimer* timer) {
+    timer_ = timer;
+    master_->set_timer(timer);
+    for (auto& slave : slaves_) slave->driver->set_timer(timer);
+}
+
+void AggregateAudioDriver::set_rt_policy(const RtThreadPolicy& policy) {
+    rt_policy_ = policy;
+    master_->set_rt_policy(policy);
+    for (auto& slave : slaves_) slave->driver->set_rt_policy(policy);
+}
+
+RtThreadStatus AggregateAudioDriver::get_rt_status() const {
+    return master_->get_rt_status();
+}
+
+bool AggregateAudioDriver::is_running() const {
+    return master_->is_running();
+}
+
+uint32_t AggregateAudioDriver::get_sample_rate() const {
+    return master_->get_sample_rate();
+}
+
+uint32_t AggregateAudioDriver::get_buffer_frames() const {
+    return master_->get_buffer_frames();
+}
+
+float AggregateAudioDriver::get_latency_ms() const {
+    uint32_t rate = master_->get_sample_rate();
+    if (rate == 0) return master_->get_latency_ms();
+    return master_->get_latency_ms() + 1000.0f * target_fill_ / rate;
+}
+
+IAudioDriver& AggregateAudioDriver::get_device(size_t channel) {
+    return channel == 0 ? *master_ : *slaves_.at(channel - 1)->driver;
+}
+
+AggregateDeviceStats AggregateAudioDriver::get_device_stats(size_t channel) const {
+    AggregateDeviceStats stats;
+    if (channel == 0 || channel > slaves_.size()) return stats;
+
+    const Slave& slave = *slaves_[channel - 1];
+    stats.drift_ppm = slave.drift_ppm.load(std::memory_order_relaxed);
+    stats.rx_fill_frames = slave.rx_fill_out.load(std::memory_order_relaxed);
+    stats.tx_fill_frames = slave.tx_fill_out.load(std::memory_order_relaxed);
+    if (slave.rx_ring) {
+        stats.rx_overruns = slave.rx_ring->get_overruns();
+        stats.rx_underruns = slave.rx_ring->get_underruns();
+        stats.tx_overruns = slave.tx_ring->get_overruns();
+        stats.tx_underruns = slave.tx_ring->get_underruns();
+    }
+    return stats;
+}
+
+void AggregateAudioDriver::emit_events(IEventHandler& events) {
+    for (size_t k = 0; k < slaves_.size(); k++) {
+        if (!slaves_[k]->rx_ring) continue;
+        std::string source = "aggregate[" + std::to_string(k + 1) + "]";
+        slaves_[k]->rx_ring->emit_events(events, source + " rx");
+        slaves_[k]->tx_ring->emit_events(events, source + " tx");
+    }
+}
+
+} // namespace pal
@@ -0,0 +1,401 @@
+/**
+ * @file alsa_audio_driver.cpp
+ * @brief Linux ALSA mmap-mode audio driver implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/alsa_audio_driver.h"
+#include <alsa/asoundlib.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace pal {
+
+namespace {
+
+// Poll timeout; bounds how long stop() waits on a stalled device
+constexpr int WAIT_TIMEOUT_MS = 100;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Start of frame offset in an interleaved mmap area
+uint8_t* area_ptr(const snd_pcm_channel_area_t* area, snd_pcm_uframes_t offset) {
+    uint8_t* base = static_cast<uint8_t*>(area->addr);
+    return base + (area->first + offset * area->step) / 8;
+}
+
+snd_pcm_format_t to_alsa(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::S16: return SND_PCM_FORMAT_S16;
+        case SampleFormat::S32: return SND_PCM_FORMAT_S32;
+        case SampleFormat::F32: return SND_PCM_FORMAT_FLOAT;
+    }
+    return SND_PCM_FORMAT_FLOAT;
+}
+
+} // namespace
+
+AlsaAudioDriver::AlsaAudioDriver(const AlsaAudioConfig& config)
+    : config_(config)
+{
+    // rt_priority is shorthand for a plain FIFO policy; set_rt_policy() overrides it
+    if (config_.rt_priority > 0) rt_policy_ = RtThreadPolicy::fifo(config_.rt_priority);
+}
+
+AlsaAudioDriver::~AlsaAudioDriver() {
+    shutdown();
+}
+
+bool AlsaAudioDriver::initialize(const std::string& device_name,
+                                 uint32_t sample_rate,
+                                 uint32_t buffer_frames) {
+    shutdown();
+    if (sample_rate == 0 || buffer_frames == 0) return false;
+
+    sample_rate_ = sample_rate;
+    buffer_frames_ = buffer_frames;
+    format_ = requested_;
+
+    const std::string& playback_name =
+        config_.playback_device.empty() ? device_name : config_.playback_device;
+
+    // Capture first: it decides the period, playback must match it
+    if (!open_pcm(&capture_, device_name, true) ||
+        !open_pcm(&playback_, playback_name, false)) {
+        shutdown();
+        return false;
+    }
+
+    linked_ = (snd_pcm_link(capture_, playback_) == 0);
+
+    scratch_.assign(buffer_frames_ * format_.frame_bytes(), 0);
+    if (!format_.is_mono_float()) {
+        rx_float_.assign(buffer_frames_, 0.0f);
+        tx_float_.assign(buffer_frames_, 0.0f);
+    }
+    xruns_.store(0, std::memory_order_relaxed);
+    delay_frames_.store(ring_frames_ + buffer_frames_, std::memory_order_relaxed);
+    return true;
+}
+
+bool AlsaAudioDriver::choose_format(_snd_pcm* handle, snd_pcm_hw_params_t* hw) {
+    // Requested layout first, then whatever the hardware runs without a plugin
+    const SampleFormat formats[] = {requested_.format, SampleFormat::F32, SampleFormat::S32, SampleFormat::S16};
+    bool found = false;
+    for (SampleFormat f : formats) {
+        if (snd_pcm_hw_params_test_format(handle, hw, to_alsa(f)) == 0) {
+            format_.format = f;
+            found = true;
+            break;
+        }
+    }
+    if (!found) return false;
+
+    unsigned int channels = 0;
+    const unsigned int candidates[] = {requested_.channels, 1, 2};
+    for (unsigned int c : candidates) {
+        if (c > 0 && snd_pcm_hw_params_test_channels(handle, hw, c) == 0) {
+            channels = c;
+            break;
+        }
+    }
+    if (channels == 0 && snd_pcm_hw_params_get_channels_min(hw, &channels) < 0) return false;
+    if (channels == 0) return false;
+
+    format_.channels = static_cast<uint16_t>(channels);
+    format_.radio_channel = requested_.radio_channel < channels ? requested_.radio_channel : 0;
+    return true;
+}
+
+bool AlsaAudioDriver::open_pcm(_snd_pcm** pcm, const std::string& name, bool capture) {
+    snd_pcm_t* handle = nullptr;
+    int err = snd_pcm_open(&handle, name.c_str(),
+                           capture ? SND_PCM_STREAM_CAPTURE : SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) return false;
+    *pcm = handle;
+
+    snd_pcm_hw_params_t* hw;
+    snd_pcm_hw_params_alloca(&hw);
+    if (snd_pcm_hw_params_any(handle, hw) < 0) return false;
+    if (snd_pcm_hw_params_set_access(handle, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0) return false;
+    if (capture && !choose_format(handle, hw)) return false;
+    if (snd_pcm_hw_params_set_format(handle, hw, to_alsa(format_.format)) < 0) return false;
+    if (snd_pcm_hw_params_set_channels(handle, hw, format_.channels) < 0) return false;
+    if (snd_pcm_hw_params_set_rate(handle, hw, sample_rate_, 0) < 0) return false;
+
+    snd_pcm_uframes_t period = buffer_frames_;
+    int dir = 0;
+    if (snd_pcm_hw_params_set_period_size_near(handle, hw, &period, &dir) < 0) return false;
+
+    unsigned int periods = std::max<uint32_t>(config_.periods, 2);
+    dir = 0;
+    if (snd_pcm_hw_params_set_periods_near(handle, hw, &periods, &dir) < 0) return false;
+    if (snd_pcm_hw_params(handle, hw) < 0) return false;
+
+    snd_pcm_uframes_t ring = 0;
+    snd_pcm_hw_params_get_period_size(hw, &period, &dir);
+    snd_pcm_hw_params_get_buffer_size(hw, &ring);
+
+    if (capture) {
+        buffer_frames_ = static_cast<uint32_t>(period);
+        ring_frames_ = static_cast<uint32_t>(ring);
+    } else if (period != buffer_frames_) {
+        return false;   // Mismatched periods would drift apart
+    }
+
+    // Wake once per period; we start the streams explicitly
+    snd_pcm_sw_params_t* sw;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_uframes_t boundary = 0;
+    if (snd_pcm_sw_params_current(handle, sw) < 0) return false;
+    snd_pcm_sw_params_get_boundary(sw, &boundary);
+    if (snd_pcm_sw_params_set_avail_min(handle, sw, period) < 0) return false;
+    if (snd_pcm_sw_params_set_start_threshold(handle, sw, boundary) < 0) return false;
+    if (snd_pcm_sw_params(handle, sw) < 0) return false;
+
+    return true;
+}
+
+void AlsaAudioDriver::shutdown() {
+    stop();
+
+    if (capture_ && playback_ && linked_) snd_pcm_unlink(capture_);
+    if (capture_) snd_pcm_close(capture_);
+    if (playback_) snd_pcm_close(playback_);
+    capture_ = nullptr;
+    playback_ = nullptr;
+    linked_ = false;
+}
+
+bool AlsaAudioDriver::start() {
+    if (!capture_ || !playback_ || running_.load()) return false;
+    if (thread_.joinable()) thread_.join();
+
+    stop_requested_.store(false);
+    running_.store(true);
+    thread_ = std::thread(&AlsaAudioDriver::run, this);
+    return true;
+}
+
+void AlsaAudioDriver::stop() {
+    stop_requested_.store(true);
+    if (thread_.joinable()) thread_.join();
+}
+
+bool AlsaAudioDriver::prime() {
+    // Prepare both explicitly: plugin PCMs don't always propagate over a link
+    if (snd_pcm_prepare(capture_) < 0) return false;
+    if (snd_pcm_prepare(playback_) < 0) return false;
+
+    // Fill the playback ring with silence: this is the output latency
+    tx_index_ = rx_index_ + ring_frames_;
+    snd_pcm_uframes_t remaining = ring_frames_;
+    while (remaining > 0) {
+        const snd_pcm_channel_area_t* areas;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t frames = remaining;
+        if (snd_pcm_mmap_begin(playback_, &areas, &offset, &frames) < 0 || frames == 0) break;
+        std::memset(area_ptr(areas, offset), 0, frames * format_.frame_bytes());
+        if (snd_pcm_mmap_commit(playback_, offset, frames) < 0) return false;
+        remaining -= frames;
+    }
+
+    if (snd_pcm_start(capture_) < 0) return false;
+    if (!linked_ && snd_pcm_start(playback_) < 0) return false;
+    return true;
+}
+
+bool AlsaAudioDriver::recover(int err) {
+    if (stop_requested_.load(std::memory_order_relaxed)) return false;
+    xruns_.fetch_add(1, std::memory_order_relaxed);
+
+    if (err == -ESTRPIPE) {
+        // Suspended: wait for resume, then fall through to a full restart
+        while (snd_pcm_resume(capture_) == -EAGAIN) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        while (snd_pcm_resume(playback_) == -EAGAIN) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    } else if (err != -EPIPE) {
+        return false;   // Device gone or misconfigured
+    }
+
+    snd_pcm_drop(capture_);
+    snd_pcm_drop(playback_);
+
+    if (anchor_ns_ != 0) {
+        // What was left in the capture ring and everything until the
+        // restart is lost: skip it so RX stays on the device timeline
+        uint64_t gap = static_cast<uint64_t>(now_ns() - anchor_ns_) * sample_rate_ / 1000000000;
+        rx_index_ = std::max(rx_index_, anchor_index_ + gap);
+    }
+    return prime();
+}
+
+bool AlsaAudioDriver::process_period() {
+    snd_pcm_sframes_t c_avail = 0, c_delay = 0;
+    snd_pcm_sframes_t p_avail = 0, p_delay = 0;
+
+    int err = snd_pcm_avail_delay(capture_, &c_avail, &c_delay);
+    if (err < 0) return recover(err);
+    err = snd_pcm_avail_delay(playback_, &p_avail, &p_delay);
+    if (err < 0) return recover(err);
+
+    delay_frames_.store(static_cast<uint32_t>(std::max<snd_pcm_sframes_t>(c_delay + p_delay, 0)),
+                        std::memory_order_relaxed);
+
+    // Capture timeline position now, for counting frames lost to an xrun
+    anchor_ns_ = now_ns();
+    anchor_index_ = rx_index_ + static_cast<uint64_t>(std::max<snd_pcm_sframes_t>(c_avail, 0));
+
+    if (c_avail < static_cast<snd_pcm_sframes_t>(buffer_frames_)) return true;   // Spurious wakeup
+
+    // Oldest available capture frame and next playback frame, in timer time
+    uint64_t rx_time_us = 0;
+    uint64_t tx_time_us = 0;
+    if (timer_) {
+        uint64_t now_us = timer_->get_time_us();
+        rx_time_us = now_us - static_cast<uint64_t>(c_avail) * 1000000 / sample_rate_;
+        tx_time_us = now_us + static_cast<uint64_t>(std::max<snd_pcm_sframes_t>(p_delay, 0)) * 1000000 / sample_rate_;
+    }
+
+    AudioBlockInfo info;
+    snd_pcm_uframes_t remaining = buffer_frames_;
+    while (remaining > 0) {
+        const snd_pcm_channel_area_t* c_areas;
+        snd_pcm_uframes_t c_offset = 0;
+        snd_pcm_uframes_t c_frames = remaining;
+        err = snd_pcm_mmap_begin(capture_, &c_areas, &c_offset, &c_frames);
+        if (err < 0) return recover(err);
+        if (c_frames == 0) break;
+
+        const snd_pcm_channel_area_t* p_areas;
+        snd_pcm_uframes_t p_offset = 0;
+        snd_pcm_uframes_t p_frames = c_frames;
+        err = snd_pcm_mmap_begin(playback_, &p_areas, &p_offset, &p_frames);
+        if (err < 0) return recover(err);
+
+        // Both rings are passed to the callback in place
+        snd_pcm_uframes_t n = p_frames ? std::min(c_frames, p_frames) : c_frames;
+        const uint8_t* rx = area_ptr(c_areas, c_offset);
+        uint8_t* tx = p_frames ? area_ptr(p_areas, p_offset) : scratch_.data();
+
+        uint64_t done_us = static_cast<uint64_t>(buffer_frames_ - remaining) * 1000000 / sample_rate_;
+        info.rx_sample_index = rx_index_;
+        info.tx_sample_index = tx_index_;
+        info.rx_time_us = timer_ ? rx_time_us + done_us : 0;
+        info.tx_time_us = timer_ ? tx_time_us + done_us : 0;
+
+        if (callback_.is_native()) {
+            std::memset(tx, 0, n * format_.frame_bytes());
+            callback_.call_native(info, rx, tx, static_cast<size_t>(n));
+        } else if (format_.is_mono_float()) {
+            // The playback area still holds the last trip round the ring
+            std::memset(tx, 0, n * format_.frame_bytes());
+            callback_(info, reinterpret_cast<const float*>(rx), reinterpret_cast<float*>(tx),
+                      static_cast<size_t>(n));
+        } else {
+            // Device runs another layout: stage the radio channel as float
+            convert_to_float(rx, format_.format, format_.channels, format_.radio_channel,
+                             rx_float_.data(), n);
+            std::fill(tx_float_.begin(), tx_float_.begin() + n, 0.0f);
+            callback_(info, rx_float_.data(), tx_float_.data(), static_cast<size_t>(n));
+            std::memset(tx, 0, n * format_.frame_bytes());
+            convert_from_float(tx_float_.data(), n, tx, format_.format, format_.channels,
+                               format_.radio_channel);
+        }
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(capture_, c_offset, n);
+        if (committed < 0 || static_cast<snd_pcm_uframes_t>(committed) != n) {
+            return recover(committed < 0 ? static_cast<int>(committed) : -EPIPE);
+        }
+        rx_index_ += n;
+        committed = snd_pcm_mmap_commit(playback_, p_offset, p_frames ? n : 0);
+        if (committed < 0) return recover(static_cast<int>(committed));
+        tx_index_ += n;     // Frames with no room are dropped but keep their place
+
+        remaining -= n;
+    }
+
+    return true;
+}
+
+void AlsaAudioDriver::run() {
+    rt_status_.store(apply_rt_policy(rt_policy_));
+
+    rx_index_ = 0;
+    anchor_ns_ = 0;
+    bool ok = prime();
+    while (ok && !stop_requested_.load(std::memory_order_relaxed)) {
+        // poll() on the capture descriptors until a period is available
+        int err = snd_pcm_wait(capture_, WAIT_TIMEOUT_MS);
+        if (err < 0) {
+            ok = recover(err);
+        } else if (err > 0) {
+            ok = process_period();
+        }
+    }
+
+    snd_pcm_drop(capture_);
+    snd_pcm_drop(playback_);
+    running_.store(false);
+}
+
+void AlsaAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+}
+
+void AlsaAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+}
+
+void AlsaAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+}
+
+bool AlsaAudioDriver::set_native_audio_callback(NativeAudioCallback callback) {
+    callback_.set_native(std::move(callback));
+    return true;
+}
+
+bool AlsaAudioDriver::set_native_format(const AudioFormat& format) {
+    if (format.channels == 0 || format.radio_channel >= format.channels) return false;
+    requested_ = format;
+    return true;
+}
+
+AudioFormat AlsaAudioDriver::get_native_format() const {
+    return format_;
+}
+
+bool AlsaAudioDriver::is_running() const {
+    return running_.load();
+}
+
+uint32_t AlsaAudioDriver::get_sample_rate() const {
+    return sample_rate_;
+}
+
+uint32_t AlsaAudioDriver::get_buffer_frames() const {
+    return buffer_frames_;
+}
+
+float AlsaAudioDriver::get_latency_ms() const {
+    if (sample_rate_ == 0) return 0.0f;
+    return 1000.0f * delay_frames_.load(std::memory_order_relaxed) / sample_rate_;
+}
+
+std::unique_ptr<IAudioDriver> create_audio_driver() {
+    return std::unique_ptr<IAudioDriver>(new AlsaAudioDriver());
+}
+
+} // namespace pal
@@ -0,0 +1,465 @@
+/**
+ * @file file_audio_driver.cpp
+ * @brief Offline file-backed audio driver implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/file_audio_driver.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PAL_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define PAL_HAVE_MMAP 0
+#endif
+
+namespace pal {
+
+// WAV format codes
+constexpr uint16_t WAV_FORMAT_PCM = 0x0001;
+constexpr uint16_t WAV_FORMAT_FLOAT = 0x0003;
+constexpr uint16_t WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+constexpr size_t WAV_HEADER_SIZE = 44;
+
+/**
+ * @brief Read-only view of a whole file (mmap where available)
+ */
+class FileAudioDriver::MappedFile {
+public:
+    ~MappedFile() {
+#if PAL_HAVE_MMAP
+        if (addr_) ::munmap(addr_, size_);
+        if (fd_ >= 0) ::close(fd_);
+#endif
+    }
+
+    bool open(const std::string& path) {
+#if PAL_HAVE_MMAP
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0 || st.st_size <= 0) return false;
+        size_ = static_cast<size_t>(st.st_size);
+
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (addr == MAP_FAILED) return false;
+        addr_ = addr;
+
+        // Input is consumed front to back: let the kernel read ahead
+        ::madvise(addr_, size_, MADV_SEQUENTIAL);
+        return true;
+#else
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return false;
+        std::fseek(f, 0, SEEK_END);
+        long len = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        if (len > 0) {
+            buffer_.resize(static_cast<size_t>(len));
+            size_ = std::fread(buffer_.data(), 1, buffer_.size(), f);
+        }
+        std::fclose(f);
+        return size_ > 0;
+#endif
+    }
+
+    const uint8_t* data() const {
+#if PAL_HAVE_MMAP
+        return static_cast<const uint8_t*>(addr_);
+#else
+        return buffer_.data();
+#endif
+    }
+
+    size_t size() const { return size_; }
+
+private:
+#if PAL_HAVE_MMAP
+    int fd_ = -1;
+    void* addr_ = nullptr;
+#else
+    std::vector<uint8_t> buffer_;
+#endif
+    size_t size_ = 0;
+};
+
+namespace {
+
+// WAV is little endian; PAL targets (x86, ARM) are too
+uint16_t read_le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t read_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void write_le16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void write_le32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+void write_wav_header(std::FILE* f, const AudioFormat& layout, uint32_t sample_rate, uint64_t data_bytes) {
+    uint8_t h[WAV_HEADER_SIZE];
+    uint16_t bytes = static_cast<uint16_t>(sample_format_bytes(layout.format));
+    uint16_t block = static_cast<uint16_t>(layout.frame_bytes());
+    uint32_t data_len = static_cast<uint32_t>(std::min<uint64_t>(data_bytes, UINT32_MAX - 36));
+
+    std::memcpy(h, "RIFF", 4);
+    write_le32(h + 4, 36 + data_len);
+    std::memcpy(h + 8, "WAVE", 4);
+    std::memcpy(h + 12, "fmt ", 4);
+    write_le32(h + 16, 16);
+    write_le16(h + 20, layout.format == SampleFormat::F32 ? WAV_FORMAT_FLOAT : WAV_FORMAT_PCM);
+    write_le16(h + 22, layout.channels);
+    write_le32(h + 24, sample_rate);
+    write_le32(h + 28, sample_rate * block);        // Byte rate
+    write_le16(h + 32, block);                      // Block align
+    write_le16(h + 34, static_cast<uint16_t>(bytes * 8));
+    std::memcpy(h + 36, "data", 4);
+    write_le32(h + 40, data_len);
+
+    std::fwrite(h, 1, sizeof(h), f);
+}
+
+bool has_wav_extension(const std::string& path) {
+    if (path.size() < 4) return false;
+    std::string ext = path.substr(path.size() - 4);
+    for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext == ".wav";
+}
+
+} // namespace
+
+FileAudioDriver::FileAudioDriver(const FileAudioConfig& config)
+    : config_(config)
+{
+}
+
+FileAudioDriver::~FileAudioDriver() {
+    shutdown();
+}
+
+bool FileAudioDriver::initialize(const std::string& device_name,
+                                 uint32_t sample_rate,
+                                 uint32_t buffer_frames) {
+    shutdown();
+    if (sample_rate == 0 || buffer_frames == 0) return false;
+
+    input_.reset(new MappedFile());
+    if (!input_->open(device_name)) {
+        input_.reset();
+        return false;
+    }
+
+    sample_rate_ = sample_rate;
+    buffer_frames_ = buffer_frames;
+
+    if (!parse_wav()) {
+        input_.reset();
+        return false;
+    }
+    // RIFF chunks are only 2-byte aligned (an 18-byte fmt chunk puts the
+    // samples at offset 46): such files are read through rx_pad_
+    data_aligned_ = reinterpret_cast<uintptr_t>(data_) % sample_format_bytes(format_) == 0;
+    if (config_.rx_channel >= channels_) {
+        input_.reset();
+        return false;
+    }
+
+    rx_buffer_.assign(buffer_frames_, 0.0f);
+    tx_buffer_.assign(buffer_frames_, 0.0f);
+    tx_pcm_.assign(buffer_frames_ * std::max(sample_format_bytes(config_.tx_format), frame_bytes_), 0);
+    rx_pad_.assign(buffer_frames_ * frame_bytes_, 0);
+    frames_processed_.store(0, std::memory_order_relaxed);
+    elapsed_s_.store(0.0, std::memory_order_relaxed);
+
+    if (!open_tx()) {
+        input_.reset();
+        return false;
+    }
+
+    initialized_ = true;
+    return true;
+}
+
+bool FileAudioDriver::parse_wav() {
+    const uint8_t* base = input_->data();
+    size_t size = input_->size();
+
+    bool is_wav = size >= 12 &&
+                  std::memcmp(base, "RIFF", 4) == 0 &&
+                  std::memcmp(base + 8, "WAVE", 4) == 0;
+
+    if (!is_wav) {
+        // Raw PCM in the configured layout at the requested rate
+        format_ = config_.raw_format;
+        channels_ = std::max<uint16_t>(config_.raw_channels, 1);
+        frame_bytes_ = sample_format_bytes(format_) * channels_;
+        data_ = base;
+        total_frames_ = size / frame_bytes_;
+        return true;
+    }
+
+    bool have_fmt = false;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* chunk = base + pos;
+        uint32_t len = read_le32(chunk + 4);
+        size_t body = pos + 8;
+        size_t avail = std::min<size_t>(len, size - body);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && avail >= 16) {
+            uint16_t code = read_le16(chunk + 8);
+            channels_ = read_le16(chunk + 10);
+            uint32_t rate = read_le32(chunk + 12);
+            uint16_t bits = read_le16(chunk + 22);
+
+            if (code == WAV_FORMAT_EXTENSIBLE && avail >= 26) {
+                code = read_le16(chunk + 8 + 24);   // First two bytes of SubFormat GUID
+            }
+
+            if (code == WAV_FORMAT_PCM && bits == 16) {
+                format_ = SampleFormat::S16;
+            } else if (code == WAV_FORMAT_PCM && bits == 32) {
+                format_ = SampleFormat::S32;
+            } else if (code == WAV_FORMAT_FLOAT && bits == 32) {
+                format_ = SampleFormat::F32;
+            } else {
+                return false;
+            }
+
+            // Recorded rate must match what the pipeline expects
+            if (rate != sample_rate_ || channels_ == 0) return false;
+            frame_bytes_ = sample_format_bytes(format_) * channels_;
+            have_fmt = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) return false;
+            data_ = body > size ? base + size : base + body;
+            total_frames_ = avail / frame_bytes_;
+            return true;
+        }
+
+        pos = body + len + (len & 1);   // Chunks are word aligned
+    }
+
+    return false;
+}
+
+bool FileAudioDriver::open_tx() {
+    tx_bytes_ = 0;
+    tx_layout_ = AudioFormat();
+    tx_layout_.format = config_.tx_format;
+    if (config_.tx_path.empty()) return true;
+
+    tx_file_ = std::fopen(config_.tx_path.c_str(), "wb");
+    if (!tx_file_) return false;
+
+    tx_wav_ = has_wav_extension(config_.tx_path);
+    if (tx_wav_) {
+        // Placeholder, sizes patched in close_tx()
+        write_wav_header(tx_file_, tx_layout_, sample_rate_, 0);
+    }
+    return true;
+}
+
+void FileAudioDriver::close_tx() {
+    if (!tx_file_) return;
+
+    if (tx_wav_) {
+        std::fseek(tx_file_, 0, SEEK_SET);
+        write_wav_header(tx_file_, tx_layout_, sample_rate_, tx_bytes_);
+    }
+    std::fclose(tx_file_);
+    tx_file_ = nullptr;
+}
+
+void FileAudioDriver::shutdown() {
+    stop();
+    close_tx();
+    input_.reset();
+    data_ = nullptr;
+    total_frames_ = 0;
+    initialized_ = false;
+}
+
+bool FileAudioDriver::start() {
+    if (!initialized_ || running_.load()) return false;
+    if (thread_.joinable()) thread_.join();
+    if (frames_processed_.load() >= total_frames_) return false;
+
+    // The TX file takes the layout of the first run's callback: device
+    // frames for a native callback, mono tx_format otherwise
+    AudioFormat layout = get_native_format();
+    if (!callback_.is_native()) {
+        layout = AudioFormat();
+        layout.format = config_.tx_format;
+    }
+    layout.radio_channel = 0;
+    if (tx_bytes_ == 0) {
+        tx_layout_ = layout;
+    } else if (layout != tx_layout_) {
+        return false;
+    }
+
+    stop_requested_.store(false);
+    running_.store(true);
+    thread_ = std::thread(&FileAudioDriver::run, this);
+    return true;
+}
+
+void FileAudioDriver::stop() {
+    stop_requested_.store(true);
+    if (thread_.joinable()) thread_.join();
+}
+
+void FileAudioDriver::wait() {
+    if (thread_.joinable()) thread_.join();
+}
+
+void FileAudioDriver::run() {
+    using Clock = std::chrono::steady_clock;
+    rt_status_.store(apply_rt_policy(rt_policy_));
+
+    auto start = Clock::now();
+    auto next = start;
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+        config_.speed > 0.0f ? buffer_frames_ / (sample_rate_ * static_cast<double>(config_.speed)) : 0.0));
+
+    const bool native = callback_.is_native();
+    const size_t tx_frame_bytes = tx_layout_.frame_bytes();
+    uint64_t pos = frames_processed_.load(std::memory_order_relaxed);
+
+    // Media time: the file position is the timeline, anchored at start()
+    AudioBlockInfo info;
+    uint64_t origin_us = timer_ ? timer_->get_time_us() - pos * 1000000 / sample_rate_ : 0;
+
+    while (!stop_requested_.load(std::memory_order_relaxed) && pos < total_frames_) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(buffer_frames_, total_frames_ - pos));
+        const uint8_t* rx_frames = data_ + pos * frame_bytes_;
+
+        info.rx_sample_index = pos;
+        info.tx_sample_index = pos;
+        info.rx_time_us = origin_us + pos * 1000000 / sample_rate_;
+        info.tx_time_us = info.rx_time_us;
+
+        if (!data_aligned_) {
+            std::memcpy(rx_pad_.data(), rx_frames, n * frame_bytes_);
+            rx_frames = rx_pad_.data();
+        }
+
+        if (native) {
+            // Full periods come straight from the mapping; only the tail is copied
+            if (n < buffer_frames_) {
+                if (rx_frames != rx_pad_.data()) std::memcpy(rx_pad_.data(), rx_frames, n * frame_bytes_);
+                std::memset(rx_pad_.data() + n * frame_bytes_, 0, (buffer_frames_ - n) * frame_bytes_);
+                rx_frames = rx_pad_.data();
+            }
+            std::memset(tx_pcm_.data(), 0, buffer_frames_ * frame_bytes_);
+            callback_.call_native(info, rx_frames, tx_pcm_.data(), buffer_frames_);
+        } else {
+            convert_to_float(rx_frames, format_, channels_, config_.rx_channel, rx_buffer_.data(), n);
+            std::fill(rx_buffer_.begin() + n, rx_buffer_.end(), 0.0f);
+            std::fill(tx_buffer_.begin(), tx_buffer_.end(), 0.0f);
+            callback_(info, rx_buffer_.data(), tx_buffer_.data(), buffer_frames_);
+            if (tx_file_) {
+                convert_from_float(tx_buffer_.data(), n, tx_pcm_.data(), config_.tx_format, 1, 0);
+            }
+        }
+
+        if (tx_file_) {
+            // TX file tracks the RX timeline, so the padded tail is dropped
+            tx_bytes_ += std::fwrite(tx_pcm_.data(), 1, n * tx_frame_bytes, tx_file_);
+        }
+
+        pos += n;
+        frames_processed_.store(pos, std::memory_order_relaxed);
+
+        if (config_.speed > 0.0f) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    elapsed_s_.store(elapsed_s_.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+    running_.store(false);
+}
+
+void FileAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+}
+
+void FileAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+}
+
+void FileAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+}
+
+bool FileAudioDriver::set_native_audio_callback(NativeAudioCallback callback) {
+    callback_.set_native(std::move(callback));
+    return true;
+}
+
+bool FileAudioDriver::set_native_format(const AudioFormat& format) {
+    // Sample format and channels are the file's; only the channel is ours to pick
+    config_.rx_channel = format.radio_channel;
+    return true;
+}
+
+AudioFormat FileAudioDriver::get_native_format() const {
+    AudioFormat format;
+    format.format = format_;
+    format.channels = channels_;
+    format.radio_channel = config_.rx_channel;
+    return format;
+}
+
+bool FileAudioDriver::is_running() const {
+    return running_.load();
+}
+
+uint32_t FileAudioDriver::get_sample_rate() const {
+    return sample_rate_;
+}
+
+uint32_t FileAudioDriver::get_buffer_frames() const {
+    return buffer_frames_;
+}
+
+float FileAudioDriver::get_latency_ms() const {
+    // One period in, one period out; no device buffering
+    if (sample_rate_ == 0) return 0.0f;
+    return 1000.0f * buffer_frames_ / sample_rate_;
+}
+
+double FileAudioDriver::get_realtime_factor() const {
+    double elapsed = elapsed_s_.load(std::memory_order_relaxed);
+    if (elapsed <= 0.0 || sample_rate_ == 0) return 0.0;
+    return (static_cast<double>(get_frames_processed()) / sample_rate_) / elapsed;
+}
+
+} // namespace pal
@@ -0,0 +1,228 @@
+/**
+ * @file jack_audio_driver.cpp
+ * @brief JACK client audio driver implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/jack_audio_driver.h"
+#include <jack/jack.h>
+#include <cstring>
+
+namespace pal {
+
+namespace {
+
+// First physical port matching flags, empty if none
+std::string first_physical_port(jack_client_t* client, unsigned long flags) {
+    std::string name;
+    const char** ports = jack_get_ports(client, nullptr, JACK_DEFAULT_AUDIO_TYPE,
+                                        JackPortIsPhysical | flags);
+    if (ports) {
+        if (ports[0]) name = ports[0];
+        jack_free(ports);
+    }
+    return name;
+}
+
+} // namespace
+
+JackAudioDriver::JackAudioDriver(const JackAudioConfig& config)
+    : config_(config)
+{
+}
+
+JackAudioDriver::~JackAudioDriver() {
+    shutdown();
+}
+
+bool JackAudioDriver::initialize(const std::string& device_name,
+                                 uint32_t sample_rate,
+                                 uint32_t buffer_frames) {
+    (void)buffer_frames;    // The server decides the period
+    shutdown();
+
+    const char* name = device_name.empty() ? "pc-ale" : device_name.c_str();
+    jack_status_t status;
+    client_ = jack_client_open(name, JackNoStartServer, &status);
+    if (!client_) return false;
+
+    sample_rate_ = jack_get_sample_rate(client_);
+    if (sample_rate_ != sample_rate) {
+        shutdown();
+        return false;
+    }
+    buffer_frames_.store(jack_get_buffer_size(client_));
+
+    rx_port_ = jack_port_register(client_, "rx", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+    tx_port_ = jack_port_register(client_, "tx", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+    if (!rx_port_ || !tx_port_) {
+        shutdown();
+        return false;
+    }
+
+    jack_set_process_callback(client_, &JackAudioDriver::process_callback, this);
+    jack_set_buffer_size_callback(client_, &JackAudioDriver::buffer_size_callback, this);
+    jack_set_xrun_callback(client_, &JackAudioDriver::xrun_callback, this);
+    jack_set_thread_init_callback(client_, &JackAudioDriver::thread_init_callback, this);
+    jack_on_shutdown(client_, &JackAudioDriver::shutdown_callback, this);
+
+    xruns_.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void JackAudioDriver::shutdown() {
+    stop();
+    if (client_) jack_client_close(client_);
+    client_ = nullptr;
+    rx_port_ = nullptr;
+    tx_port_ = nullptr;
+}
+
+bool JackAudioDriver::start() {
+    if (!client_ || running_.load()) return false;
+    rx_index_ = 0;
+    if (jack_activate(client_) != 0) return false;
+
+    // Ports can only be connected once the client is active
+    if (config_.auto_connect && !connect_ports()) {
+        jack_deactivate(client_);
+        return false;
+    }
+
+    running_.store(true);
+    return true;
+}
+
+void JackAudioDriver::stop() {
+    if (client_ && running_.load()) {
+        jack_deactivate(client_);
+    }
+    running_.store(false);
+}
+
+bool JackAudioDriver::connect_ports() {
+    // Physical capture ports are outputs from the graph's point of view
+    std::string source = config_.connect_rx.empty()
+        ? first_physical_port(client_, JackPortIsOutput) : config_.connect_rx;
+    std::string sink = config_.connect_tx.empty()
+        ? first_physical_port(client_, JackPortIsInput) : config_.connect_tx;
+
+    // The dummy backend may have no physical ports; that's not an error
+    if (!source.empty() &&
+        jack_connect(client_, source.c_str(), jack_port_name(rx_port_)) != 0) {
+        return false;
+    }
+    if (!sink.empty() &&
+        jack_connect(client_, jack_port_name(tx_port_), sink.c_str()) != 0) {
+        return false;
+    }
+    return true;
+}
+
+int JackAudioDriver::process_callback(uint32_t nframes, void* arg) {
+    auto* self = static_cast<JackAudioDriver*>(arg);
+
+    // Port buffers are used in place: no copy in or out of the graph
+    const float* rx = static_cast<const float*>(jack_port_get_buffer(self->rx_port_, nframes));
+    float* tx = static_cast<float*>(jack_port_get_buffer(self->tx_port_, nframes));
+
+    AudioBlockInfo info;
+    if (self->callback_.is_timed()) {
+        // Same accounting as get_latency_ms(): the input buffer holds the previous period
+        jack_latency_range_t capture{0, 0};
+        jack_latency_range_t playback{0, 0};
+        jack_port_get_latency_range(self->rx_port_, JackCaptureLatency, &capture);
+        jack_port_get_latency_range(self->tx_port_, JackPlaybackLatency, &playback);
+        uint64_t rx_age = nframes + capture.max;
+
+        info.rx_sample_index = self->rx_index_;
+        info.tx_sample_index = self->rx_index_ + rx_age + playback.max;
+
+        if (self->timer_) {
+            jack_client_t* client = self->client_;
+            uint32_t rate = self->sample_rate_;
+            int64_t cycle_us = static_cast<int64_t>(
+                jack_frames_to_time(client, jack_last_frame_time(client)));
+            cycle_us += static_cast<int64_t>(self->timer_->get_time_us()) -
+                        static_cast<int64_t>(jack_get_time());
+            info.rx_time_us = static_cast<uint64_t>(cycle_us - static_cast<int64_t>(rx_age * 1000000 / rate));
+            info.tx_time_us = static_cast<uint64_t>(cycle_us + static_cast<int64_t>(playback.max * 1000000ull / rate));
+        }
+    }
+    self->rx_index_ += nframes;
+
+    // The output port buffer holds whatever the graph left there: start
+    // from silence so a callback that writes nothing doesn't replay it
+    std::memset(tx, 0, nframes * sizeof(float));
+    self->callback_(info, rx, tx, nframes);
+    return 0;
+}
+
+int JackAudioDriver::buffer_size_callback(uint32_t nframes, void* arg) {
+    static_cast<JackAudioDriver*>(arg)->buffer_frames_.store(nframes);
+    return 0;
+}
+
+int JackAudioDriver::xrun_callback(void* arg) {
+    static_cast<JackAudioDriver*>(arg)->xruns_.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+void JackAudioDriver::thread_init_callback(void* arg) {
+    // libjack already gives the process thread the server's RT priority;
+    // only what the policy asks for on top of that is changed here
+    JackAudioDriver* self = static_cast<JackAudioDriver*>(arg);
+    self->rt_status_.store(apply_rt_policy(self->rt_policy_));
+}
+
+void JackAudioDriver::shutdown_callback(void* arg) {
+    // Server went away; the client handle must still be closed by shutdown()
+    static_cast<JackAudioDriver*>(arg)->running_.store(false);
+}
+
+void JackAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+}
+
+void JackAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+}
+
+void JackAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+}
+
+bool JackAudioDriver::is_running() const {
+    return running_.load();
+}
+
+uint32_t JackAudioDriver::get_sample_rate() const {
+    return sample_rate_;
+}
+
+uint32_t JackAudioDriver::get_buffer_frames() const {
+    return buffer_frames_.load();
+}
+
+float JackAudioDriver::get_latency_ms() const {
+    if (!client_ || sample_rate_ == 0) return 0.0f;
+
+    jack_latency_range_t capture{0, 0};
+    jack_latency_range_t playback{0, 0};
+    jack_port_get_latency_range(rx_port_, JackCaptureLatency, &capture);
+    jack_port_get_latency_range(tx_port_, JackPlaybackLatency, &playback);
+
+    uint32_t frames = capture.max + playback.max + buffer_frames_.load();
+    return 1000.0f * frames / sample_rate_;
+}
+
+#ifndef PAL_WITH_ALSA
+std::unique_ptr<IAudioDriver> create_audio_driver() {
+    return std::unique_ptr<IAudioDriver>(new JackAudioDriver());
+}
+#endif
+
+} // namespace pal
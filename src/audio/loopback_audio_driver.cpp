@@ -0,0 +1,253 @@
+/**
+ * @file loopback_audio_driver.cpp
+ * @brief TX->RX loopback audio driver implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/loopback_audio_driver.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace pal {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of the calling thread
+int64_t thread_cpu_ns() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return now_ns();
+#endif
+}
+
+} // namespace
+
+LoopbackAudioDriver::LoopbackAudioDriver(const LoopbackConfig& config)
+    : config_(config)
+    , rng_(config.noise_seed)
+    , noise_(0.0f, config.noise_rms > 0.0f ? config.noise_rms : 1.0f)
+{
+}
+
+LoopbackAudioDriver::~LoopbackAudioDriver() {
+    shutdown();
+}
+
+bool LoopbackAudioDriver::initialize(const std::string& device_name,
+                                     uint32_t sample_rate,
+                                     uint32_t buffer_frames) {
+    (void)device_name;
+    shutdown();
+    if (sample_rate == 0 || buffer_frames == 0) return false;
+
+    sample_rate_ = sample_rate;
+    buffer_frames_ = buffer_frames;
+
+    rx_buffer_.assign(buffer_frames_, 0.0f);
+    tx_buffer_.assign(buffer_frames_, 0.0f);
+
+    if (config_.freq_offset_hz != 0.0f) {
+        i_buffer_.assign(buffer_frames_, 0.0f);
+        q_buffer_.assign(buffer_frames_, 0.0f);
+        double w = 2.0 * PI * config_.freq_offset_hz / sample_rate_;
+        rot_re_ = static_cast<float>(std::cos(w));
+        rot_im_ = static_cast<float>(std::sin(w));
+    }
+    hilbert_.reset();
+    osc_re_ = 1.0f;
+    osc_im_ = 0.0f;
+    rng_.seed(config_.noise_seed);
+    noise_.reset();
+    sample_index_ = 0;
+    origin_us_ = timer_ ? timer_->get_time_us() : 0;
+
+    reset_stats();
+    initialized_ = true;
+    return true;
+}
+
+void LoopbackAudioDriver::shutdown() {
+    stop();
+    initialized_ = false;
+}
+
+bool LoopbackAudioDriver::start() {
+    if (!initialized_ || running_.load()) return false;
+    if (thread_.joinable()) thread_.join();
+
+    reset_stats();
+    origin_us_ = timer_ ? timer_->get_time_us() - sample_index_ * 1000000 / sample_rate_ : 0;
+    stop_requested_.store(false);
+    running_.store(true);
+    thread_ = std::thread(&LoopbackAudioDriver::thread_main, this);
+    return true;
+}
+
+void LoopbackAudioDriver::stop() {
+    stop_requested_.store(true);
+    if (thread_.joinable()) thread_.join();
+}
+
+void LoopbackAudioDriver::wait() {
+    if (thread_.joinable()) thread_.join();
+}
+
+void LoopbackAudioDriver::run(uint64_t callbacks) {
+    if (!initialized_ || running_.load()) return;
+    for (uint64_t i = 0; i < callbacks; i++) {
+        run_period();
+    }
+    end_ns_.store(now_ns(), std::memory_order_relaxed);
+}
+
+void LoopbackAudioDriver::thread_main() {
+    rt_status_.store(apply_rt_policy(rt_policy_));
+
+    // Never sleeps: the callback rate is limited only by the callback itself
+    uint64_t limit = config_.max_callbacks;
+    while (!stop_requested_.load(std::memory_order_relaxed)) {
+        if (limit != 0 && callbacks_.load(std::memory_order_relaxed) >= limit) break;
+        run_period();
+    }
+    end_ns_.store(now_ns(), std::memory_order_relaxed);
+    running_.store(false);
+}
+
+void LoopbackAudioDriver::run_period() {
+    // Last period's TX becomes this period's RX
+    std::memcpy(rx_buffer_.data(), tx_buffer_.data(), buffer_frames_ * sizeof(float));
+    apply_channel();
+    std::fill(tx_buffer_.begin(), tx_buffer_.end(), 0.0f);
+
+    AudioBlockInfo info;
+    info.rx_sample_index = sample_index_;
+    info.tx_sample_index = sample_index_ + buffer_frames_;
+    info.rx_time_us = origin_us_ + info.rx_sample_index * 1000000 / sample_rate_;
+    info.tx_time_us = origin_us_ + info.tx_sample_index * 1000000 / sample_rate_;
+    sample_index_ += buffer_frames_;
+
+    // Throughput is measured from the first block, not from initialize/start
+    if (start_ns_.load(std::memory_order_relaxed) == 0) start_ns_.store(now_ns(), std::memory_order_relaxed);
+    end_ns_.store(0, std::memory_order_relaxed);
+
+    int64_t t0 = thread_cpu_ns();
+    callback_(info, rx_buffer_.data(), tx_buffer_.data(), buffer_frames_);
+    uint64_t dt = static_cast<uint64_t>(thread_cpu_ns() - t0);
+
+    // Single writer: plain load/store is enough for readers to see progress
+    callback_ns_.store(callback_ns_.load(std::memory_order_relaxed) + dt,
+                       std::memory_order_relaxed);
+    if (dt > callback_ns_max_.load(std::memory_order_relaxed)) {
+        callback_ns_max_.store(dt, std::memory_order_relaxed);
+    }
+    callbacks_.store(callbacks_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+}
+
+void LoopbackAudioDriver::apply_channel() {
+    float* rx = rx_buffer_.data();
+    size_t n = buffer_frames_;
+
+    if (config_.freq_offset_hz != 0.0f) {
+        // Shift the analytic signal: Re{(I + jQ) * e^(jwt)}
+        hilbert_.process(rx, n, i_buffer_.data(), q_buffer_.data());
+        for (size_t k = 0; k < n; k++) {
+            rx[k] = i_buffer_[k] * osc_re_ - q_buffer_[k] * osc_im_;
+            float re = osc_re_ * rot_re_ - osc_im_ * rot_im_;
+            osc_im_ = osc_re_ * rot_im_ + osc_im_ * rot_re_;
+            osc_re_ = re;
+        }
+        // Renormalize once per period so the recursive oscillator can't drift
+        float mag = std::sqrt(osc_re_ * osc_re_ + osc_im_ * osc_im_);
+        osc_re_ /= mag;
+        osc_im_ /= mag;
+    }
+
+    if (config_.noise_rms > 0.0f) {
+        for (size_t k = 0; k < n; k++) {
+            rx[k] += noise_(rng_);
+        }
+    }
+}
+
+void LoopbackAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+}
+
+void LoopbackAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+}
+
+void LoopbackAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+}
+
+LoopbackStats LoopbackAudioDriver::get_stats() const {
+    LoopbackStats stats;
+    stats.callbacks = callbacks_.load(std::memory_order_relaxed);
+    stats.samples = stats.callbacks * buffer_frames_;
+    int64_t start = start_ns_.load(std::memory_order_relaxed);
+    int64_t end = end_ns_.load(std::memory_order_relaxed);
+    if (start != 0) stats.elapsed_s = ((end != 0 ? end : now_ns()) - start) * 1e-9;
+
+    double busy_us = callback_ns_.load(std::memory_order_relaxed) * 1e-3;
+    stats.max_callback_us = callback_ns_max_.load(std::memory_order_relaxed) * 1e-3;
+
+    if (stats.elapsed_s > 0.0) {
+        stats.samples_per_sec = stats.samples / stats.elapsed_s;
+        stats.callbacks_per_sec = stats.callbacks / stats.elapsed_s;
+    }
+    if (stats.callbacks > 0) {
+        stats.avg_callback_us = busy_us / stats.callbacks;
+    }
+    if (sample_rate_ > 0 && buffer_frames_ > 0) {
+        double period_us = 1e6 * buffer_frames_ / sample_rate_;
+        stats.load = stats.avg_callback_us / period_us;
+    }
+    return stats;
+}
+
+void LoopbackAudioDriver::reset_stats() {
+    callbacks_.store(0, std::memory_order_relaxed);
+    callback_ns_.store(0, std::memory_order_relaxed);
+    callback_ns_max_.store(0, std::memory_order_relaxed);
+    start_ns_.store(0, std::memory_order_relaxed);
+    end_ns_.store(0, std::memory_order_relaxed);
+}
+
+bool LoopbackAudioDriver::is_running() const {
+    return running_.load();
+}
+
+uint32_t LoopbackAudioDriver::get_sample_rate() const {
+    return sample_rate_;
+}
+
+uint32_t LoopbackAudioDriver::get_buffer_frames() const {
+    return buffer_frames_;
+}
+
+float LoopbackAudioDriver::get_latency_ms() const {
+    if (sample_rate_ == 0) return 0.0f;
+    uint32_t frames = buffer_frames_;
+    if (config_.freq_offset_hz != 0.0f) frames += hilbert_.get_delay();
+    return 1000.0f * frames / sample_rate_;
+}
+
+} // namespace pal
@@ -0,0 +1,277 @@
+/**
+ * @file monitored_audio_driver.cpp
+ * @brief Callback budget / jitter monitoring decorator implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/monitored_audio_driver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace pal {
+
+namespace {
+
+constexpr double PPM = 1e6;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Single writer: a plain load/store avoids the locked RMW of fetch_add
+template <typename T>
+void bump(std::atomic<T>& counter, T amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+template <typename T>
+void raise_max(std::atomic<T>& value, T candidate) {
+    if (candidate > value.load(std::memory_order_relaxed)) {
+        value.store(candidate, std::memory_order_relaxed);
+    }
+}
+
+size_t jitter_bin(uint64_t jitter_ns) {
+    uint64_t us = jitter_ns / 1000;
+    size_t bin = 0;
+    while (us > 1 && bin + 1 < AudioMonitorSnapshot::JITTER_BINS) {
+        us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+} // namespace
+
+double AudioMonitorSnapshot::load_percentile(double p) const {
+    uint64_t total = 0;
+    for (uint64_t count : load_histogram) total += count;
+    if (total == 0) return 0.0;
+
+    uint64_t target = static_cast<uint64_t>(p * total + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LOAD_BINS - 1; i++) {
+        seen += load_histogram[i];
+        if (seen >= target) return (i + 1) / 10.0;
+    }
+    return max_load;
+}
+
+MonitoredAudioDriver::MonitoredAudioDriver(std::unique_ptr<IAudioDriver> inner,
+                                           const AudioMonitorConfig& config)
+    : inner_(std::move(inner))
+    , config_(config)
+{
+    install_float_trampoline();
+}
+
+void MonitoredAudioDriver::install_float_trampoline() {
+    inner_->set_timed_audio_callback(
+        [this](const AudioBlockInfo& info, const float* rx, float* tx, size_t n) {
+            int64_t start = begin_measure(n);
+            callback_(info, rx, tx, n);
+            end_measure(start, n);
+        });
+    inner_native_ = false;
+}
+
+MonitoredAudioDriver::~MonitoredAudioDriver() {
+    // Stop the inner driver before the trampoline's target goes away
+    inner_->shutdown();
+}
+
+bool MonitoredAudioDriver::initialize(const std::string& device_name,
+                                      uint32_t sample_rate,
+                                      uint32_t buffer_frames) {
+    if (!inner_->initialize(device_name, sample_rate, buffer_frames)) return false;
+
+    // Drivers may adjust the rate/period; measure against what they report
+    uint32_t rate = inner_->get_sample_rate();
+    ns_per_frame_ = rate > 0 ? 1e9 / rate : 0.0;
+    reset_stats();
+    return true;
+}
+
+void MonitoredAudioDriver::reset_stats() {
+    callbacks_.store(0, std::memory_order_relaxed);
+    over_budget_.store(0, std::memory_order_relaxed);
+    deadline_misses_.store(0, std::memory_order_relaxed);
+    load_ppm_sum_.store(0, std::memory_order_relaxed);
+    max_load_ppm_.store(0, std::memory_order_relaxed);
+    window_load_ppm_.store(0, std::memory_order_relaxed);
+    max_jitter_ns_.store(0, std::memory_order_relaxed);
+    for (auto& bin : load_bins_) bin.store(0, std::memory_order_relaxed);
+    for (auto& bin : jitter_bins_) bin.store(0, std::memory_order_relaxed);
+    reported_over_budget_ = 0;
+    reported_misses_ = 0;
+}
+
+void MonitoredAudioDriver::shutdown() {
+    inner_->shutdown();
+}
+
+bool MonitoredAudioDriver::start() {
+    // No previous callback to measure the first interval against
+    last_start_ns_ = 0;
+    return inner_->start();
+}
+
+void MonitoredAudioDriver::stop() {
+    inner_->stop();
+}
+
+int64_t MonitoredAudioDriver::begin_measure(size_t n) {
+    int64_t start = now_ns();
+
+    if (last_start_ns_ != 0) {
+        // Deviation of this callback's start from where the previous period said it should be
+        int64_t expected = static_cast<int64_t>(last_frames_ * ns_per_frame_);
+        int64_t interval = start - last_start_ns_;
+        uint64_t jitter = static_cast<uint64_t>(interval > expected ? interval - expected
+                                                                    : expected - interval);
+        bump(jitter_bins_[jitter_bin(jitter)]);
+        raise_max(max_jitter_ns_, jitter);
+    }
+    last_start_ns_ = start;
+    last_frames_ = n;
+    return start;
+}
+
+void MonitoredAudioDriver::end_measure(int64_t start, size_t n) {
+    double period_ns = n * ns_per_frame_;
+    if (period_ns <= 0.0) return;
+
+    double load = (now_ns() - start) / period_ns;
+    uint32_t load_ppm = static_cast<uint32_t>(std::min(load * PPM, 4e9));
+
+    size_t bin = std::min(static_cast<size_t>(load * 10.0), AudioMonitorSnapshot::LOAD_BINS - 1);
+    bump(load_bins_[bin]);
+    bump<uint64_t>(load_ppm_sum_, load_ppm);
+    raise_max(max_load_ppm_, load_ppm);
+    raise_max(window_load_ppm_, load_ppm);
+    if (load > config_.warn_load) bump(over_budget_);
+    if (load > 1.0) bump(deadline_misses_);
+    bump(callbacks_);
+}
+
+AudioMonitorSnapshot MonitoredAudioDriver::snapshot() const {
+    AudioMonitorSnapshot snap;
+    snap.callbacks = callbacks_.load(std::memory_order_relaxed);
+    snap.over_budget = over_budget_.load(std::memory_order_relaxed);
+    snap.deadline_misses = deadline_misses_.load(std::memory_order_relaxed);
+    snap.max_load = max_load_ppm_.load(std::memory_order_relaxed) / PPM;
+    snap.max_jitter_us = max_jitter_ns_.load(std::memory_order_relaxed) * 1e-3;
+    if (snap.callbacks > 0) {
+        snap.avg_load = load_ppm_sum_.load(std::memory_order_relaxed) / PPM / snap.callbacks;
+    }
+    for (size_t i = 0; i < AudioMonitorSnapshot::LOAD_BINS; i++) {
+        snap.load_histogram[i] = load_bins_[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < AudioMonitorSnapshot::JITTER_BINS; i++) {
+        snap.jitter_histogram[i] = jitter_bins_[i].load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+void MonitoredAudioDriver::emit_events(IEventHandler& events) {
+    uint64_t over = over_budget_.load(std::memory_order_relaxed);
+    uint64_t misses = deadline_misses_.load(std::memory_order_relaxed);
+    uint32_t window_ppm = window_load_ppm_.exchange(0, std::memory_order_relaxed);
+
+    if (over == reported_over_budget_) return;
+
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "callback load %.0f%% of period (%llu over budget, %llu missed)",
+                  window_ppm / PPM * 100.0,
+                  static_cast<unsigned long long>(over - reported_over_budget_),
+                  static_cast<unsigned long long>(misses - reported_misses_));
+
+    Event event{};
+    event.type = EventType::SYSTEM_WARNING;
+    event.source = config_.source;
+    event.message = buf;
+    event.code = static_cast<int32_t>(window_ppm / 10000);
+    events.emit(event);
+
+    reported_over_budget_ = over;
+    reported_misses_ = misses;
+}
+
+void MonitoredAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+    if (inner_native_) install_float_trampoline();
+}
+
+void MonitoredAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+    if (inner_native_) install_float_trampoline();
+}
+
+void MonitoredAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+    if (inner_native_) install_float_trampoline();
+}
+
+bool MonitoredAudioDriver::set_native_audio_callback(NativeAudioCallback callback) {
+    if (!callback) {
+        set_audio_callback(AudioCallback());
+        return true;
+    }
+
+    bool ok = inner_->set_native_audio_callback(
+        [this](const AudioBlockInfo& info, const void* rx, void* tx, size_t n) {
+            int64_t start = begin_measure(n);
+            callback_.call_native(info, rx, tx, n);
+            end_measure(start, n);
+        });
+    if (!ok) return false;
+
+    callback_.set_native(std::move(callback));
+    inner_native_ = true;
+    return true;
+}
+
+bool MonitoredAudioDriver::set_native_format(const AudioFormat& format) {
+    return inner_->set_native_format(format);
+}
+
+AudioFormat MonitoredAudioDriver::get_native_format() const {
+    return inner_->get_native_format();
+}
+
+void MonitoredAudioDriver::set_timer(const ITimer* timer) {
+    timer_ = timer;
+    inner_->set_timer(timer);
+}
+
+void MonitoredAudioDriver::set_rt_policy(const RtThreadPolicy& policy) {
+    rt_policy_ = policy;
+    inner_->set_rt_policy(policy);
+}
+
+RtThreadStatus MonitoredAudioDriver::get_rt_status() const {
+    return inner_->get_rt_status();
+}
+
+bool MonitoredAudioDriver::is_running() const {
+    return inner_->is_running();
+}
+
+uint32_t MonitoredAudioDriver::get_sample_rate() const {
+    return inner_->get_sample_rate();
+}
+
+uint32_t MonitoredAudioDriver::get_buffer_frames() const {
+    return inner_->get_buffer_frames();
+}
+
+float MonitoredAudioDriver::get_latency_ms() const {
+    return inner_->get_latency_ms();
+}
+
+} // namespace pal
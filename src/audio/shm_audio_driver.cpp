@@ -0,0 +1,424 @@
+/**
+ * @file shm_audio_driver.cpp
+ * @brief Shared-memory audio transport implementation (Linux)
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/audio/shm_audio_driver.h"
+#include "pal/audio_ring.h"
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+namespace pal {
+
+/**
+ * @brief Segment header, followed by the RX ring then the TX ring
+ *
+ * Server-written and consumer-written fields live on separate cache lines.
+ * All positions are free-running frame counters. rx_head and tx_tail
+ * advance together by the RX frames published each period, so TX index
+ * k is played in the period that captures RX index k. tx_head may fall
+ * behind tx_tail when the consumer is late or absent.
+ */
+struct ShmAudioLayout {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t capacity;                          // Frames per ring, power of two
+
+    // Server side
+    alignas(PAL_CACHE_LINE) std::atomic<uint64_t> rx_head;
+    std::atomic<uint64_t> tx_tail;
+    std::atomic<uint32_t> rx_signal;            // Futex word, bumped on every publish
+    std::atomic<uint64_t> rx_overruns;
+    std::atomic<uint64_t> tx_underruns;
+
+    // Consumer side
+    alignas(PAL_CACHE_LINE) std::atomic<uint64_t> rx_tail;
+    std::atomic<uint64_t> tx_head;
+    std::atomic<uint32_t> consumer_waiting;
+
+    float* rx_ring() { return reinterpret_cast<float*>(this + 1); }
+    float* tx_ring() { return rx_ring() + capacity; }
+};
+
+namespace {
+
+constexpr uint32_t SHM_MAGIC = 0x50414C41;     // "PALA"
+constexpr uint32_t SHM_VERSION = 1;
+
+// Consumer wakes at least this often to notice stop() or a closed server
+constexpr long WAIT_TIMEOUT_NS = 100 * 1000 * 1000;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared rings need lock-free 64-bit atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain uint32_t");
+
+size_t segment_bytes(uint32_t capacity) {
+    return sizeof(ShmAudioLayout) + 2 * static_cast<size_t>(capacity) * sizeof(float);
+}
+
+// Shared (not process-private) futex operations
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected) {
+    timespec timeout{0, WAIT_TIMEOUT_NS};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void bump(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// ---- ShmAudioServer -------------------------------------------------------
+
+ShmAudioServer::ShmAudioServer(const ShmAudioConfig& config)
+    : config_(config)
+{
+}
+
+ShmAudioServer::~ShmAudioServer() {
+    close();
+}
+
+bool ShmAudioServer::create(const std::string& name, uint32_t sample_rate) {
+    close();
+    if (sample_rate == 0 || config_.capacity_frames == 0) return false;
+
+    uint32_t capacity = 1;
+    while (capacity < config_.capacity_frames) capacity <<= 1;
+
+    // A stale segment from a crashed server is replaced, not reused
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return false;
+
+    size_t bytes = segment_bytes(capacity);
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // ftruncate zero-fills, so the rings start out as silence
+    ShmAudioLayout* layout = new (map) ShmAudioLayout;
+    layout->version = SHM_VERSION;
+    layout->sample_rate = sample_rate;
+    layout->capacity = capacity;
+    layout->rx_head.store(0, std::memory_order_relaxed);
+    layout->tx_tail.store(0, std::memory_order_relaxed);
+    layout->rx_signal.store(0, std::memory_order_relaxed);
+    layout->rx_overruns.store(0, std::memory_order_relaxed);
+    layout->tx_underruns.store(0, std::memory_order_relaxed);
+    layout->rx_tail.store(0, std::memory_order_relaxed);
+    layout->tx_head.store(0, std::memory_order_relaxed);
+    layout->consumer_waiting.store(0, std::memory_order_relaxed);
+    layout->magic.store(SHM_MAGIC, std::memory_order_release);   // Consumers may attach now
+
+    name_ = name;
+    layout_ = layout;
+    map_bytes_ = bytes;
+    reported_overruns_ = 0;
+    reported_underruns_ = 0;
+    return true;
+}
+
+void ShmAudioServer::close() {
+    if (!layout_) return;
+
+    // Tell an attached consumer the server is gone before unmapping
+    layout_->magic.store(0, std::memory_order_release);
+    layout_->rx_signal.fetch_add(1);
+    futex_wake(&layout_->rx_signal);
+
+    munmap(layout_, map_bytes_);
+    shm_unlink(name_.c_str());
+    layout_ = nullptr;
+    map_bytes_ = 0;
+}
+
+void ShmAudioServer::attach(IAudioDriver& driver) {
+    driver.set_audio_callback(
+        [this](const float* rx, float* tx, size_t n) { process(rx, tx, n); });
+}
+
+void ShmAudioServer::process(const float* rx_samples, float* tx_samples, size_t num_samples) {
+    ShmAudioLayout* l = layout_;
+    if (!l) {
+        std::fill(tx_samples, tx_samples + num_samples, 0.0f);
+        return;
+    }
+    const uint64_t capacity = l->capacity;
+    const uint64_t mask = capacity - 1;
+
+    // RX: publish what fits, drop the rest
+    uint64_t head = l->rx_head.load(std::memory_order_relaxed);
+    uint64_t tail = l->rx_tail.load(std::memory_order_acquire);
+    size_t count = std::min<size_t>(num_samples, static_cast<size_t>(capacity - (head - tail)));
+    size_t offset = static_cast<size_t>(head & mask);
+    size_t first = std::min<size_t>(count, static_cast<size_t>(capacity - offset));
+    std::memcpy(l->rx_ring() + offset, rx_samples, first * sizeof(float));
+    std::memcpy(l->rx_ring(), rx_samples + first, (count - first) * sizeof(float));
+    l->rx_head.store(head + count, std::memory_order_release);
+    if (count < num_samples) bump(l->rx_overruns);
+
+    // Wake the consumer only if it is (about to be) asleep
+    l->rx_signal.fetch_add(1);
+    if (l->consumer_waiting.load()) futex_wake(&l->rx_signal);
+
+    // TX: play what the consumer queued, pad with silence. The play
+    // position advances with the RX published above so TX index k stays
+    // locked to RX index k, whether or not the consumer kept up.
+    size_t published = count;
+    uint64_t tx_tail = l->tx_tail.load(std::memory_order_relaxed);
+    uint64_t tx_head = l->tx_head.load(std::memory_order_acquire);
+    count = tx_head > tx_tail
+        ? std::min<size_t>(published, static_cast<size_t>(tx_head - tx_tail)) : 0;
+    offset = static_cast<size_t>(tx_tail & mask);
+    first = std::min<size_t>(count, static_cast<size_t>(capacity - offset));
+    std::memcpy(tx_samples, l->tx_ring() + offset, first * sizeof(float));
+    std::memcpy(tx_samples + first, l->tx_ring(), (count - first) * sizeof(float));
+    std::fill(tx_samples + count, tx_samples + num_samples, 0.0f);
+    l->tx_tail.store(tx_tail + published, std::memory_order_release);
+    if (count < num_samples) bump(l->tx_underruns);
+}
+
+void ShmAudioServer::emit_events(IEventHandler& events, const std::string& source) {
+    uint64_t overruns = get_rx_overruns();
+    uint64_t underruns = get_tx_underruns();
+
+    if (overruns != reported_overruns_) {
+        Event event{};
+        event.type = EventType::AUDIO_OVERRUN;
+        event.source = source;
+        event.message = "RX dropped, consumer not reading";
+        event.code = static_cast<int32_t>(overruns - reported_overruns_);
+        events.emit(event);
+        reported_overruns_ = overruns;
+    }
+    if (underruns != reported_underruns_) {
+        Event event{};
+        event.type = EventType::AUDIO_UNDERRUN;
+        event.source = source;
+        event.message = "TX padded with silence";
+        event.code = static_cast<int32_t>(underruns - reported_underruns_);
+        events.emit(event);
+        reported_underruns_ = underruns;
+    }
+}
+
+uint64_t ShmAudioServer::get_rx_index() const {
+    return layout_ ? layout_->rx_head.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t ShmAudioServer::get_rx_overruns() const {
+    return layout_ ? layout_->rx_overruns.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t ShmAudioServer::get_tx_underruns() const {
+    return layout_ ? layout_->tx_underruns.load(std::memory_order_relaxed) : 0;
+}
+
+// ---- ShmAudioDriver -------------------------------------------------------
+
+ShmAudioDriver::ShmAudioDriver(const ShmAudioConfig& config)
+    : config_(config)
+{
+}
+
+ShmAudioDriver::~ShmAudioDriver() {
+    shutdown();
+}
+
+bool ShmAudioDriver::initialize(const std::string& device_name,
+                                uint32_t sample_rate,
+                                uint32_t buffer_frames) {
+    shutdown();
+    if (buffer_frames == 0) return false;
+
+    int fd = shm_open(device_name.c_str(), O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ShmAudioLayout)) {
+        map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    layout_ = static_cast<ShmAudioLayout*>(map);
+    map_bytes_ = static_cast<size_t>(st.st_size);
+
+    bool ok = layout_->magic.load(std::memory_order_acquire) == SHM_MAGIC &&
+              layout_->version == SHM_VERSION &&
+              layout_->sample_rate == sample_rate &&
+              map_bytes_ >= segment_bytes(layout_->capacity) &&
+              buffer_frames <= layout_->capacity;
+    if (!ok) {
+        shutdown();
+        return false;
+    }
+
+    sample_rate_ = sample_rate;
+    buffer_frames_ = buffer_frames;
+    scratch_.assign(buffer_frames_, 0.0f);
+
+    // Resume at the server's current position; anything older is stale
+    layout_->rx_tail.store(layout_->rx_head.load(std::memory_order_acquire),
+                           std::memory_order_release);
+
+    // Queue silence up to prefill frames ahead of the play position, so
+    // the server's next period finds TX waiting (stale TX is skipped)
+    uint64_t prefill = config_.tx_prefill_frames ? config_.tx_prefill_frames : buffer_frames_;
+    prefill = std::min<uint64_t>(prefill, layout_->capacity);
+    uint64_t tx_tail = layout_->tx_tail.load(std::memory_order_acquire);
+    uint64_t tx_head = std::max(layout_->tx_head.load(std::memory_order_relaxed), tx_tail);
+    const uint64_t mask = layout_->capacity - 1;
+    for (; tx_head < tx_tail + prefill; tx_head++) {
+        layout_->tx_ring()[tx_head & mask] = 0.0f;
+    }
+    layout_->tx_head.store(tx_head, std::memory_order_release);
+
+    tx_overruns_.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void ShmAudioDriver::shutdown() {
+    stop();
+    if (layout_) munmap(layout_, map_bytes_);
+    layout_ = nullptr;
+    map_bytes_ = 0;
+}
+
+bool ShmAudioDriver::start() {
+    if (!layout_ || running_.load()) return false;
+    if (thread_.joinable()) thread_.join();
+
+    stop_requested_.store(false);
+    running_.store(true);
+    thread_ = std::thread(&ShmAudioDriver::run, this);
+    return true;
+}
+
+void ShmAudioDriver::stop() {
+    stop_requested_.store(true);
+    if (thread_.joinable()) thread_.join();
+}
+
+bool ShmAudioDriver::process_available() {
+    ShmAudioLayout* l = layout_;
+    const uint64_t capacity = l->capacity;
+    const uint64_t mask = capacity - 1;
+
+    uint64_t tail = l->rx_tail.load(std::memory_order_relaxed);
+    uint64_t head = l->rx_head.load(std::memory_order_acquire);
+    if (head == tail) return false;
+
+    AudioBlockInfo info;
+    while (tail != head) {
+        // Largest block that is contiguous in the RX ring
+        size_t rx_offset = static_cast<size_t>(tail & mask);
+        size_t n = static_cast<size_t>(std::min<uint64_t>({head - tail, buffer_frames_,
+                                                           capacity - rx_offset}));
+
+        // TX goes straight into the ring when there's room, else it's dropped.
+        // If the server already played past our position, jump forward.
+        uint64_t tx_tail = l->tx_tail.load(std::memory_order_acquire);
+        uint64_t tx_head = std::max(l->tx_head.load(std::memory_order_relaxed), tx_tail);
+        uint64_t tx_space = capacity - (tx_head - tx_tail);
+        size_t tx_offset = static_cast<size_t>(tx_head & mask);
+        float* tx = scratch_.data();
+        if (tx_space > 0) {
+            n = static_cast<size_t>(std::min<uint64_t>({n, tx_space, capacity - tx_offset}));
+            tx = l->tx_ring() + tx_offset;
+        } else {
+            tx_overruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        info.rx_sample_index = tail;
+        info.tx_sample_index = tx_head;
+        callback_(info, l->rx_ring() + rx_offset, tx, n);
+
+        if (tx != scratch_.data()) {
+            l->tx_head.store(tx_head + n, std::memory_order_release);
+        }
+        tail += n;
+        l->rx_tail.store(tail, std::memory_order_release);
+    }
+    return true;
+}
+
+void ShmAudioDriver::run() {
+    rt_status_.store(apply_rt_policy(rt_policy_));
+    ShmAudioLayout* l = layout_;
+
+    while (!stop_requested_.load(std::memory_order_relaxed) &&
+           l->magic.load(std::memory_order_acquire) == SHM_MAGIC) {
+        if (process_available()) continue;
+
+        // Read the futex word before re-checking, so a publish in between
+        // makes futex_wait return immediately instead of being missed
+        uint32_t signal = l->rx_signal.load();
+        l->consumer_waiting.store(1);
+        if (l->rx_head.load() == l->rx_tail.load(std::memory_order_relaxed)) {
+            futex_wait(&l->rx_signal, signal);
+        }
+        l->consumer_waiting.store(0);
+    }
+
+    running_.store(false);
+}
+
+void ShmAudioDriver::set_audio_callback(AudioCallback callback) {
+    callback_.set(std::move(callback));
+}
+
+void ShmAudioDriver::set_audio_callback(AudioCallbackFn fn, void* context) {
+    callback_.set(fn, context);
+}
+
+void ShmAudioDriver::set_timed_audio_callback(TimedAudioCallback callback) {
+    callback_.set_timed(std::move(callback));
+}
+
+bool ShmAudioDriver::is_running() const {
+    return running_.load();
+}
+
+uint32_t ShmAudioDriver::get_sample_rate() const {
+    return sample_rate_;
+}
+
+uint32_t ShmAudioDriver::get_buffer_frames() const {
+    return buffer_frames_;
+}
+
+float ShmAudioDriver::get_latency_ms() const {
+    if (!layout_ || sample_rate_ == 0) return 0.0f;
+    uint64_t tx_head = layout_->tx_head.load(std::memory_order_relaxed);
+    uint64_t tx_tail = layout_->tx_tail.load(std::memory_order_relaxed);
+    uint64_t queued = tx_head > tx_tail ? tx_head - tx_tail : 0;
+    return 1000.0f * (buffer_frames_ + queued) / sample_rate_;
+}
+
+} // namespace pal
@@ -0,0 +1,147 @@
+/**
+ * @file agc.cpp
+ * @brief Block-floating AGC implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/agc.h"
+#include "pal/resampler.h"
+#include "pal/events.h"
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+
+namespace pal {
+
+namespace {
+
+// Floor for the detector so silence doesn't drive the gain to infinity
+constexpr float LEVEL_FLOOR = 1e-6f;
+
+float db_to_linear(float db) {
+    return std::pow(10.0f, db / 20.0f);
+}
+
+float linear_to_db(float value) {
+    return 20.0f * std::log10(std::max(value, LEVEL_FLOOR));
+}
+
+// One-pole smoothing coefficient for a time constant applied once every
+// `samples` samples
+float smoothing_coeff(float time_ms, float sample_rate, size_t samples) {
+    if (time_ms <= 0.0f) return 1.0f;
+    float tau_samples = time_ms * 0.001f * sample_rate;
+    return 1.0f - std::exp(-static_cast<float>(samples) / tau_samples);
+}
+
+} // namespace
+
+Agc::Agc(const AgcConfig& config)
+    : config_(config)
+    , telemetry_gain_(1.0f)
+    , telemetry_level_(0.0f)
+{
+    if (config_.sub_block == 0) config_.sub_block = 1;
+
+    attack_coeff_ = smoothing_coeff(config_.attack_ms, config_.sample_rate, config_.sub_block);
+    decay_coeff_ = smoothing_coeff(config_.decay_ms, config_.sample_rate, config_.sub_block);
+    max_gain_ = db_to_linear(config_.max_gain_db);
+    min_gain_ = db_to_linear(config_.min_gain_db);
+    inv_sub_block_ = 1.0f / static_cast<float>(config_.sub_block);
+
+    reset();
+}
+
+void Agc::reset() {
+    envelope_ = config_.target_level;
+    gain_ = 1.0f;
+    telemetry_gain_.store(gain_, std::memory_order_relaxed);
+    telemetry_level_.store(0.0f, std::memory_order_relaxed);
+}
+
+void Agc::process(float* samples, size_t count) {
+    size_t pos = 0;
+    while (pos < count) {
+        size_t len = std::min(config_.sub_block, count - pos);
+        process_sub_block(samples + pos, len);
+        pos += len;
+    }
+
+    telemetry_gain_.store(gain_, std::memory_order_relaxed);
+    telemetry_level_.store(envelope_, std::memory_order_relaxed);
+}
+
+void Agc::process_sub_block(float* samples, size_t count) {
+    // Peak detection (vectorizable max reduction)
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        peak = std::max(peak, std::abs(samples[i]));
+    }
+
+    // Envelope follower: fast attack, slow decay
+    float attack = attack_coeff_;
+    float decay = decay_coeff_;
+    float step_scale = inv_sub_block_;
+    if (count != config_.sub_block) {
+        attack = smoothing_coeff(config_.attack_ms, config_.sample_rate, count);
+        decay = smoothing_coeff(config_.decay_ms, config_.sample_rate, count);
+        step_scale = 1.0f / static_cast<float>(count);
+    }
+    float coeff = (peak > envelope_) ? attack : decay;
+    envelope_ += coeff * (peak - envelope_);
+
+    // Single divide per sub-block
+    float target_gain = config_.target_level / std::max(envelope_, LEVEL_FLOOR);
+    target_gain = std::min(std::max(target_gain, min_gain_), max_gain_);
+
+    // Ramp from the previous gain to the new one across the sub-block
+    float start = gain_;
+    float step = (target_gain - start) * step_scale;
+    for (size_t i = 0; i < count; i++) {
+        samples[i] *= start + step * static_cast<float>(i + 1);
+    }
+
+    gain_ = target_gain;
+}
+
+size_t Agc::decimate(Resampler& resampler, const float* input, size_t input_count, float* output) {
+    size_t chunk = config_.sub_block * static_cast<size_t>(resampler.get_ratio());
+    size_t output_count = 0;
+
+    for (size_t pos = 0; pos < input_count; pos += chunk) {
+        size_t len = std::min(chunk, input_count - pos);
+        size_t produced = resampler.decimate(input + pos, len, output + output_count);
+        process(output + output_count, produced);
+        output_count += produced;
+    }
+
+    return output_count;
+}
+
+float Agc::get_gain_db() const {
+    return linear_to_db(telemetry_gain_.load(std::memory_order_relaxed));
+}
+
+float Agc::get_level_dbfs() const {
+    return linear_to_db(telemetry_level_.load(std::memory_order_relaxed));
+}
+
+void Agc::emit_events(IEventHandler& events) const {
+    float gain_db = get_gain_db();
+    float level_dbfs = get_level_dbfs();
+
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "gain=%.1f dB level=%.1f dBFS", gain_db, level_dbfs);
+
+    Event event{};
+    event.type = EventType::AUDIO_LEVEL;
+    event.source = "agc";
+    event.message = buf;
+    event.code = static_cast<int32_t>(std::lround(gain_db * 10.0f));
+    events.emit(event);
+}
+
+} // namespace pal
@@ -0,0 +1,59 @@
+/**
+ * @file fractional_resampler.cpp
+ * @brief Variable-ratio cubic resampler implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/fractional_resampler.h"
+
+namespace pal {
+
+FractionalResampler::FractionalResampler(double ratio)
+    : ratio_(ratio)
+{
+    reset();
+}
+
+void FractionalResampler::reset() {
+    mu_ = 1.0;          // First output needs one fresh input
+    hist_[0] = hist_[1] = hist_[2] = hist_[3] = 0.0f;
+}
+
+size_t FractionalResampler::process(const float* input, size_t input_count,
+                                    float* output, size_t output_count,
+                                    size_t* consumed) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (out < output_count) {
+        // Slide the window until the output position is inside [hist_[1], hist_[2])
+        while (mu_ >= 1.0) {
+            if (in == input_count) {
+                *consumed = in;
+                return out;
+            }
+            hist_[0] = hist_[1];
+            hist_[1] = hist_[2];
+            hist_[2] = hist_[3];
+            hist_[3] = input[in++];
+            mu_ -= 1.0;
+        }
+
+        // Catmull-Rom spline between hist_[1] and hist_[2]
+        float t = static_cast<float>(mu_);
+        float a = -0.5f * hist_[0] + 1.5f * hist_[1] - 1.5f * hist_[2] + 0.5f * hist_[3];
+        float b = hist_[0] - 2.5f * hist_[1] + 2.0f * hist_[2] - 0.5f * hist_[3];
+        float c = -0.5f * hist_[0] + 0.5f * hist_[2];
+        output[out++] = ((a * t + b) * t + c) * t + hist_[1];
+
+        mu_ += ratio_;
+    }
+
+    *consumed = in;
+    return out;
+}
+
+} // namespace pal
@@ -0,0 +1,107 @@
+/**
+ * @file hilbert.cpp
+ * @brief Hilbert transformer implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/hilbert.h"
+#include "pal/resampler.h"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace pal {
+
+Hilbert::Hilbert(int num_taps)
+{
+    // Length must be 4k+3 so the outermost taps are non-zero
+    num_taps = std::max(num_taps, 3);
+    while ((num_taps % 4) != 3) num_taps++;
+
+    num_taps_ = num_taps;
+    half_len_ = (num_taps - 1) / 2;
+    coeffs_.resize((half_len_ + 1) / 2);
+    work_.assign(num_taps_ - 1 + BLOCK, 0.0f);
+
+    design_filter();
+}
+
+void Hilbert::design_filter() {
+    // Half-band lowpass h_hb[n] = sin(pi*n/2) / (pi*n), windowed, then
+    // modulated to Fs/4: h[n] = 2 * h_hb[n] * sin(pi*n/2) for odd n,
+    // 0 for even n. That reduces to the ideal 2/(pi*n) times the window.
+    int M = num_taps_ - 1;
+    for (size_t k = 0; k < coeffs_.size(); k++) {
+        int n = static_cast<int>(2 * k + 1);
+        float ideal = 2.0f / (M_PI * n);
+
+        // Hamming window at tap index half_len_ + n
+        float window = 0.54f - 0.46f * std::cos(2.0f * M_PI * (half_len_ + n) / M);
+
+        coeffs_[k] = ideal * window;
+    }
+}
+
+void Hilbert::process(const float* input, size_t count, float* out_i, float* out_q) {
+    size_t hist = static_cast<size_t>(num_taps_ - 1);
+
+    for (size_t pos = 0; pos < count; pos += BLOCK) {
+        size_t len = std::min(BLOCK, count - pos);
+        std::memcpy(&work_[hist], input + pos, len * sizeof(float));
+        process_block(len, out_i + pos, out_q + pos);
+    }
+}
+
+void Hilbert::process_block(size_t count, float* out_i, float* out_q) {
+    size_t hist = static_cast<size_t>(num_taps_ - 1);
+    const float* w = work_.data();
+    size_t center = static_cast<size_t>(half_len_);
+
+    // I: input delayed to the filter center
+    std::memcpy(out_i, w + center, count * sizeof(float));
+
+    // Q: only odd offsets, antisymmetric pairs folded
+    std::fill(out_q, out_q + count, 0.0f);
+    for (size_t k = 0; k < coeffs_.size(); k++) {
+        size_t n = 2 * k + 1;
+        float c = coeffs_[k];
+        const float* older = w + center - n;
+        const float* newer = w + center + n;
+        for (size_t t = 0; t < count; t++) {
+            out_q[t] += c * (older[t] - newer[t]);
+        }
+    }
+
+    // Keep the last num_taps-1 samples as history for the next block
+    std::memmove(work_.data(), work_.data() + count, hist * sizeof(float));
+}
+
+size_t Hilbert::decimate(Resampler& resampler, const float* input, size_t input_count,
+                         float* out_i, float* out_q) {
+    size_t hist = static_cast<size_t>(num_taps_ - 1);
+    size_t chunk = BLOCK * static_cast<size_t>(resampler.get_ratio());
+    size_t output_count = 0;
+
+    // Decimate straight into the work buffer, no intermediate copy
+    for (size_t pos = 0; pos < input_count; pos += chunk) {
+        size_t len = std::min(chunk, input_count - pos);
+        size_t produced = resampler.decimate(input + pos, len, &work_[hist]);
+        process_block(produced, out_i + output_count, out_q + output_count);
+        output_count += produced;
+    }
+
+    return output_count;
+}
+
+void Hilbert::reset() {
+    std::fill(work_.begin(), work_.end(), 0.0f);
+}
+
+} // namespace pal
@@ -0,0 +1,226 @@
+/**
+ * @file ptt_scheduler.cpp
+ * @brief PTT keying scheduled against the TX sample clock
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/ptt_scheduler.h"
+#include "pal/radio.h"
+#include "pal/timer.h"
+#include "pal/tx_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace pal {
+
+namespace {
+
+// Re-check interval while no audio callback has reported a TX time yet
+constexpr uint64_t CLOCK_POLL_US = 5000;
+
+} // namespace
+
+PttScheduler::PttScheduler(IRadio& radio, const ITimer& timer, const PttSchedulerConfig& config)
+    : radio_(radio)
+    , timer_(timer)
+    , config_(config)
+{
+}
+
+PttScheduler::~PttScheduler() {
+    stop();
+}
+
+bool PttScheduler::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load() || config_.sample_rate == 0) return false;
+    if (thread_.joinable()) thread_.join();
+
+    pending_.clear();
+    stop_requested_ = false;
+    cancel_requested_ = false;
+    running_.store(true);
+    thread_ = std::thread(&PttScheduler::run, this);
+    return true;
+}
+
+void PttScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_requested_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    running_.store(false);
+}
+
+void PttScheduler::update_clock(const AudioBlockInfo& info) {
+    if (info.tx_time_us == 0) return;   // Driver has no timer
+
+    // Single writer seqlock: odd sequence while the pair is inconsistent
+    uint32_t seq = clock_seq_.load(std::memory_order_relaxed);
+    clock_seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    clock_index_.store(info.tx_sample_index, std::memory_order_relaxed);
+    clock_time_us_.store(info.tx_time_us, std::memory_order_relaxed);
+    clock_seq_.store(seq + 2, std::memory_order_release);
+}
+
+bool PttScheduler::read_clock(uint64_t* index, uint64_t* time_us) const {
+    for (;;) {
+        uint32_t seq = clock_seq_.load(std::memory_order_acquire);
+        if (seq == 0) return false;
+        if (seq & 1) continue;
+        *index = clock_index_.load(std::memory_order_relaxed);
+        *time_us = clock_time_us_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (clock_seq_.load(std::memory_order_relaxed) == seq) return true;
+    }
+}
+
+uint64_t PttScheduler::index_to_time_us(uint64_t index) const {
+    uint64_t anchor_index = 0;
+    uint64_t anchor_time = 0;
+    if (!read_clock(&anchor_index, &anchor_time)) return 0;
+
+    int64_t frames = static_cast<int64_t>(index - anchor_index);
+    int64_t time = static_cast<int64_t>(anchor_time) +
+                   frames * 1000000 / static_cast<int64_t>(config_.sample_rate);
+    return time > 0 ? static_cast<uint64_t>(time) : 1;
+}
+
+uint64_t PttScheduler::key_advance_us() const {
+    const PttTiming& t = config_.timing;
+    return static_cast<uint64_t>(t.lead_us) + t.key_up_delay_us +
+           serial_wire_time_us(t.serial, t.key_command_bytes);
+}
+
+bool PttScheduler::schedule(uint64_t first_index, uint64_t count) {
+    if (count == 0) return false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load() || stop_requested_) return false;
+        pending_.push_back(Span{first_index, first_index + count});
+    }
+    wake_.notify_all();
+    return true;
+}
+
+bool PttScheduler::schedule(const TxBurst& burst) {
+    if (burst.start_index == TX_START_ASAP) return false;
+    return schedule(burst.start_index, burst.samples.size());
+}
+
+void PttScheduler::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        cancel_requested_ = true;
+    }
+    wake_.notify_all();
+}
+
+void PttScheduler::emit_events(IEventHandler& events) {
+    std::vector<Event> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready.swap(events_);
+    }
+    for (const Event& event : ready) events.emit(event);
+}
+
+// Called by the worker with mutex_ held; the radio call runs unlocked so a
+// slow serial write doesn't block schedule() or cancel()
+void PttScheduler::set_ptt(bool transmit, uint64_t target_us) {
+    mutex_.unlock();
+    radio_.set_ptt(transmit);
+    uint64_t done_us = timer_.get_time_us();
+    mutex_.lock();
+
+    keyed_.store(transmit, std::memory_order_relaxed);
+
+    int64_t error = static_cast<int64_t>(done_us - target_us);
+    error = std::max<int64_t>(error, std::numeric_limits<int32_t>::min());
+    error = std::min<int64_t>(error, std::numeric_limits<int32_t>::max());
+
+    Event event{};
+    event.type = transmit ? EventType::PTT_ON : EventType::PTT_OFF;
+    event.timestamp_ms = done_us / 1000;
+    event.source = config_.source;
+    event.message = transmit ? "Keyed on TX sample clock" : "Unkeyed after last TX sample";
+    event.code = static_cast<int32_t>(error);
+    events_.push_back(event);
+}
+
+void PttScheduler::run() {
+    rt_status_.store(apply_rt_policy(config_.rt));
+
+    const uint64_t advance = key_advance_us();
+    const uint64_t tail = config_.timing.tail_us;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_requested_) {
+        uint64_t now = timer_.get_time_us();
+        uint64_t wake_at = 0;
+
+        if (keyed_.load(std::memory_order_relaxed)) {
+            uint64_t off_at = index_to_time_us(keyed_end_) + tail;
+
+            // Stay keyed through transmissions that would need PTT again
+            // before this one has been released
+            while (!cancel_requested_ && !pending_.empty()) {
+                const Span& next = pending_.front();
+                uint64_t next_time = index_to_time_us(next.first);
+                if (next.first > keyed_end_ && next_time > off_at + advance) break;
+                keyed_end_ = std::max(keyed_end_, next.end);
+                off_at = index_to_time_us(keyed_end_) + tail;
+                pending_.pop_front();
+            }
+
+            if (cancel_requested_ || now >= off_at) {
+                uint64_t target = cancel_requested_ ? now : off_at;
+                cancel_requested_ = false;
+                set_ptt(false, target);
+                continue;
+            }
+            wake_at = off_at;
+        } else {
+            cancel_requested_ = false;
+            if (pending_.empty()) {
+                wake_.wait(lock);
+                continue;
+            }
+
+            uint64_t first_time = index_to_time_us(pending_.front().first);
+            if (first_time == 0) {
+                wake_at = now + CLOCK_POLL_US;
+            } else {
+                uint64_t on_at = first_time > advance ? first_time - advance : 0;
+                if (now >= on_at) {
+                    keyed_end_ = pending_.front().end;
+                    pending_.pop_front();
+                    if (now > on_at + config_.timing.lead_us) {
+                        late_keys_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    set_ptt(true, on_at);
+                    continue;
+                }
+                wake_at = on_at;
+            }
+        }
+
+        // Sleep until due; schedule/cancel/stop wake us early and the clock
+        // anchor is re-read on every pass
+        wake_.wait_for(lock, std::chrono::microseconds(wake_at - now));
+    }
+
+    if (keyed_.load(std::memory_order_relaxed)) {
+        set_ptt(false, timer_.get_time_us());
+    }
+}
+
+} // namespace pal
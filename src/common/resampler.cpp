@@ -70,12 +70,13 @@ float Resampler::apply_filter() const {
     return sum;
 }
 
-size_t Resampler::decimate(const float* input, size_t input_count, float* output) {
+template <typename T>
+size_t Resampler::decimate_strided(const T* input, size_t stride, size_t count, float* output) {
     size_t output_count = 0;
     
-    for (size_t i = 0; i < input_count; i++) {
+    for (size_t i = 0; i < count; i++) {
         // Add sample to circular history buffer
-        history_[history_pos_] = input[i];
+        history_[history_pos_] = sample_to_float(input[i * stride]);
         history_pos_ = (history_pos_ + 1) % total_taps_;
         
         // Output every ratio_ samples
@@ -87,10 +88,11 @@ size_t Resampler::decimate(const float* input, size_t input_count, float* output
     return output_count;
 }
 
-size_t Resampler::interpolate(const float* input, size_t input_count, float* output) {
+template <typename T>
+size_t Resampler::interpolate_strided(const float* input, size_t count, T* output, size_t stride) {
     size_t output_count = 0;
     
-    for (size_t i = 0; i < input_count; i++) {
+    for (size_t i = 0; i < count; i++) {
         // For each input sample, produce ratio_ output samples
         for (int phase = 0; phase < ratio_; phase++) {
             // Insert input sample at phase 0, zeros elsewhere
@@ -99,13 +101,56 @@ size_t Resampler::interpolate(const float* input, size_t input_count, float* out
             history_[history_pos_] = sample;
             history_pos_ = (history_pos_ + 1) % total_taps_;
             
-            output[output_count++] = apply_filter();
+            output[output_count++ * stride] = float_to_sample<T>(apply_filter());
         }
     }
     
     return output_count;
 }
 
+size_t Resampler::decimate(const float* input, size_t input_count, float* output) {
+    return decimate_strided(input, 1, input_count, output);
+}
+
+size_t Resampler::interpolate(const float* input, size_t input_count, float* output) {
+    return interpolate_strided(input, input_count, output, 1);
+}
+
+size_t Resampler::decimate(const void* input, const AudioFormat& format,
+                           size_t input_frames, float* output) {
+    switch (format.format) {
+        case SampleFormat::S16:
+            return decimate_strided(static_cast<const int16_t*>(input) + format.radio_channel,
+                                    format.channels, input_frames, output);
+        case SampleFormat::S32:
+            return decimate_strided(static_cast<const int32_t*>(input) + format.radio_channel,
+                                    format.channels, input_frames, output);
+        case SampleFormat::F32:
+            return decimate_strided(static_cast<const float*>(input) + format.radio_channel,
+                                    format.channels, input_frames, output);
+    }
+    return 0;
+}
+
+size_t Resampler::interpolate(const float* input, size_t input_count,
+                              void* output, const AudioFormat& format) {
+    switch (format.format) {
+        case SampleFormat::S16:
+            return interpolate_strided(input, input_count,
+                                       static_cast<int16_t*>(output) + format.radio_channel,
+                                       format.channels);
+        case SampleFormat::S32:
+            return interpolate_strided(input, input_count,
+                                       static_cast<int32_t*>(output) + format.radio_channel,
+                                       format.channels);
+        case SampleFormat::F32:
+            return interpolate_strided(input, input_count,
+                                       static_cast<float*>(output) + format.radio_channel,
+                                       format.channels);
+    }
+    return 0;
+}
+
 void Resampler::reset() {
     std::fill(history_.begin(), history_.end(), 0.0f);
     history_pos_ = 0;
@@ -0,0 +1,201 @@
+/**
+ * @file rt_thread.cpp
+ * @brief Real-time thread policy implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/rt_thread.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PAL_HAVE_PTHREAD_SCHED 1
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#else
+#define PAL_HAVE_PTHREAD_SCHED 0
+#endif
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if defined(_MSC_VER)
+#define PAL_NOINLINE __declspec(noinline)
+#else
+#define PAL_NOINLINE __attribute__((noinline))
+#endif
+
+namespace pal {
+
+namespace {
+
+constexpr size_t PREFAULT_PAGE = 4096;
+constexpr size_t PREFAULT_FRAME_SLACK = 256;        // Return address, saved registers, alignment
+constexpr size_t PREFAULT_STACK_RESERVE = 64 * 1024; // Left for the caller and signal handlers
+
+// Touches one page per frame so the stack below the caller is resident.
+// The write after the recursive call keeps the compiler from turning it
+// into a loop that reuses one frame; reading it back uses the array.
+PAL_NOINLINE size_t prefault_stack(size_t bytes) {
+    volatile unsigned char page[PREFAULT_PAGE];
+    page[0] = 0;
+    size_t done = PREFAULT_PAGE;
+    if (bytes > PREFAULT_PAGE) done += prefault_stack(bytes - PREFAULT_PAGE);
+    page[PREFAULT_PAGE - 1] = 0;
+    return done + page[PREFAULT_PAGE - 1];
+}
+
+// Largest request prefault_stack() can serve from the calling thread's
+// remaining stack: each page costs a frame slightly larger than a page.
+size_t clamp_stack_prefault(size_t bytes) {
+#if defined(__linux__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return bytes;
+    void* low = nullptr;
+    size_t size = 0;
+    int result = pthread_attr_getstack(&attr, &low, &size);
+    pthread_attr_destroy(&attr);
+    if (result != 0 || !low) return bytes;
+
+    unsigned char here;
+    uintptr_t sp = reinterpret_cast<uintptr_t>(&here);
+    uintptr_t bottom = reinterpret_cast<uintptr_t>(low);
+    if (sp <= bottom) return 0;
+    size_t room = sp - bottom;
+    if (room <= PREFAULT_STACK_RESERVE) return 0;
+    size_t pages = (room - PREFAULT_STACK_RESERVE) / (PREFAULT_PAGE + PREFAULT_FRAME_SLACK);
+    return bytes < pages * PREFAULT_PAGE ? bytes : pages * PREFAULT_PAGE;
+#else
+    return bytes;
+#endif
+}
+
+size_t prefault_heap(size_t bytes) {
+#if defined(__GLIBC__)
+    // Keep freed memory in the process and serve large blocks from the
+    // (locked, touched) heap instead of fresh mmap()s
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(bytes));
+    if (!block) return 0;
+    for (size_t i = 0; i < bytes; i += PREFAULT_PAGE) {
+        static_cast<volatile unsigned char*>(block)[i] = 0;
+    }
+    std::free(block);
+    return bytes;
+#else
+    (void)bytes;
+    return 0;
+#endif
+}
+
+#if PAL_HAVE_PTHREAD_SCHED
+int to_native(RtSchedClass sched) {
+    switch (sched) {
+        case RtSchedClass::FIFO: return SCHED_FIFO;
+        case RtSchedClass::RR:   return SCHED_RR;
+        default:                 return SCHED_OTHER;
+    }
+}
+
+RtSchedClass from_native(int policy) {
+    switch (policy) {
+        case SCHED_FIFO: return RtSchedClass::FIFO;
+        case SCHED_RR:   return RtSchedClass::RR;
+        default:         return RtSchedClass::OTHER;
+    }
+}
+#endif
+
+const char* sched_name(RtSchedClass sched) {
+    switch (sched) {
+        case RtSchedClass::OTHER: return "OTHER";
+        case RtSchedClass::FIFO:  return "FIFO";
+        case RtSchedClass::RR:    return "RR";
+        default:                  return "DEFAULT";
+    }
+}
+
+} // namespace
+
+RtThreadStatus apply_rt_policy(const RtThreadPolicy& policy) {
+    RtThreadStatus status;
+    status.applied = true;
+    status.sched_granted = policy.sched == RtSchedClass::DEFAULT;
+
+#if PAL_HAVE_PTHREAD_SCHED
+    pthread_t self = pthread_self();
+
+    if (policy.sched != RtSchedClass::DEFAULT) {
+        sched_param param{};
+        param.sched_priority = policy.sched == RtSchedClass::OTHER ? 0 : policy.priority;
+        pthread_setschedparam(self, to_native(policy.sched), &param);
+    }
+    int native = SCHED_OTHER;
+    sched_param current{};
+    if (pthread_getschedparam(self, &native, &current) == 0) {
+        status.sched = from_native(native);
+        status.priority = current.sched_priority;
+    }
+    status.sched_granted = status.sched_granted ||
+        (status.sched == policy.sched &&
+         (policy.sched == RtSchedClass::OTHER || status.priority == policy.priority));
+
+#if defined(__linux__)
+    cpu_set_t set;
+    if (!policy.cpus.empty()) {
+        CPU_ZERO(&set);
+        for (int cpu : policy.cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        status.affinity_granted = pthread_setaffinity_np(self, sizeof(set), &set) == 0;
+    }
+    if (pthread_getaffinity_np(self, sizeof(set), &set) == 0) {
+        status.cpu_count = CPU_COUNT(&set);
+    }
+#endif
+
+    if (policy.lock_memory) {
+        status.memory_locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+    }
+#endif
+
+    if (policy.prefault_heap_bytes) status.heap_prefaulted = prefault_heap(policy.prefault_heap_bytes);
+    size_t stack_bytes = clamp_stack_prefault(policy.prefault_stack_bytes);
+    if (stack_bytes) status.stack_prefaulted = prefault_stack(stack_bytes);
+    return status;
+}
+
+bool RtThreadStatus::satisfies(const RtThreadPolicy& policy) const {
+    if (policy.is_default()) return true;
+    if (!applied || !sched_granted) return false;
+    if (!policy.cpus.empty() && !affinity_granted) return false;
+    if (policy.lock_memory && !memory_locked) return false;
+    if (stack_prefaulted < policy.prefault_stack_bytes) return false;
+    return heap_prefaulted >= policy.prefault_heap_bytes;
+}
+
+std::string RtThreadStatus::describe() const {
+    if (!applied) return "not applied";
+
+    std::string text = sched_name(sched);
+    if (sched == RtSchedClass::FIFO || sched == RtSchedClass::RR) {
+        text += "/" + std::to_string(priority);
+    }
+    if (!sched_granted) text += " (refused)";
+    if (cpu_count) text += " cpus=" + std::to_string(cpu_count);
+    if (affinity_granted) text += " pinned";
+    if (memory_locked) text += " mlock";
+    if (stack_prefaulted || heap_prefaulted) {
+        text += " prefault=" + std::to_string((stack_prefaulted + heap_prefaulted) / 1024) + "K";
+    }
+    return text;
+}
+
+} // namespace pal
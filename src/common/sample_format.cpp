@@ -0,0 +1,75 @@
+/**
+ * @file sample_format.cpp
+ * @brief PCM sample format conversion
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/sample_format.h"
+
+namespace pal {
+
+namespace {
+
+template <typename T>
+void extract(const T* input, size_t channels, size_t channel, float* output, size_t frames) {
+    const T* src = input + channel;
+    for (size_t i = 0; i < frames; i++) {
+        output[i] = sample_to_float(src[i * channels]);
+    }
+}
+
+template <typename T>
+void insert(const float* input, size_t frames, T* output, size_t channels, size_t channel) {
+    T* dst = output + channel;
+    for (size_t i = 0; i < frames; i++) {
+        dst[i * channels] = float_to_sample<T>(input[i]);
+    }
+}
+
+} // namespace
+
+size_t sample_format_bytes(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::S16: return 2;
+        case SampleFormat::S32: return 4;
+        case SampleFormat::F32: return 4;
+        default:                return 0;
+    }
+}
+
+void convert_to_float(const void* input, SampleFormat format,
+                      size_t channels, size_t channel,
+                      float* output, size_t frames) {
+    switch (format) {
+        case SampleFormat::S16:
+            extract(static_cast<const int16_t*>(input), channels, channel, output, frames);
+            break;
+        case SampleFormat::S32:
+            extract(static_cast<const int32_t*>(input), channels, channel, output, frames);
+            break;
+        case SampleFormat::F32:
+            extract(static_cast<const float*>(input), channels, channel, output, frames);
+            break;
+    }
+}
+
+void convert_from_float(const float* input, size_t frames,
+                        void* output, SampleFormat format,
+                        size_t channels, size_t channel) {
+    switch (format) {
+        case SampleFormat::S16:
+            insert(input, frames, static_cast<int16_t*>(output), channels, channel);
+            break;
+        case SampleFormat::S32:
+            insert(input, frames, static_cast<int32_t*>(output), channels, channel);
+            break;
+        case SampleFormat::F32:
+            insert(input, frames, static_cast<float*>(output), channels, channel);
+            break;
+    }
+}
+
+} // namespace pal
@@ -0,0 +1,118 @@
+/**
+ * @file scan_list.cpp
+ * @brief Pre-encoded scan list implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/scan_list.h"
+
+namespace pal {
+
+ScanList::ScanList(IRadio& radio, const SerialConfig& serial)
+    : radio_(&radio)
+    , serial_(serial)
+{
+}
+
+void ScanList::set_channels(const std::vector<Channel>& channels) {
+    channels_ = channels;
+    position_ = 0;
+    invalidate();
+}
+
+void ScanList::add(const Channel& channel) {
+    channels_.push_back(channel);
+    invalidate();
+}
+
+void ScanList::clear() {
+    channels_.clear();
+    position_ = 0;
+    invalidate();
+}
+
+void ScanList::set_radio(IRadio& radio) {
+    radio_ = &radio;
+    invalidate();
+}
+
+void ScanList::set_serial_config(const SerialConfig& serial) {
+    serial_ = serial;
+    for (Entry& entry : entries_) {
+        entry.wire_time_us = serial_wire_time_us(serial_, entry.length);
+    }
+}
+
+bool ScanList::compile() {
+    bytes_.clear();
+    entries_.clear();
+    bytes_.reserve(channels_.size() * SCAN_MAX_CHANNEL_BYTES / 2);
+    entries_.reserve(channels_.size());
+
+    bool all_encoded = true;
+    uint8_t encoded[SCAN_MAX_CHANNEL_BYTES];
+    for (const Channel& channel : channels_) {
+        size_t length = radio_->encode_channel(channel, encoded, sizeof(encoded));
+        if (length == 0) all_encoded = false;
+        entries_.push_back({ bytes_.size(), length, serial_wire_time_us(serial_, length) });
+        bytes_.insert(bytes_.end(), encoded, encoded + length);
+    }
+
+    compiled_ = true;
+    compiled_radio_ = radio_;
+    compiled_generation_ = radio_->encoding_generation();
+    compile_count_++;
+    return all_encoded;
+}
+
+bool ScanList::is_compiled() const {
+    return compiled_ && compiled_radio_ == radio_ &&
+           compiled_generation_ == radio_->encoding_generation();
+}
+
+ScanHop ScanList::hop(size_t index) {
+    ScanHop result;
+    result.index = index;
+    if (index >= channels_.size()) {
+        last_hop_ = result;
+        return result;
+    }
+    if (!is_compiled()) compile();
+
+    const Entry& entry = entries_[index];
+    if (entry.length) {
+        result.ok = radio_->send_encoded_channel(channels_[index], bytes_.data() + entry.offset, entry.length);
+        result.bytes = entry.length;
+        result.wire_time_us = entry.wire_time_us;
+    } else {
+        result.ok = radio_->set_channel(channels_[index]);
+    }
+
+    position_ = index + 1 < channels_.size() ? index + 1 : 0;
+    last_hop_ = result;
+    return result;
+}
+
+ScanHop ScanList::next() {
+    return hop(position_ < channels_.size() ? position_ : 0);
+}
+
+const uint8_t* ScanList::bytes(size_t index) const {
+    if (!is_compiled() || index >= entries_.size() || entries_[index].length == 0) return nullptr;
+    return bytes_.data() + entries_[index].offset;
+}
+
+size_t ScanList::length(size_t index) const {
+    if (!is_compiled() || index >= entries_.size()) return 0;
+    return entries_[index].length;
+}
+
+uint32_t ScanList::wire_time_us(size_t index) const {
+    if (!is_compiled() || index >= entries_.size()) return 0;
+    return entries_[index].wire_time_us;
+}
+
+} // namespace pal
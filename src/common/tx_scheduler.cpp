@@ -0,0 +1,162 @@
+/**
+ * @file tx_scheduler.cpp
+ * @brief Pre-rendered TX burst queue implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/tx_scheduler.h"
+#include "pal/events.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace pal {
+
+TxScheduler::TxScheduler(const TxSchedulerConfig& config)
+    : config_(config)
+    , queue_(std::max<size_t>(config.max_bursts, 1))
+    , done_(std::max<size_t>(config.max_bursts, 1))
+{
+}
+
+TxScheduler::~TxScheduler() {
+    // The audio thread must be stopped by now; free whatever is left
+    TxBurst* burst = nullptr;
+    while (queue_.read(&burst, 1) == 1) delete burst;
+    while (done_.read(&burst, 1) == 1) delete burst;
+}
+
+bool TxScheduler::submit(std::unique_ptr<TxBurst> burst) {
+    if (!burst) return false;
+    if (outstanding_.load() >= std::max<size_t>(config_.max_bursts, 1)) return false;
+
+    outstanding_.fetch_add(1);
+    queued_frames_.fetch_add(static_cast<int64_t>(burst->samples.size()));
+    TxBurst* raw = burst.release();
+    queue_.write(&raw, 1);   // Can't fail: the ring holds at least max_bursts
+    return true;
+}
+
+std::unique_ptr<TxBurst> TxScheduler::reclaim() {
+    TxBurst* burst = nullptr;
+    if (done_.read(&burst, 1) == 0) return nullptr;
+    outstanding_.fetch_sub(1);
+    return std::unique_ptr<TxBurst>(burst);
+}
+
+void TxScheduler::abort() {
+    abort_requested_.store(true, std::memory_order_release);
+}
+
+void TxScheduler::attach(IAudioDriver& driver, IAudioDriver::TimedAudioCallback rx_callback) {
+    driver.set_timed_audio_callback(
+        [this, rx_callback](const AudioBlockInfo& info, const float* rx, float* tx, size_t n) {
+            render(info.tx_sample_index, tx, n);
+            if (rx_callback) rx_callback(info, rx, tx, n);
+        });
+}
+
+void TxScheduler::retire_head() {
+    // Played bursts go back to the modem; never freed on the audio thread
+    TxBurst* burst = queue_.read_regions(1).first[0];
+    queue_.commit_read(1);
+    done_.write(&burst, 1);
+    head_started_ = false;
+    head_consumed_ = 0;
+}
+
+void TxScheduler::render(uint64_t tx_index, float* tx_samples, size_t count) {
+    if (abort_requested_.exchange(false, std::memory_order_acquire)) {
+        for (auto head = queue_.read_regions(1); head.total() > 0; head = queue_.read_regions(1)) {
+            size_t left = head.first[0]->samples.size() - head_consumed_;
+            queued_frames_.fetch_sub(static_cast<int64_t>(left));
+            retire_head();
+        }
+    }
+
+    const uint64_t block_end = tx_index + count;
+    size_t pos = 0;
+    bool transmitting = false;
+
+    while (pos < count) {
+        auto head = queue_.read_regions(1);
+        if (head.total() == 0) break;
+        TxBurst* burst = head.first[0];
+        uint64_t now = tx_index + pos;
+
+        if (!head_started_) {
+            if (burst->start_index == TX_START_ASAP) {
+                burst->start_index = now;
+            } else if (burst->start_index < now) {
+                late_bursts_.fetch_add(1, std::memory_order_relaxed);
+                if (config_.late_policy == TxLatePolicy::SHIFT) burst->start_index = now;
+            }
+        }
+        if (burst->start_index >= block_end) break;     // Starts in a later block
+
+        // Silence up to the burst start
+        if (burst->start_index > now) {
+            size_t gap = static_cast<size_t>(burst->start_index - now);
+            std::memset(tx_samples + pos, 0, gap * sizeof(float));
+            pos += gap;
+            now += gap;
+        }
+
+        // TRUNCATE: samples that were already due are skipped
+        size_t size = burst->samples.size();
+        if (!head_started_) {
+            head_started_ = true;
+            head_consumed_ = static_cast<size_t>(std::min<uint64_t>(now - burst->start_index, size));
+            queued_frames_.fetch_sub(static_cast<int64_t>(head_consumed_));
+        }
+
+        size_t n = std::min(count - pos, size - head_consumed_);
+        std::memcpy(tx_samples + pos, burst->samples.data() + head_consumed_, n * sizeof(float));
+        pos += n;
+        head_consumed_ += n;
+        queued_frames_.fetch_sub(static_cast<int64_t>(n));
+        transmitting = transmitting || n > 0;
+
+        if (head_consumed_ == size) {
+            retire_head();
+            bursts_played_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::memset(tx_samples + pos, 0, (count - pos) * sizeof(float));
+
+    // Low-water detection: flag once per crossing while audio is going out
+    int64_t queued = queued_frames_.load(std::memory_order_relaxed);
+    if (queued >= static_cast<int64_t>(config_.drain_warning_frames) ||
+        (queued == 0 && !transmitting)) {
+        drain_armed_ = true;
+    } else if (transmitting && drain_armed_) {
+        drain_armed_ = false;
+        drain_frames_.store(queued, std::memory_order_relaxed);
+        drain_pending_.store(true, std::memory_order_release);
+    }
+}
+
+void TxScheduler::emit_events(IEventHandler& events) {
+    if (!drain_pending_.exchange(false, std::memory_order_acquire)) return;
+
+    int64_t frames = drain_frames_.load(std::memory_order_relaxed);
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%lld frames queued", static_cast<long long>(frames));
+
+    Event event{};
+    event.type = EventType::AUDIO_TX_DRAINING;
+    event.source = "tx_scheduler";
+    event.message = buf;
+    event.code = static_cast<int32_t>(frames);
+    events.emit(event);
+}
+
+uint64_t TxScheduler::get_queued_frames() const {
+    return static_cast<uint64_t>(std::max<int64_t>(queued_frames_.load(std::memory_order_relaxed), 0));
+}
+
+} // namespace pal
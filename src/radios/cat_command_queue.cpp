@@ -0,0 +1,409 @@
+/**
+ * @file cat_command_queue.cpp
+ * @brief CAT command queue implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/radios/cat_command_queue.h"
+#include "pal/radios/civ_codec.h"
+#include "pal/timer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace pal {
+
+namespace {
+
+// Kenwood commands that act without parameters and are not answered
+// ("TX;" keys the radio); any other bare code is a query
+bool kenwood_action(const uint8_t* code) {
+    static constexpr char ACTIONS[][2] = {
+        {'T', 'X'}, {'R', 'X'}, {'U', 'P'}, {'D', 'N'}, {'S', 'V'}, {'V', 'V'}, {'Q', 'I'},
+    };
+    for (const char* action : ACTIONS) {
+        if (code[0] == action[0] && code[1] == action[1]) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+CatCommandQueue::CatCommandQueue(WriteFunction write, const ITimer& timer,
+                                 const CatQueueConfig& config)
+    : write_(std::move(write))
+    , timer_(timer)
+    , config_(config)
+{
+    if (config_.window == 0) config_.window = 1;
+}
+
+uint64_t CatCommandQueue::submit(const uint8_t* data, size_t length,
+                                 CatCompletionCallback on_complete, size_t reply_length) {
+    if (!data || length == 0 || length > CAT_MAX_COMMAND_BYTES) return 0;
+
+    std::vector<Finished> done;
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = timer_.get_time_us();
+
+        Command command;
+        command.id = id = next_id_++;
+        std::memcpy(command.bytes.data(), data, length);
+        command.length = length;
+        command.on_complete = std::move(on_complete);
+        command.reply_length = std::min(reply_length, CAT_MAX_REPLY_BYTES);
+        command.submit_us = now;
+        command.deadline_us = now;
+        classify(command);
+
+        pending_.push_back(std::move(command));
+        stats_.submitted++;
+        pump(now, done);
+    }
+    run(done);
+    return id;
+}
+
+void CatCommandQueue::on_receive(const uint8_t* data, size_t length) {
+    std::vector<Finished> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = timer_.get_time_us();
+        switch (config_.protocol) {
+            case CatProtocol::CIV:     receive_civ(data, length, now, done); break;
+            case CatProtocol::KENWOOD: receive_kenwood(data, length, now, done); break;
+            case CatProtocol::YAESU:   receive_yaesu(data, length, now, done); break;
+        }
+        pump(now, done);
+    }
+    run(done);
+}
+
+void CatCommandQueue::poll() {
+    std::vector<Finished> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pump(timer_.get_time_us(), done);
+    }
+    run(done);
+}
+
+uint64_t CatCommandQueue::next_deadline_us() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t next = 0;
+    for (const Command& command : in_flight_) {
+        uint64_t at = command.written < command.length ? next_write_us_ : command.deadline_us;
+        if (next == 0 || at < next) next = at;
+    }
+    if (!pending_.empty() && in_flight_.size() < config_.window && !writing()) {
+        uint64_t send_at = std::max<uint64_t>({pending_.front().deadline_us, next_write_us_, 1});
+        if (next == 0 || send_at < next) next = send_at;
+    }
+    return next;
+}
+
+void CatCommandQueue::cancel_all() {
+    std::vector<Finished> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = timer_.get_time_us();
+        while (!in_flight_.empty()) {
+            finish(in_flight_.front(), CatResult::CANCELLED, now, done);
+            in_flight_.pop_front();
+        }
+        while (!pending_.empty()) {
+            finish(pending_.front(), CatResult::CANCELLED, now, done);
+            pending_.pop_front();
+        }
+        rx_size_ = 0;
+        civ_skip_ = 0;
+    }
+    run(done);
+}
+
+size_t CatCommandQueue::in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_.size();
+}
+
+size_t CatCommandQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+CatQueueStats CatCommandQueue::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CatCommandQueue::classify(Command& command) const {
+    const uint8_t* bytes = command.bytes.data();
+    size_t length = command.length;
+
+    switch (config_.protocol) {
+        case CatProtocol::CIV:
+            // One reply per FE FE ... FD frame
+            for (size_t i = 0; i + 6 <= length; ) {
+                if (bytes[i] != CIV_PREAMBLE || bytes[i + 1] != CIV_PREAMBLE) {
+                    i++;
+                    continue;
+                }
+                const uint8_t* end = static_cast<const uint8_t*>(
+                    std::memchr(bytes + i + 5, CIV_EOM, length - i - 5));
+                if (!end) break;
+                if (command.replies_expected == 0) {
+                    command.civ_radio = bytes[i + 2];
+                    command.civ_controller = bytes[i + 3];
+                }
+                if (command.replies_expected < command.civ_cmds.size()) {
+                    command.civ_cmds[command.replies_expected] = bytes[i + 4];
+                }
+                command.replies_expected++;
+                i = static_cast<size_t>(end - bytes) + 1;
+            }
+            break;
+
+        case CatProtocol::KENWOOD: {
+            // Only a trailing bare query ("FA;") is answered
+            if (length >= 3 && bytes[length - 1] == ';' && (length == 3 || bytes[length - 4] == ';') &&
+                !kenwood_action(bytes + length - 3)) {
+                command.replies_expected = 1;
+                command.kenwood_code[0] = static_cast<char>(bytes[length - 3]);
+                command.kenwood_code[1] = static_cast<char>(bytes[length - 2]);
+            }
+            break;
+        }
+
+        case CatProtocol::YAESU:
+            command.replies_expected = command.reply_length ? 1 : 0;
+            break;
+    }
+}
+
+void CatCommandQueue::pump(uint64_t now, std::vector<Finished>& done) {
+    while (!in_flight_.empty() && in_flight_.front().written == in_flight_.front().length &&
+           in_flight_.front().deadline_us <= now) {
+        stats_.timeouts++;
+        civ_skip_ = 0;                                      // Owed answers aren't coming either
+        fail_head(CatResult::TIMEOUT, now, done);
+    }
+
+    // A paced request part-way out is the newest in flight; nothing else
+    // is written until it is finished
+    if (writing() && next_write_us_ <= now) {
+        Command& command = in_flight_.back();
+        uint64_t wire_us = write_piece(command, now);
+        if (command.written == command.length) {
+            Command finished = std::move(command);
+            in_flight_.pop_back();
+            written(finished, now, wire_us, done);
+        }
+    }
+
+    while (!pending_.empty() && in_flight_.size() < config_.window && !writing() &&
+           pending_.front().deadline_us <= now && next_write_us_ <= now) {
+        Command command = std::move(pending_.front());
+        pending_.pop_front();
+        write(command, now, done);
+    }
+}
+
+void CatCommandQueue::write(Command& command, uint64_t now, std::vector<Finished>& done) {
+    command.attempts++;
+    command.write_us = now;
+    command.written = 0;
+    command.replies_received = 0;
+    command.reply_size = 0;
+
+    uint64_t wire_us = write_piece(command, now);
+    if (command.written < command.length) {
+        // The rest goes out from pump() as pacing allows
+        in_flight_.push_back(std::move(command));
+        return;
+    }
+    written(command, now, wire_us, done);
+}
+
+uint64_t CatCommandQueue::write_piece(Command& command, uint64_t now) {
+    size_t length = command.length - command.written;
+    if (config_.pacing_us && config_.protocol == CatProtocol::YAESU) {
+        length = std::min<size_t>(length, 5);               // One command per write
+    }
+    if (write_) write_(command.bytes.data() + command.written, length);
+    command.written += length;
+
+    uint64_t wire_us = serial_wire_time_us(config_.serial, length);
+    next_write_us_ = config_.pacing_us ? now + wire_us + config_.pacing_us : 0;
+    return wire_us;
+}
+
+void CatCommandQueue::written(Command& command, uint64_t now, uint64_t wire_us, std::vector<Finished>& done) {
+    if (command.replies_expected == 0) {
+        // Nothing will come back: done once it is on the wire
+        finish(command, CatResult::OK, now + wire_us, done);
+        return;
+    }
+    command.deadline_us = now + wire_us + config_.timeout_us;
+    in_flight_.push_back(std::move(command));
+}
+
+void CatCommandQueue::finish(Command& command, CatResult result, uint64_t now, std::vector<Finished>& done) {
+    if (result == CatResult::OK) {
+        stats_.completed++;
+    } else if (result != CatResult::CANCELLED) {
+        stats_.failed++;
+    }
+    if (!command.on_complete) return;
+
+    done.emplace_back();
+    Finished& finished = done.back();
+    finished.on_complete = std::move(command.on_complete);
+    finished.reply = command.reply;
+
+    CatCompletion& completion = finished.completion;
+    completion.id = command.id;
+    completion.result = result;
+    completion.attempts = command.attempts;
+    completion.latency_us = now > command.submit_us ? now - command.submit_us : 0;
+    completion.reply_us = command.attempts && now > command.write_us ? now - command.write_us : 0;
+    completion.reply_length = command.reply_size;
+}
+
+void CatCommandQueue::fail_head(CatResult result, uint64_t now, std::vector<Finished>& done) {
+    Command command = std::move(in_flight_.front());
+    in_flight_.pop_front();
+
+    // A re-send would land after the newer commands already in flight and
+    // undo them (an old frequency after a new one): give up instead
+    if (command.attempts <= config_.max_retries && in_flight_.empty()) {
+        // Back off, then go out ahead of anything queued after it
+        stats_.retries++;
+        uint32_t shift = std::min<uint32_t>(command.attempts - 1, 16);
+        command.deadline_us = now + (static_cast<uint64_t>(config_.backoff_us) << shift);
+        pending_.push_front(std::move(command));
+        return;
+    }
+    finish(command, result, now, done);
+}
+
+void CatCommandQueue::reply_head(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done) {
+    Command& head = in_flight_.front();
+    if (data && length) {
+        head.reply_size = std::min(length, CAT_MAX_REPLY_BYTES);
+        std::memcpy(head.reply.data(), data, head.reply_size);
+    }
+    if (++head.replies_received < head.replies_expected) return;
+
+    Command command = std::move(head);
+    in_flight_.pop_front();
+    finish(command, CatResult::OK, now, done);
+}
+
+void CatCommandQueue::receive_civ(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        if (rx_size_ == 0 && byte != CIV_PREAMBLE) continue;   // Hunt for FE
+        if (rx_size_ == 2 && byte == CIV_PREAMBLE) continue;   // Extra preamble
+        if (rx_size_ == 1 && byte != CIV_PREAMBLE) {
+            rx_size_ = 0;
+            continue;
+        }
+        if (rx_size_ >= rx_.size()) {
+            rx_size_ = 0;                                      // Overlong: resync
+            continue;
+        }
+        rx_[rx_size_++] = byte;
+        if (byte != CIV_EOM) continue;
+
+        size_t size = rx_size_;
+        rx_size_ = 0;
+        if (size < 6) continue;
+
+        uint8_t to = rx_[2];
+        uint8_t from = rx_[3];
+        uint8_t cmd = rx_[4];
+        if (civ_skip_ && to == civ_skip_controller_ && from == civ_skip_radio_) {
+            civ_skip_--;                                       // Rest of a NAKed request
+            continue;
+        }
+        if (in_flight_.empty()) {
+            stats_.unmatched++;
+            continue;
+        }
+        Command& head = in_flight_.front();
+        if (to != head.civ_controller || from != head.civ_radio) continue;   // Echo or another station
+
+        if (cmd == CIV_ACK) {
+            reply_head(nullptr, 0, now, done);
+        } else if (cmd == CIV_NAK) {
+            // The radio still answers the request's later frames: those
+            // must not be credited to the commands behind it
+            stats_.naks++;
+            civ_skip_ = head.replies_expected - head.replies_received - 1;
+            civ_skip_controller_ = head.civ_controller;
+            civ_skip_radio_ = head.civ_radio;
+            fail_head(CatResult::NAK, now, done);
+        } else if (head.replies_received < head.civ_cmds.size() &&
+                   cmd == head.civ_cmds[head.replies_received]) {
+            reply_head(rx_.data(), size, now, done);
+        } else {
+            stats_.unmatched++;
+        }
+    }
+}
+
+void CatCommandQueue::receive_kenwood(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        if (rx_size_ >= rx_.size()) rx_size_ = 0;              // Overlong: resync
+        rx_[rx_size_++] = byte;
+        if (byte != ';') continue;
+
+        size_t size = rx_size_;
+        rx_size_ = 0;
+        bool error = size == 2 && (rx_[0] == '?' || rx_[0] == 'E' || rx_[0] == 'O');
+
+        if (in_flight_.empty()) {
+            stats_.unmatched++;
+        } else if (error) {
+            stats_.naks++;
+            fail_head(CatResult::NAK, now, done);
+        } else if (size >= 3 && rx_[0] == in_flight_.front().kenwood_code[0] &&
+                   rx_[1] == in_flight_.front().kenwood_code[1]) {
+            reply_head(rx_.data(), size, now, done);
+        } else {
+            stats_.unmatched++;                                // Auto-information
+        }
+    }
+}
+
+void CatCommandQueue::receive_yaesu(const uint8_t* data, size_t length, uint64_t now, std::vector<Finished>& done) {
+    size_t i = 0;
+    while (i < length && !in_flight_.empty()) {
+        Command& head = in_flight_.front();
+        if (head.written < head.length) break;              // Still going out: not its reply
+        size_t take = std::min(length - i, head.reply_length - head.reply_size);
+        std::memcpy(head.reply.data() + head.reply_size, data + i, take);
+        head.reply_size += take;
+        i += take;
+        if (head.reply_size >= head.reply_length) {
+            Command command = std::move(head);
+            in_flight_.pop_front();
+            finish(command, CatResult::OK, now, done);
+        }
+    }
+    if (i < length) stats_.unmatched++;
+}
+
+void CatCommandQueue::run(std::vector<Finished>& done) {
+    for (Finished& finished : done) {
+        finished.completion.reply = finished.completion.reply_length ? finished.reply.data() : nullptr;
+        finished.on_complete(finished.completion);
+    }
+}
+
+} // namespace pal
@@ -0,0 +1,195 @@
+/**
+ * @file civ_parser.cpp
+ * @brief CI-V receive state machine implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/radios/civ_parser.h"
+
+namespace pal {
+
+namespace {
+
+// A decoder fills in the typed fields; false means the payload is malformed
+using Decoder = bool (*)(const uint8_t* payload, size_t length, CivMessage& message);
+
+bool valid_bcd(const uint8_t* bcd, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if ((bcd[i] & 0x0F) > 9 || (bcd[i] >> 4) > 9) return false;
+    }
+    return true;
+}
+
+int bcd_value(uint8_t bcd) {
+    return (bcd >> 4) * 10 + (bcd & 0x0F);
+}
+
+bool decode_other(const uint8_t*, size_t, CivMessage&) {
+    return true;
+}
+
+bool decode_ack(const uint8_t*, size_t, CivMessage& message) {
+    message.type = CivMessageType::ACK;
+    return true;
+}
+
+bool decode_nak(const uint8_t*, size_t, CivMessage& message) {
+    message.type = CivMessageType::NAK;
+    return true;
+}
+
+bool decode_frequency(const uint8_t* payload, size_t length, CivMessage& message) {
+    // 5 BCD bytes, 4 on older radios
+    if (length == 0) {
+        message.type = CivMessageType::OTHER;       // Read request from another controller
+        return true;
+    }
+    if ((length != CIV_FREQ_BYTES && length != CIV_FREQ_BYTES - 1) || !valid_bcd(payload, length)) return false;
+    message.type = CivMessageType::FREQUENCY;
+    message.frequency_hz = CivCodec::bcd_to_freq(payload, length);
+    return true;
+}
+
+bool decode_mode(const uint8_t* payload, size_t length, CivMessage& message) {
+    // Mode, then filter (optional on transceive)
+    if (length == 0) {
+        message.type = CivMessageType::OTHER;
+        return true;
+    }
+    if (length > 2) return false;
+    message.type = CivMessageType::MODE;
+    message.mode = CivCodec::civ_to_radio_mode(static_cast<CivMode>(payload[0]));
+    message.filter = length == 2 ? payload[1] : 0;
+    return true;
+}
+
+bool decode_meter(const uint8_t* payload, size_t length, CivMessage& message) {
+    // Subcommand, then 0000-0255 as two BCD bytes
+    if (length == 1) {
+        message.type = CivMessageType::OTHER;
+        return true;
+    }
+    if (length != 3 || !valid_bcd(payload + 1, 2)) return false;
+    message.type = CivMessageType::METER;
+    message.meter = payload[0];
+    message.level = static_cast<uint16_t>(bcd_value(payload[1]) * 100 + bcd_value(payload[2]));
+    return true;
+}
+
+struct DecoderTable {
+    Decoder by_command[256];
+
+    DecoderTable() {
+        for (Decoder& decoder : by_command) decoder = decode_other;
+        by_command[static_cast<uint8_t>(CivCommand::TRANSCEIVE_FREQ)] = decode_frequency;
+        by_command[static_cast<uint8_t>(CivCommand::READ_FREQ)] = decode_frequency;
+        by_command[static_cast<uint8_t>(CivCommand::TRANSCEIVE_MODE)] = decode_mode;
+        by_command[static_cast<uint8_t>(CivCommand::READ_MODE)] = decode_mode;
+        by_command[static_cast<uint8_t>(CivCommand::READ_METER)] = decode_meter;
+        by_command[CIV_ACK] = decode_ack;
+        by_command[CIV_NAK] = decode_nak;
+    }
+};
+
+const DecoderTable DECODERS;
+
+} // namespace
+
+CivParser::CivParser(uint8_t radio_addr, uint8_t controller_addr)
+    : radio_addr_(radio_addr)
+    , controller_addr_(controller_addr)
+{
+}
+
+void CivParser::feed(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        switch (state_) {
+            case State::HUNT:
+                if (byte == CIV_PREAMBLE) state_ = State::PREAMBLE;
+                break;
+
+            case State::PREAMBLE:
+                state_ = byte == CIV_PREAMBLE ? State::TO : State::HUNT;
+                break;
+
+            case State::TO:
+                if (byte == CIV_PREAMBLE) break;            // Extra preamble
+                if (byte == CIV_EOM || byte == CIV_JAM) {
+                    stats_.malformed++;
+                    state_ = State::HUNT;
+                    break;
+                }
+                to_ = byte;
+                state_ = State::FROM;
+                break;
+
+            case State::FROM:
+            case State::COMMAND:
+            case State::DATA:
+                if (byte == CIV_EOM && state_ == State::DATA) {
+                    dispatch();
+                    state_ = State::HUNT;
+                } else if (byte == CIV_EOM || byte == CIV_JAM) {
+                    stats_.malformed++;                     // Truncated or jammed
+                    state_ = State::HUNT;
+                } else if (byte == CIV_PREAMBLE) {
+                    stats_.malformed++;                     // Next frame started early
+                    state_ = State::PREAMBLE;
+                } else if (state_ == State::FROM) {
+                    from_ = byte;
+                    state_ = State::COMMAND;
+                } else if (state_ == State::COMMAND) {
+                    command_ = byte;
+                    payload_size_ = 0;
+                    state_ = State::DATA;
+                } else if (payload_size_ < payload_.size()) {
+                    payload_[payload_size_++] = byte;
+                } else {
+                    stats_.overflows++;
+                    state_ = State::SKIP;
+                }
+                break;
+
+            case State::SKIP:
+                // Rest of an overlong frame
+                if (byte == CIV_EOM) state_ = State::HUNT;
+                else if (byte == CIV_PREAMBLE) state_ = State::PREAMBLE;
+                break;
+        }
+    }
+}
+
+void CivParser::dispatch() {
+    stats_.frames++;
+
+    if (from_ == controller_addr_) {
+        stats_.echoes++;                                    // Our own request on the bus
+        return;
+    }
+    bool broadcast = to_ == CIV_BROADCAST;
+    if ((to_ != controller_addr_ && !broadcast) || (radio_addr_ && from_ != radio_addr_)) {
+        stats_.filtered++;
+        return;
+    }
+
+    CivMessage message;
+    message.to = to_;
+    message.from = from_;
+    message.command = command_;
+    message.broadcast = broadcast;
+    message.payload = payload_.data();
+    message.payload_length = payload_size_;
+    if (!DECODERS.by_command[command_](payload_.data(), payload_size_, message)) {
+        stats_.malformed++;
+        return;
+    }
+
+    stats_.messages++;
+    if (handler_) handler_(message);
+}
+
+} // namespace pal
@@ -8,7 +8,6 @@
  */
 
 #include "pal/radios/elecraft.h"
-#include <cstdio>
 
 namespace pal {
 
@@ -24,16 +23,18 @@ std::string Elecraft::get_port_config() const {
 
 void Elecraft::set_power(int watts) {
     // Elecraft power command: PC###; (3 digits, watts)
-    char buf[8];
-    std::snprintf(buf, sizeof(buf), "PC%03d;", watts);
-    Kenwood::send_command(std::string(buf));
+    KenwoodCommandBuffer command;
+    KenwoodCodec::encode_number(command, "PC", static_cast<uint32_t>(watts < 0 ? 0 : watts), 3);
+    send(command);
+    forget_state(RadioStateField::POWER);
 }
 
 void Elecraft::set_antenna(int ant) {
     // Elecraft antenna command: AN#; (1 or 2)
-    char buf[8];
-    std::snprintf(buf, sizeof(buf), "AN%d;", ant);
-    Kenwood::send_command(std::string(buf));
+    KenwoodCommandBuffer command;
+    KenwoodCodec::encode_number(command, "AN", static_cast<uint32_t>(ant < 0 ? 0 : ant), 1);
+    send(command);
+    forget_state(RadioStateField::ANTENNA);
 }
 
 } // namespace pal
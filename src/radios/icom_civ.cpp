@@ -8,19 +8,22 @@
  */
 
 #include "pal/radios/icom_civ.h"
+#include "pal/radios/cat_command_queue.h"
 #include <cstring>
 
 namespace pal {
 
 IcomCiv::IcomCiv(ISerial* serial, uint8_t radio_addr)
     : serial_(serial)
-    , radio_addr_(radio_addr)
+    , codec_(radio_addr)
+    , parser_(radio_addr)
 {
+    parser_.set_handler([this](const CivMessage& message) { handle_message(message); });
 }
 
 bool IcomCiv::initialize() {
-    rx_buffer_.clear();
-    rx_buffer_.reserve(64);
+    parser_.reset();
+    shadow_.invalidate();
     ready_ = true;
     return true;
 }
@@ -30,6 +33,8 @@ void IcomCiv::shutdown() {
 }
 
 bool IcomCiv::start() {
+    // (Re)connected: the radio may have been changed from its front panel
+    shadow_.invalidate();
     return ready_;
 }
 
@@ -40,16 +45,15 @@ void IcomCiv::stop() {
 bool IcomCiv::set_channel(const Channel& channel) {
     if (!ready_ || !serial_) return false;
     
-    // Set frequency (5 bytes BCD, 10 digits, 1 Hz resolution)
-    uint8_t freq_bcd[5];
-    freq_to_bcd(channel.rx_frequency, freq_bcd, 5);
-    auto frame = build_frame(CivCommand::SET_FREQ, freq_bcd, 5);
-    send_frame(frame);
-    
-    // Set mode
-    uint8_t mode_data[1] = { static_cast<uint8_t>(radio_mode_to_civ(channel.rx_mode)) };
-    frame = build_frame(CivCommand::SET_MODE, mode_data, 1);
-    send_frame(frame);
+    // Only what differs from the last state sent, in one write
+    // (frequency is 5 bytes BCD, 1 Hz resolution)
+    uint8_t fields = shadow_.changed(channel);
+    if (fields) {
+        CivStateBuffer frames;
+        if (!codec_.encode_state(frames, channel, fields)) return false;
+        send(frames);
+    }
+    shadow_.commit(channel, fields);
     
     current_channel_ = channel;
     return true;
@@ -63,13 +67,53 @@ void IcomCiv::set_ptt(bool transmit) {
     if (!ready_ || !serial_) return;
     
     // CI-V PTT: command 0x1C, subcommand 0x00, data 0x01 (TX) or 0x00 (RX)
-    uint8_t ptt_data[1] = { transmit ? uint8_t(0x01) : uint8_t(0x00) };
-    auto frame = build_frame(CivCommand::PTT, 0x00, ptt_data, 1);
-    send_frame(frame);
+    CivFrameBuffer frame;
+    codec_.encode_ptt(frame, transmit);
+    send(frame);
     
     transmitting_ = transmit;
 }
 
+bool IcomCiv::set_channel_async(const Channel& channel, CompletionCallback on_complete) {
+    if (!queue_) return IRadio::set_channel_async(channel, std::move(on_complete));
+    if (!ready_ || !serial_) return false;
+    
+    uint8_t fields = shadow_.changed(channel);
+    CivStateBuffer frames;
+    if (fields && !codec_.encode_state(frames, channel, fields)) return false;
+    shadow_.commit(channel, fields);
+    current_channel_ = channel;
+    
+    if (!fields) {
+        // Already in that state
+        RadioCompletion completion;
+        completion.ok = true;
+        if (on_complete) on_complete(completion);
+        return true;
+    }
+    
+    // Done when every frame has been ACKed
+    queue_->submit(frames.data(), frames.size(), [this, on_complete](const CatCompletion& result) {
+        RadioCompletion completion = make_radio_completion(result);
+        if (!completion.ok) shadow_.invalidate();
+        if (on_complete) on_complete(completion);
+    });
+    return true;
+}
+
+bool IcomCiv::set_ptt_async(bool transmit, CompletionCallback on_complete) {
+    if (!queue_) return IRadio::set_ptt_async(transmit, std::move(on_complete));
+    if (!ready_ || !serial_) return false;
+    
+    CivFrameBuffer frame;
+    codec_.encode_ptt(frame, transmit);
+    transmitting_ = transmit;
+    queue_->submit(frame.data(), frame.size(), [on_complete](const CatCompletion& result) {
+        if (on_complete) on_complete(make_radio_completion(result));
+    });
+    return true;
+}
+
 bool IcomCiv::is_transmitting() const {
     return transmitting_;
 }
@@ -93,140 +137,62 @@ void IcomCiv::register_ack_callback(AckCallback callback) {
 }
 
 void IcomCiv::process_response(const uint8_t* data, size_t length) {
-    // Look for valid CI-V frame: FE FE ... FD
-    for (size_t i = 0; i < length; i++) {
-        rx_buffer_.push_back(data[i]);
-        
-        if (data[i] == CIV_EOM) {
-            // Frame complete, parse it
-            if (rx_buffer_.size() >= 6 && 
-                rx_buffer_[0] == CIV_PREAMBLE && 
-                rx_buffer_[1] == CIV_PREAMBLE) {
-                
-                // Check if it's ACK or NAK
-                // ACK: FE FE E0 radio_addr FB FD
-                // NAK: FE FE E0 radio_addr FA FD
-                if (rx_buffer_.size() >= 6) {
-                    uint8_t cmd = rx_buffer_[4];
-                    if (cmd == CIV_ACK) {
-                        if (ack_callback_) ack_callback_();
-                    }
-                    // NAK handling would go here
-                }
+    parser_.feed(data, length);
+}
+
+void IcomCiv::handle_message(const CivMessage& message) {
+    const Channel& known = shadow_.state();
+    switch (message.type) {
+        case CivMessageType::ACK:
+            if (ack_callback_) ack_callback_();
+            break;
+        case CivMessageType::NAK:
+            // Some setting was refused: re-send everything next time
+            shadow_.invalidate();
+            break;
+        case CivMessageType::FREQUENCY:
+            // Tuned from the front panel (or read back): re-send if it differs
+            if (message.frequency_hz != known.rx_frequency) shadow_.invalidate(RadioStateField::FREQUENCY);
+            break;
+        case CivMessageType::MODE:
+            // (compared as CI-V codes: DATA_USB reads back as USB)
+            if (CivCodec::radio_mode_to_civ(message.mode) != CivCodec::radio_mode_to_civ(known.rx_mode)) {
+                shadow_.invalidate(RadioStateField::MODE);
             }
-            rx_buffer_.clear();
-        }
-        
-        // Prevent buffer overflow
-        if (rx_buffer_.size() > 256) {
-            rx_buffer_.clear();
-        }
+            break;
+        default:
+            break;
     }
+    if (message_callback_) message_callback_(message);
 }
 
-std::vector<uint8_t> IcomCiv::build_frame(CivCommand cmd, const uint8_t* data, size_t len) {
-    std::vector<uint8_t> frame;
-    frame.reserve(6 + len);
-    
-    frame.push_back(CIV_PREAMBLE);      // FE
-    frame.push_back(CIV_PREAMBLE);      // FE
-    frame.push_back(radio_addr_);       // Radio address
-    frame.push_back(controller_addr_);  // Controller address (E0)
-    frame.push_back(static_cast<uint8_t>(cmd));
-    
-    if (data && len > 0) {
-        frame.insert(frame.end(), data, data + len);
-    }
-    
-    frame.push_back(CIV_EOM);           // FD
-    
-    return frame;
+size_t IcomCiv::encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const {
+    CivStateBuffer frames;
+    if (!codec_.encode_state(frames, channel, shadow_.managed()) || frames.size() > capacity) return 0;
+    std::memcpy(out, frames.data(), frames.size());
+    return frames.size();
 }
 
-std::vector<uint8_t> IcomCiv::build_frame(CivCommand cmd, uint8_t subcmd, const uint8_t* data, size_t len) {
-    std::vector<uint8_t> frame;
-    frame.reserve(7 + len);
-    
-    frame.push_back(CIV_PREAMBLE);      // FE
-    frame.push_back(CIV_PREAMBLE);      // FE
-    frame.push_back(radio_addr_);       // Radio address
-    frame.push_back(controller_addr_);  // Controller address (E0)
-    frame.push_back(static_cast<uint8_t>(cmd));
-    frame.push_back(subcmd);
-    
-    if (data && len > 0) {
-        frame.insert(frame.end(), data, data + len);
-    }
-    
-    frame.push_back(CIV_EOM);           // FD
+bool IcomCiv::send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) {
+    if (!ready_ || !serial_) return false;
     
-    return frame;
+    send_bytes(data, length);
+    shadow_.commit(channel, shadow_.managed());
+    current_channel_ = channel;
+    return true;
 }
 
-void IcomCiv::send_frame(const std::vector<uint8_t>& frame) {
-    if (send_callback_) {
-        send_callback_(frame.data(), frame.size());
+void IcomCiv::send_bytes(const uint8_t* data, size_t length) {
+    if (queue_) {
+        // The shadow holds what the radio confirmed: forget it if this
+        // never got through
+        queue_->submit(data, length, [this](const CatCompletion& result) {
+            if (result.result != CatResult::OK) shadow_.invalidate();
+        });
+    } else if (send_callback_) {
+        send_callback_(data, length);
     } else if (serial_) {
-        serial_->write(frame.data(), frame.size());
-    }
-}
-
-void IcomCiv::freq_to_bcd(uint32_t freq_hz, uint8_t* bcd, size_t len) {
-    // CI-V uses BCD encoding, LSB first
-    // 14.250.000 Hz -> 00 00 25 14 00 (5 bytes)
-    for (size_t i = 0; i < len; i++) {
-        uint8_t lo = freq_hz % 10;
-        freq_hz /= 10;
-        uint8_t hi = freq_hz % 10;
-        freq_hz /= 10;
-        bcd[i] = (hi << 4) | lo;
-    }
-}
-
-uint32_t IcomCiv::bcd_to_freq(const uint8_t* bcd, size_t len) {
-    uint32_t freq = 0;
-    uint32_t mult = 1;
-    
-    for (size_t i = 0; i < len; i++) {
-        uint8_t lo = bcd[i] & 0x0F;
-        uint8_t hi = (bcd[i] >> 4) & 0x0F;
-        freq += lo * mult;
-        mult *= 10;
-        freq += hi * mult;
-        mult *= 10;
-    }
-    
-    return freq;
-}
-
-CivMode IcomCiv::radio_mode_to_civ(RadioMode mode) {
-    switch (mode) {
-        case RadioMode::LSB:      return CivMode::LSB;
-        case RadioMode::USB:      return CivMode::USB;
-        case RadioMode::AM:       return CivMode::AM;
-        case RadioMode::CW:       return CivMode::CW;
-        case RadioMode::RTTY:     return CivMode::RTTY;
-        case RadioMode::FM:       return CivMode::FM;
-        case RadioMode::CW_R:     return CivMode::CW_R;
-        case RadioMode::FSK:      return CivMode::RTTY;
-        case RadioMode::FSK_R:    return CivMode::RTTY_R;
-        case RadioMode::DATA_LSB: return CivMode::LSB;  // Some radios have DATA modes
-        case RadioMode::DATA_USB: return CivMode::USB;
-        default:                  return CivMode::USB;
-    }
-}
-
-RadioMode IcomCiv::civ_to_radio_mode(CivMode mode) {
-    switch (mode) {
-        case CivMode::LSB:    return RadioMode::LSB;
-        case CivMode::USB:    return RadioMode::USB;
-        case CivMode::AM:     return RadioMode::AM;
-        case CivMode::CW:     return RadioMode::CW;
-        case CivMode::RTTY:   return RadioMode::RTTY;
-        case CivMode::FM:     return RadioMode::FM;
-        case CivMode::CW_R:   return RadioMode::CW_R;
-        case CivMode::RTTY_R: return RadioMode::FSK_R;
-        default:              return RadioMode::USB;
+        serial_->write(data, length);
     }
 }
 
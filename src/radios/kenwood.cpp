@@ -8,18 +8,39 @@
  */
 
 #include "pal/radios/kenwood.h"
-#include <cstdio>
+#include "pal/radios/cat_command_queue.h"
+#include <cstring>
 
 namespace pal {
 
+namespace {
+
+// Async completions check the IF; readback appended to the request
+
+bool info_shows_channel(const uint8_t* reply, size_t length, const Channel& channel) {
+    KenwoodMessage info;
+    return KenwoodParser::decode(reply, length, info) && info.type == KenwoodMessageType::INFO &&
+           info.frequency_hz == channel.rx_frequency &&
+           KenwoodCodec::radio_mode_to_kenwood(info.mode) == KenwoodCodec::radio_mode_to_kenwood(channel.rx_mode);
+}
+
+bool info_shows_ptt(const uint8_t* reply, size_t length, bool transmit) {
+    KenwoodMessage info;
+    return KenwoodParser::decode(reply, length, info) && info.type == KenwoodMessageType::INFO &&
+           info.transmitting == transmit;
+}
+
+} // namespace
+
 Kenwood::Kenwood(ISerial* serial)
     : serial_(serial)
 {
+    parser_.set_handler([this](const KenwoodMessage& message) { handle_message(message); });
 }
 
 bool Kenwood::initialize() {
-    rx_buffer_.clear();
-    rx_buffer_.reserve(64);
+    parser_.reset();
+    shadow_.invalidate();
     ready_ = true;
     return true;
 }
@@ -29,6 +50,13 @@ void Kenwood::shutdown() {
 }
 
 bool Kenwood::start() {
+    // (Re)connected: the radio may have been changed from its front panel
+    shadow_.invalidate();
+    if (ready_ && serial_ && auto_info_ != KenwoodAutoInfo::OFF) {
+        KenwoodCommandBuffer command;
+        KenwoodCodec::encode_auto_info(command, auto_info_);
+        send(command);
+    }
     return ready_;
 }
 
@@ -39,11 +67,14 @@ void Kenwood::stop() {
 bool Kenwood::set_channel(const Channel& channel) {
     if (!ready_ || !serial_) return false;
     
-    // Set frequency on VFO A
-    send_command(build_freq_command('A', channel.rx_frequency));
-    
-    // Set mode
-    send_command(build_mode_command(channel.rx_mode));
+    // Only what differs from the last state sent, in one write
+    uint8_t fields = shadow_.changed(channel);
+    if (fields) {
+        KenwoodStateBuffer commands;
+        if (!KenwoodCodec::encode_state(commands, channel, fields)) return false;
+        send(commands);
+    }
+    shadow_.commit(channel, fields);
     
     current_channel_ = channel;
     return true;
@@ -56,10 +87,61 @@ Channel Kenwood::get_channel() const {
 void Kenwood::set_ptt(bool transmit) {
     if (!ready_ || !serial_) return;
     
-    send_command(transmit ? "TX;" : "RX;");
+    KenwoodCommandBuffer command;
+    KenwoodCodec::encode_ptt(command, transmit);
+    send(command);
     transmitting_ = transmit;
 }
 
+bool Kenwood::set_channel_async(const Channel& channel, CompletionCallback on_complete) {
+    if (!queue_) return IRadio::set_channel_async(channel, std::move(on_complete));
+    if (!ready_ || !serial_) return false;
+    
+    uint8_t fields = shadow_.changed(channel);
+    if (!fields) {
+        current_channel_ = channel;
+        // Already in that state
+        RadioCompletion completion;
+        completion.ok = true;
+        if (on_complete) on_complete(completion);
+        return true;
+    }
+    
+    // Set commands are silent: read back IF; in the same write
+    KenwoodStateBuffer commands;
+    if (!KenwoodCodec::encode_state(commands, channel, fields) ||
+        !commands.append(kenwood_cmd::READ_INFO)) {
+        return false;
+    }
+    shadow_.commit(channel, fields);
+    current_channel_ = channel;
+    
+    queue_->submit(commands.data(), commands.size(), [this, channel, on_complete](const CatCompletion& result) {
+        RadioCompletion completion = make_radio_completion(
+            result, info_shows_channel(result.reply, result.reply_length, channel));
+        if (!completion.ok) shadow_.invalidate();
+        if (on_complete) on_complete(completion);
+    });
+    return true;
+}
+
+bool Kenwood::set_ptt_async(bool transmit, CompletionCallback on_complete) {
+    if (!queue_) return IRadio::set_ptt_async(transmit, std::move(on_complete));
+    if (!ready_ || !serial_) return false;
+    
+    KenwoodCommandBuffer commands;
+    KenwoodCodec::encode_ptt(commands, transmit);
+    commands.append(kenwood_cmd::READ_INFO);
+    transmitting_ = transmit;
+    
+    queue_->submit(commands.data(), commands.size(), [transmit, on_complete](const CatCompletion& result) {
+        RadioCompletion completion = make_radio_completion(
+            result, info_shows_ptt(result.reply, result.reply_length, transmit));
+        if (on_complete) on_complete(completion);
+    });
+    return true;
+}
+
 bool Kenwood::is_transmitting() const {
     return transmitting_;
 }
@@ -82,77 +164,81 @@ void Kenwood::register_ack_callback(AckCallback callback) {
 }
 
 void Kenwood::process_response(const uint8_t* data, size_t length) {
-    // Accumulate until semicolon
-    for (size_t i = 0; i < length; i++) {
-        char c = static_cast<char>(data[i]);
-        rx_buffer_ += c;
-        
-        if (c == ';') {
-            // Complete response received
-            // Parse if needed, for now just acknowledge
-            if (ack_callback_) {
-                ack_callback_();
+    parser_.feed(data, length);
+}
+
+bool Kenwood::set_auto_info(uint8_t level) {
+    auto_info_ = level;
+    if (!ready_ || !serial_) return false;
+    
+    KenwoodCommandBuffer command;
+    KenwoodCodec::encode_auto_info(command, level);
+    send(command);
+    return true;
+}
+
+void Kenwood::handle_message(const KenwoodMessage& message) {
+    const Channel& known = shadow_.state();
+    switch (message.type) {
+        case KenwoodMessageType::ERROR:
+            // "?;" (syntax), "E;" (comms) and "O;" (overflow) reject a command:
+            // re-send everything next time
+            shadow_.invalidate();
+            break;
+        case KenwoodMessageType::FREQUENCY:
+            // Tuned from the front panel (or read back): re-send if it differs
+            if (message.vfo == 'A' && message.frequency_hz != known.rx_frequency) {
+                shadow_.invalidate(RadioStateField::FREQUENCY);
+            } else if (message.vfo == 'B' && shadow_.split() && message.frequency_hz != shadow_.split_tx_frequency()) {
+                shadow_.invalidate(RadioStateField::SPLIT);
+            }
+            break;
+        case KenwoodMessageType::INFO:
+            if (message.frequency_hz != known.rx_frequency) shadow_.invalidate(RadioStateField::FREQUENCY);
+            transmitting_ = message.transmitting;
+            [[fallthrough]];
+        case KenwoodMessageType::MODE:
+            if (KenwoodCodec::radio_mode_to_kenwood(message.mode) != KenwoodCodec::radio_mode_to_kenwood(known.rx_mode)) {
+                shadow_.invalidate(RadioStateField::MODE);
             }
-            rx_buffer_.clear();
-        }
-        
-        // Prevent overflow
-        if (rx_buffer_.size() > 256) {
-            rx_buffer_.clear();
-        }
+            break;
+        case KenwoodMessageType::TRANSMIT:
+            transmitting_ = message.transmitting;
+            break;
+        default:
+            break;
     }
+    // Anything but an error acknowledges
+    if (message.type != KenwoodMessageType::ERROR && ack_callback_) ack_callback_();
+    if (message_callback_) message_callback_(message);
 }
 
-void Kenwood::send_command(const std::string& cmd) {
-    if (send_callback_) {
-        send_callback_(reinterpret_cast<const uint8_t*>(cmd.c_str()), cmd.size());
-    } else if (serial_) {
-        serial_->write(reinterpret_cast<const uint8_t*>(cmd.c_str()), cmd.size());
-    }
+size_t Kenwood::encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const {
+    KenwoodStateBuffer commands;
+    if (!KenwoodCodec::encode_state(commands, channel, shadow_.managed()) || commands.size() > capacity) return 0;
+    std::memcpy(out, commands.data(), commands.size());
+    return commands.size();
 }
 
-std::string Kenwood::build_freq_command(char vfo, uint32_t freq_hz) {
-    // Format: FA00014250000; (11 digits, Hz)
-    char buf[16];
-    std::snprintf(buf, sizeof(buf), "F%c%011u;", vfo, freq_hz);
-    return std::string(buf);
-}
-
-std::string Kenwood::build_mode_command(RadioMode mode) {
-    // Format: MD2; (mode number)
-    char buf[8];
-    std::snprintf(buf, sizeof(buf), "MD%d;", static_cast<int>(radio_mode_to_kenwood(mode)));
-    return std::string(buf);
-}
-
-KenwoodMode Kenwood::radio_mode_to_kenwood(RadioMode mode) {
-    switch (mode) {
-        case RadioMode::LSB:      return KenwoodMode::LSB;
-        case RadioMode::USB:      return KenwoodMode::USB;
-        case RadioMode::CW:       return KenwoodMode::CW;
-        case RadioMode::FM:       return KenwoodMode::FM;
-        case RadioMode::AM:       return KenwoodMode::AM;
-        case RadioMode::FSK:      return KenwoodMode::FSK;
-        case RadioMode::RTTY:     return KenwoodMode::FSK;
-        case RadioMode::CW_R:     return KenwoodMode::CW_R;
-        case RadioMode::FSK_R:    return KenwoodMode::FSK_R;
-        case RadioMode::DATA_USB: return KenwoodMode::USB;
-        case RadioMode::DATA_LSB: return KenwoodMode::LSB;
-        default:                  return KenwoodMode::USB;
-    }
+bool Kenwood::send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) {
+    if (!ready_ || !serial_) return false;
+    
+    send_bytes(data, length);
+    shadow_.commit(channel, shadow_.managed());
+    current_channel_ = channel;
+    return true;
 }
 
-RadioMode Kenwood::kenwood_to_radio_mode(KenwoodMode mode) {
-    switch (mode) {
-        case KenwoodMode::LSB:   return RadioMode::LSB;
-        case KenwoodMode::USB:   return RadioMode::USB;
-        case KenwoodMode::CW:    return RadioMode::CW;
-        case KenwoodMode::FM:    return RadioMode::FM;
-        case KenwoodMode::AM:    return RadioMode::AM;
-        case KenwoodMode::FSK:   return RadioMode::FSK;
-        case KenwoodMode::CW_R:  return RadioMode::CW_R;
-        case KenwoodMode::FSK_R: return RadioMode::FSK_R;
-        default:                 return RadioMode::USB;
+void Kenwood::send_bytes(const uint8_t* data, size_t length) {
+    if (queue_) {
+        // Refused or never answered: the radio's state is unknown
+        queue_->submit(data, length, [this](const CatCompletion& result) {
+            if (result.result != CatResult::OK) shadow_.invalidate();
+        });
+    } else if (send_callback_) {
+        send_callback_(data, length);
+    } else if (serial_) {
+        serial_->write(data, length);
     }
 }
 
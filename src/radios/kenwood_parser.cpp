@@ -0,0 +1,162 @@
+/**
+ * @file kenwood_parser.cpp
+ * @brief Kenwood/Elecraft answer parser implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/radios/kenwood_parser.h"
+#include <cstring>
+
+namespace pal {
+
+namespace {
+
+// IF answer: IF, frequency (11), step (5), RIT/XIT offset (5), RIT, XIT,
+// memory bank + channel (3), TX/RX, mode, ...;
+constexpr size_t IF_FREQ = 2;
+constexpr size_t IF_TX = 28;
+constexpr size_t IF_MODE = 29;
+
+bool parse_digits(const uint8_t* p, size_t n, uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t digit = static_cast<uint8_t>(p[i] - '0');
+        if (digit > 9) return false;
+        value = value * 10 + digit;
+    }
+    return n > 0;
+}
+
+bool parse_frequency(const uint8_t* p, uint32_t& freq_hz) {
+    uint64_t value;
+    if (!parse_digits(p, KENWOOD_FREQ_DIGITS, value) || value > UINT32_MAX) return false;
+    freq_hz = static_cast<uint32_t>(value);
+    return true;
+}
+
+bool parse_mode(uint8_t c, RadioMode& mode) {
+    if (c < '0' || c > '9') return false;
+    mode = KenwoodCodec::kenwood_to_radio_mode(static_cast<KenwoodMode>(c - '0'));
+    return true;
+}
+
+} // namespace
+
+void KenwoodParser::feed(const uint8_t* data, size_t length) {
+    const uint8_t* end = data + length;
+    while (data < end) {
+        const uint8_t* semicolon = static_cast<const uint8_t*>(std::memchr(data, ';', end - data));
+        size_t n = semicolon ? static_cast<size_t>(semicolon - data) + 1 : static_cast<size_t>(end - data);
+
+        if (discarding_) {
+            // Skip to the end of an overlong answer
+        } else if (size_ + n > buffer_.size()) {
+            stats_.overflows++;
+            size_ = 0;
+            discarding_ = true;
+        } else if (size_ == 0 && semicolon) {
+            deliver(data, n);                               // In place
+        } else {
+            std::memcpy(buffer_.data() + size_, data, n);
+            size_ += n;
+            if (semicolon) {
+                stats_.copied++;
+                deliver(buffer_.data(), size_);
+                size_ = 0;
+            }
+        }
+
+        if (semicolon) discarding_ = false;
+        data += n;
+    }
+}
+
+bool KenwoodParser::decode(const uint8_t* answer, size_t length, KenwoodMessage& message) {
+    if (!answer || length < 2 || answer[length - 1] != ';') return false;
+    message.text = reinterpret_cast<const char*>(answer);
+    message.length = length;
+
+    if (length == 2) {
+        message.code[0] = static_cast<char>(answer[0]);
+        bool error = answer[0] == '?' || answer[0] == 'E' || answer[0] == 'O';
+        message.type = error ? KenwoodMessageType::ERROR : KenwoodMessageType::OTHER;
+        return true;
+    }
+
+    message.code[0] = static_cast<char>(answer[0]);
+    message.code[1] = static_cast<char>(answer[1]);
+    const uint8_t* field = answer + 2;
+    size_t size = length - 3;                               // Between code and ';'
+    uint64_t value;
+
+    switch (code(message.code[0], message.code[1])) {
+        case code('F', 'A'):
+        case code('F', 'B'):
+            if (size == 0) return true;                     // Echoed query
+            if (size != KENWOOD_FREQ_DIGITS || !parse_frequency(field, message.frequency_hz)) return false;
+            message.type = KenwoodMessageType::FREQUENCY;
+            message.vfo = message.code[1];
+            return true;
+
+        case code('M', 'D'):
+            if (size == 0) return true;
+            if (size != 1 || !parse_mode(field[0], message.mode)) return false;
+            message.type = KenwoodMessageType::MODE;
+            return true;
+
+        case code('I', 'F'):
+            if (size == 0) return true;
+            if (length <= IF_MODE + 1 || !parse_frequency(answer + IF_FREQ, message.frequency_hz) ||
+                !parse_mode(answer[IF_MODE], message.mode)) {
+                return false;
+            }
+            message.type = KenwoodMessageType::INFO;
+            message.transmitting = answer[IF_TX] == '1';
+            return true;
+
+        case code('S', 'M'):
+            // Kenwood: receiver digit + 4 digits; Elecraft: 4 digits
+            if (size == 0) return true;
+            if (size == 5) {
+                if (field[0] < '0' || field[0] > '9') return false;
+                message.meter = static_cast<uint8_t>(field[0] - '0');
+                field++;
+                size--;
+            }
+            if (size != 4 || !parse_digits(field, size, value)) return false;
+            message.type = KenwoodMessageType::METER;
+            message.level = static_cast<uint16_t>(value);
+            return true;
+
+        case code('T', 'X'):
+            if (size > 1) return false;
+            message.type = KenwoodMessageType::TRANSMIT;
+            message.transmitting = true;
+            return true;
+
+        case code('R', 'X'):
+            if (size > 1) return false;
+            message.type = KenwoodMessageType::TRANSMIT;
+            message.transmitting = false;
+            return true;
+
+        default:
+            return true;
+    }
+}
+
+void KenwoodParser::deliver(const uint8_t* answer, size_t length) {
+    stats_.answers++;
+    KenwoodMessage message;
+    if (!decode(answer, length, message)) {
+        stats_.malformed++;
+        return;
+    }
+    stats_.messages++;
+    if (handler_) handler_(message);
+}
+
+} // namespace pal
@@ -0,0 +1,69 @@
+/**
+ * @file radio_state_shadow.cpp
+ * @brief Radio state shadow implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/radios/radio_state_shadow.h"
+
+namespace pal {
+
+namespace {
+
+int count_fields(uint8_t fields) {
+    int count = 0;
+    for (; fields; fields &= static_cast<uint8_t>(fields - 1)) count++;
+    return count;
+}
+
+} // namespace
+
+RadioStateShadow::RadioStateShadow(uint8_t supported, uint8_t managed)
+    : supported_(supported & RadioStateField::ALL)
+    , managed_(managed & supported_)
+{
+}
+
+uint8_t RadioStateShadow::changed(const Channel& target) const {
+    uint8_t fields = RadioStateField::NONE;
+    for (uint8_t field = 1; field & RadioStateField::ALL; field <<= 1) {
+        if (!(managed_ & field)) continue;
+        if (!(known_ & field) || !same(target, field)) fields |= field;
+    }
+    return fields;
+}
+
+bool RadioStateShadow::same(const Channel& target, uint8_t field) const {
+    switch (field) {
+        case RadioStateField::FREQUENCY:   return state_.rx_frequency == target.rx_frequency;
+        case RadioStateField::MODE:        return state_.rx_mode == target.rx_mode;
+        case RadioStateField::SPLIT:
+            return split_ == is_split(target) && (!split_ || split_tx_frequency_ == target.tx_frequency);
+        case RadioStateField::ANTENNA:     return state_.antenna == target.antenna;
+        case RadioStateField::POWER:       return state_.power == target.power;
+        case RadioStateField::ATTENUATION: return state_.attenuation == target.attenuation;
+        default:                           return true;
+    }
+}
+
+void RadioStateShadow::commit(const Channel& target, uint8_t fields) {
+    fields &= supported_;
+    if (fields & RadioStateField::FREQUENCY) state_.rx_frequency = target.rx_frequency;
+    if (fields & RadioStateField::MODE) state_.rx_mode = target.rx_mode;
+    if (fields & RadioStateField::SPLIT) {
+        split_ = is_split(target);
+        split_tx_frequency_ = split_ ? target.tx_frequency : 0;
+    }
+    if (fields & RadioStateField::ANTENNA) state_.antenna = target.antenna;
+    if (fields & RadioStateField::POWER) state_.power = target.power;
+    if (fields & RadioStateField::ATTENUATION) state_.attenuation = target.attenuation;
+
+    known_ |= fields;
+    fields_sent_ += count_fields(fields);
+    fields_suppressed_ += count_fields(managed_ & static_cast<uint8_t>(~fields));
+}
+
+} // namespace pal
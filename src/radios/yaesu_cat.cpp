@@ -8,15 +8,21 @@
  */
 
 #include "pal/radios/yaesu_cat.h"
+#include "pal/radios/cat_command_queue.h"
+#include <cstring>
 
 namespace pal {
 
 YaesuCat::YaesuCat(ISerial* serial)
     : serial_(serial)
+    , shadow_(RadioStateField::FREQUENCY | RadioStateField::MODE | RadioStateField::SPLIT)
 {
+    parser_.set_handler([this](YaesuCommand read, const YaesuStatus& status) { handle_status(read, status); });
 }
 
 bool YaesuCat::initialize() {
+    parser_.reset();
+    shadow_.invalidate();
     ready_ = true;
     return true;
 }
@@ -26,6 +32,9 @@ void YaesuCat::shutdown() {
 }
 
 bool YaesuCat::start() {
+    // (Re)connected: the radio may have been changed from its front panel
+    shadow_.invalidate();
+    parser_.reset();
     return ready_;
 }
 
@@ -36,21 +45,14 @@ void YaesuCat::stop() {
 bool YaesuCat::set_channel(const Channel& channel) {
     if (!ready_ || !serial_) return false;
     
-    // Set frequency
-    // Yaesu format: 4 bytes packed BCD (10 Hz resolution) + command
-    // 14.250.00 MHz -> 01 42 50 00 01
-    uint8_t freq_bcd[4];
-    freq_to_packed_bcd(channel.rx_frequency, freq_bcd);
-    auto cmd = build_command(YaesuCommand::SET_FREQ, 
-                             freq_bcd[0], freq_bcd[1], 
-                             freq_bcd[2], freq_bcd[3]);
-    send_command(cmd);
-    
-    // Set mode
-    cmd = build_command(YaesuCommand::SET_MODE, 
-                        static_cast<uint8_t>(radio_mode_to_yaesu(channel.rx_mode)),
-                        0, 0, 0);
-    send_command(cmd);
+    // Only what differs from the last state sent, one command per write
+    uint8_t fields = shadow_.changed(channel);
+    uint8_t commands[YAESU_MAX_CHANNEL_COMMANDS * 5];
+    size_t length = encode_fields(channel, fields, commands);
+    for (size_t i = 0; i < length; i += 5) {
+        send_bytes(commands + i, 5);
+    }
+    shadow_.commit(channel, fields);
     
     current_channel_ = channel;
     return true;
@@ -69,6 +71,64 @@ void YaesuCat::set_ptt(bool transmit) {
     transmitting_ = transmit;
 }
 
+bool YaesuCat::set_channel_async(const Channel& channel, CompletionCallback on_complete) {
+    if (!queue_) return IRadio::set_channel_async(channel, std::move(on_complete));
+    if (!ready_ || !serial_) return false;
+    
+    uint8_t fields = shadow_.changed(channel);
+    current_channel_ = channel;
+    if (!fields) {
+        // Already in that state
+        RadioCompletion completion;
+        completion.ok = true;
+        if (on_complete) on_complete(completion);
+        return true;
+    }
+    
+    // No acknowledgements: read frequency and mode back (4 BCD bytes + mode)
+    uint8_t commands[(YAESU_MAX_CHANNEL_COMMANDS + 1) * 5];
+    size_t length = encode_fields(channel, fields, commands);
+    write_command(commands + length, YaesuCommand::READ_FREQ);
+    length += 5;
+    shadow_.commit(channel, fields);
+    
+    uint8_t managed = shadow_.managed();
+    queue_->submit(commands, length, [this, channel, managed, on_complete](const CatCompletion& result) {
+        bool verified = result.result == CatResult::OK &&
+                        parser_.apply(YaesuCommand::READ_FREQ, result.reply, result.reply_length);
+        const YaesuStatus& status = parser_.get_status();
+        if (verified && (managed & RadioStateField::FREQUENCY)) {
+            verified = status.frequency_hz == channel.rx_frequency / 10 * 10;
+        }
+        if (verified && (managed & RadioStateField::MODE)) {
+            verified = radio_mode_to_yaesu(status.mode) == radio_mode_to_yaesu(channel.rx_mode);
+        }
+        RadioCompletion completion = make_radio_completion(result, verified);
+        if (!completion.ok) shadow_.invalidate();
+        if (on_complete) on_complete(completion);
+    }, YaesuParser::reply_length(YaesuCommand::READ_FREQ));
+    return true;
+}
+
+bool YaesuCat::set_ptt_async(bool transmit, CompletionCallback on_complete) {
+    if (!queue_) return IRadio::set_ptt_async(transmit, std::move(on_complete));
+    if (!ready_ || !serial_) return false;
+    
+    // Read TX status back: bit 7 clear while transmitting
+    uint8_t commands[10];
+    write_command(commands, transmit ? YaesuCommand::PTT_ON : YaesuCommand::PTT_OFF);
+    write_command(commands + 5, YaesuCommand::READ_TX_STATUS);
+    transmitting_ = transmit;
+    
+    queue_->submit(commands, sizeof(commands), [this, transmit, on_complete](const CatCompletion& result) {
+        bool verified = result.result == CatResult::OK &&
+                        parser_.apply(YaesuCommand::READ_TX_STATUS, result.reply, result.reply_length) &&
+                        parser_.get_status().transmitting == transmit;
+        if (on_complete) on_complete(make_radio_completion(result, verified));
+    }, YaesuParser::reply_length(YaesuCommand::READ_TX_STATUS));
+    return true;
+}
+
 bool YaesuCat::is_transmitting() const {
     return transmitting_;
 }
@@ -91,30 +151,130 @@ void YaesuCat::register_ack_callback(AckCallback callback) {
 }
 
 void YaesuCat::process_response(const uint8_t* data, size_t length) {
-    // Yaesu returns status bytes
-    // For now, just acknowledge receipt
-    if (length > 0 && ack_callback_) {
-        ack_callback_();
+    // With a queue, replies arrive through its completions instead
+    if (queue_) return;
+    parser_.feed(data, length);
+}
+
+bool YaesuCat::read_status() {
+    if (!ready_ || !serial_) return false;
+    
+    static constexpr YaesuCommand READS[] = {
+        YaesuCommand::READ_FREQ, YaesuCommand::READ_RX_STATUS, YaesuCommand::READ_TX_STATUS,
+    };
+    for (YaesuCommand read : READS) {
+        uint8_t command[YAESU_COMMAND_BYTES];
+        write_command(command, read);
+        if (queue_) {
+            queue_->submit(command, sizeof(command), [this, read](const CatCompletion& result) {
+                if (result.result == CatResult::OK) parser_.apply(read, result.reply, result.reply_length);
+            }, YaesuParser::reply_length(read));
+        } else {
+            send_bytes(command, sizeof(command));
+        }
     }
+    return true;
+}
+
+void YaesuCat::handle_status(YaesuCommand read, const YaesuStatus& status) {
+    const Channel& known = shadow_.state();
+    if (read == YaesuCommand::READ_FREQ) {
+        // Tuned from the front panel: re-send if it differs (10 Hz resolution)
+        if (status.frequency_hz != known.rx_frequency / 10 * 10) shadow_.invalidate(RadioStateField::FREQUENCY);
+        if (radio_mode_to_yaesu(status.mode) != radio_mode_to_yaesu(known.rx_mode)) {
+            shadow_.invalidate(RadioStateField::MODE);
+        }
+    } else if (read == YaesuCommand::READ_TX_STATUS) {
+        transmitting_ = status.transmitting;
+    }
+    if (ack_callback_) ack_callback_();
+    if (status_callback_) status_callback_(status);
+}
+
+size_t YaesuCat::encode_channel(const Channel& channel, uint8_t* out, size_t capacity) const {
+    uint8_t commands[YAESU_MAX_CHANNEL_COMMANDS * 5];
+    size_t length = encode_fields(channel, shadow_.managed(), commands);
+    if (length > capacity) return 0;
+    std::memcpy(out, commands, length);
+    return length;
+}
+
+size_t YaesuCat::encode_fields(const Channel& channel, uint8_t fields, uint8_t* out) {
+    uint8_t* p = out;
+    
+    if (fields & RadioStateField::FREQUENCY) {
+        // Yaesu format: 4 bytes packed BCD (10 Hz resolution) + command
+        // 14.250.00 MHz -> 01 42 50 00 01
+        uint8_t freq_bcd[4];
+        freq_to_packed_bcd(channel.rx_frequency, freq_bcd);
+        write_command(p, YaesuCommand::SET_FREQ, 
+                      freq_bcd[0], freq_bcd[1], 
+                      freq_bcd[2], freq_bcd[3]);
+        p += 5;
+    }
+    
+    if (fields & RadioStateField::MODE) {
+        write_command(p, YaesuCommand::SET_MODE, 
+                      static_cast<uint8_t>(radio_mode_to_yaesu(channel.rx_mode)));
+        p += 5;
+    }
+    
+    if (fields & RadioStateField::SPLIT) {
+        write_command(p, RadioStateShadow::is_split(channel) ?
+                      YaesuCommand::SPLIT_ON : YaesuCommand::SPLIT_OFF);
+        p += 5;
+    }
+    
+    return static_cast<size_t>(p - out);
+}
+
+bool YaesuCat::send_encoded_channel(const Channel& channel, const uint8_t* data, size_t length) {
+    if (!ready_ || !serial_) return false;
+    
+    // One command per write, as set_channel does
+    for (size_t i = 0; i + YAESU_COMMAND_BYTES <= length; i += YAESU_COMMAND_BYTES) {
+        send_bytes(data + i, YAESU_COMMAND_BYTES);
+    }
+    shadow_.commit(channel, shadow_.managed());
+    current_channel_ = channel;
+    return true;
 }
 
 std::vector<uint8_t> YaesuCat::build_command(YaesuCommand cmd, 
                                               uint8_t p1, uint8_t p2, 
                                               uint8_t p3, uint8_t p4) {
     std::vector<uint8_t> frame(5);
-    frame[0] = p1;
-    frame[1] = p2;
-    frame[2] = p3;
-    frame[3] = p4;
-    frame[4] = static_cast<uint8_t>(cmd);
+    write_command(frame.data(), cmd, p1, p2, p3, p4);
     return frame;
 }
 
+void YaesuCat::write_command(uint8_t* out, YaesuCommand cmd,
+                             uint8_t p1, uint8_t p2,
+                             uint8_t p3, uint8_t p4) {
+    out[0] = p1;
+    out[1] = p2;
+    out[2] = p3;
+    out[3] = p4;
+    out[4] = static_cast<uint8_t>(cmd);
+}
+
 void YaesuCat::send_command(const std::vector<uint8_t>& cmd) {
+    send_bytes(cmd.data(), cmd.size());
+}
+
+void YaesuCat::send_bytes(const uint8_t* data, size_t length) {
+    if (queue_) {
+        // Sets complete on write; only a cancelled one leaves this unsent
+        queue_->submit(data, length, [this](const CatCompletion& result) {
+            if (result.result != CatResult::OK) shadow_.invalidate();
+        });
+        return;
+    }
+    parser_.on_write(data, length);
     if (send_callback_) {
-        send_callback_(cmd.data(), cmd.size());
+        send_callback_(data, length);
     } else if (serial_) {
-        serial_->write(cmd.data(), cmd.size());
+        serial_->write(data, length);
     }
 }
 
@@ -130,21 +290,6 @@ void YaesuCat::freq_to_packed_bcd(uint32_t freq_hz, uint8_t* bcd) {
     bcd[3] = ((freq_10hz / 10) % 10) << 4 | (freq_10hz % 10);
 }
 
-uint32_t YaesuCat::packed_bcd_to_freq(const uint8_t* bcd) {
-    uint32_t freq = 0;
-    
-    freq += ((bcd[0] >> 4) & 0x0F) * 10000000;
-    freq += (bcd[0] & 0x0F) * 1000000;
-    freq += ((bcd[1] >> 4) & 0x0F) * 100000;
-    freq += (bcd[1] & 0x0F) * 10000;
-    freq += ((bcd[2] >> 4) & 0x0F) * 1000;
-    freq += (bcd[2] & 0x0F) * 100;
-    freq += ((bcd[3] >> 4) & 0x0F) * 10;
-    freq += (bcd[3] & 0x0F);
-    
-    return freq * 10;  // Convert back to Hz
-}
-
 YaesuMode YaesuCat::radio_mode_to_yaesu(RadioMode mode) {
     switch (mode) {
         case RadioMode::LSB:      return YaesuMode::LSB;
@@ -161,18 +306,4 @@ YaesuMode YaesuCat::radio_mode_to_yaesu(RadioMode mode) {
     }
 }
 
-RadioMode YaesuCat::yaesu_to_radio_mode(YaesuMode mode) {
-    switch (mode) {
-        case YaesuMode::LSB:    return RadioMode::LSB;
-        case YaesuMode::USB:    return RadioMode::USB;
-        case YaesuMode::CW:     return RadioMode::CW;
-        case YaesuMode::CW_R:   return RadioMode::CW_R;
-        case YaesuMode::AM:     return RadioMode::AM;
-        case YaesuMode::FM:     return RadioMode::FM;
-        case YaesuMode::DIG:    return RadioMode::DIG;
-        case YaesuMode::PKT:    return RadioMode::FSK;
-        default:                return RadioMode::USB;
-    }
-}
-
 } // namespace pal
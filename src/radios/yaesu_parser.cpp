@@ -0,0 +1,136 @@
+/**
+ * @file yaesu_parser.cpp
+ * @brief Yaesu reply framing and status decoding implementation
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ * @license MIT
+ */
+
+#include "pal/radios/yaesu_parser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace pal {
+
+size_t YaesuParser::reply_length(YaesuCommand command) {
+    switch (command) {
+        case YaesuCommand::READ_FREQ:       return 5;
+        case YaesuCommand::READ_RX_STATUS:  return 1;
+        case YaesuCommand::READ_TX_STATUS:  return 1;
+        default:                            return 0;
+    }
+}
+
+void YaesuParser::on_write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i + YAESU_COMMAND_BYTES <= length; i += YAESU_COMMAND_BYTES) {
+        YaesuCommand command = static_cast<YaesuCommand>(data[i + YAESU_COMMAND_BYTES - 1]);
+        if (reply_length(command) == 0) continue;
+
+        if (count_ == expected_.size()) {
+            // Oldest read is long lost: forget it
+            stats_.dropped++;
+            head_ = (head_ + 1) % expected_.size();
+            count_--;
+            size_ = 0;
+        }
+        expected_[(head_ + count_) % expected_.size()] = command;
+        count_++;
+    }
+}
+
+void YaesuParser::feed(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length && count_ > 0) {
+        YaesuCommand read = expected_[head_];
+        size_t take = std::min(length - i, reply_length(read) - size_);
+        std::memcpy(reply_.data() + size_, data + i, take);
+        size_ += take;
+        i += take;
+        if (size_ < reply_length(read)) break;
+
+        head_ = (head_ + 1) % expected_.size();
+        count_--;
+        size_ = 0;
+        apply(read, reply_.data(), reply_length(read));
+    }
+    if (i < length) stats_.unexpected += length - i;
+}
+
+bool YaesuParser::apply(YaesuCommand read, const uint8_t* reply, size_t length) {
+    if (!decode(read, reply, length, status_)) {
+        stats_.malformed++;
+        return false;
+    }
+    stats_.replies++;
+    if (handler_) handler_(read, status_);
+    return true;
+}
+
+bool YaesuParser::decode(YaesuCommand read, const uint8_t* reply, size_t length, YaesuStatus& status) {
+    if (!reply || length != reply_length(read) || length == 0) return false;
+
+    switch (read) {
+        case YaesuCommand::READ_FREQ: {
+            uint32_t freq_hz;
+            if (!packed_bcd_to_freq(reply, freq_hz)) return false;
+            status.frequency_hz = freq_hz;
+            status.mode = yaesu_to_radio_mode(static_cast<YaesuMode>(reply[4]));
+            status.valid |= YaesuStatus::FREQUENCY;
+            return true;
+        }
+
+        case YaesuCommand::READ_RX_STATUS:
+            status.s_meter = reply[0] & 0x0F;
+            status.squelched = (reply[0] & 0x80) != 0;
+            status.valid |= YaesuStatus::RX;
+            return true;
+
+        case YaesuCommand::READ_TX_STATUS:
+            // Receiving answers 0xFF: the other bits only mean something on TX
+            status.transmitting = (reply[0] & 0x80) == 0;
+            status.power_meter = status.transmitting ? (reply[0] & 0x0F) : 0;
+            status.high_swr = status.transmitting && (reply[0] & 0x40) != 0;
+            status.split = status.transmitting && (reply[0] & 0x20) == 0;
+            status.valid |= YaesuStatus::TX;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool YaesuParser::packed_bcd_to_freq(const uint8_t* bcd, uint32_t& freq_hz) {
+    uint32_t freq = 0;
+    for (size_t i = 0; i < 4; i++) {
+        uint8_t hi = bcd[i] >> 4;
+        uint8_t lo = bcd[i] & 0x0F;
+        if (hi > 9 || lo > 9) return false;
+        freq = freq * 100 + hi * 10 + lo;
+    }
+    freq_hz = freq * 10;    // Convert back to Hz
+    return true;
+}
+
+uint32_t YaesuParser::packed_bcd_to_freq(const uint8_t* bcd) {
+    uint32_t freq_hz = 0;
+    packed_bcd_to_freq(bcd, freq_hz);
+    return freq_hz;
+}
+
+RadioMode YaesuParser::yaesu_to_radio_mode(YaesuMode mode) {
+    switch (mode) {
+        case YaesuMode::LSB:    return RadioMode::LSB;
+        case YaesuMode::USB:    return RadioMode::USB;
+        case YaesuMode::CW:     return RadioMode::CW;
+        case YaesuMode::CW_R:   return RadioMode::CW_R;
+        case YaesuMode::AM:     return RadioMode::AM;
+        case YaesuMode::FM:     return RadioMode::FM;
+        case YaesuMode::FM_N:   return RadioMode::FM;
+        case YaesuMode::DIG:    return RadioMode::DIG;
+        case YaesuMode::PKT:    return RadioMode::FSK;
+        default:                return RadioMode::USB;
+    }
+}
+
+} // namespace pal
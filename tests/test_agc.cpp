@@ -0,0 +1,139 @@
+/**
+ * @file test_agc.cpp
+ * @brief Unit tests for Agc class
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/agc.h"
+#include "pal/resampler.h"
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+#define ASSERT_NEAR(a, b, tol) if (std::abs((a) - (b)) > (tol)) \
+    throw std::runtime_error("Assertion failed: " #a " != " #b)
+
+// Generate sine wave
+std::vector<float> generate_sine(float freq, float sample_rate, size_t count, float amplitude) {
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = amplitude * std::sin(2.0f * M_PI * freq * i / sample_rate);
+    }
+    return samples;
+}
+
+float peak(const float* samples, size_t count) {
+    float p = 0.0f;
+    for (size_t i = 0; i < count; i++) p = std::max(p, std::abs(samples[i]));
+    return p;
+}
+
+TEST(test_weak_signal_is_raised) {
+    pal::Agc agc;
+
+    // -40 dBFS tone, 4 seconds at 8kHz (decay takes ~2s from unity gain)
+    auto samples = generate_sine(1000.0f, 8000.0f, 32000, 0.01f);
+    agc.process(samples.data(), samples.size());
+
+    // Last 100ms should sit near the target level
+    float p = peak(samples.data() + 31200, 800);
+    ASSERT_NEAR(p, 0.5f, 0.05f);
+    ASSERT_NEAR(agc.get_gain_db(), 34.0f, 1.0f);
+    ASSERT_NEAR(agc.get_level_dbfs(), -40.0f, 1.0f);
+}
+
+TEST(test_strong_signal_attacks_quickly) {
+    pal::Agc agc;
+
+    // Settle on a weak signal, then step up by 40 dB
+    auto weak = generate_sine(1000.0f, 8000.0f, 8000, 0.005f);
+    agc.process(weak.data(), weak.size());
+
+    auto strong = generate_sine(1000.0f, 8000.0f, 800, 0.5f);
+    agc.process(strong.data(), strong.size());
+
+    // After 5 attack time constants (25ms) the output is back near target
+    float p = peak(strong.data() + 400, 400);
+    ASSERT_NEAR(p, 0.5f, 0.05f);
+}
+
+TEST(test_gain_is_limited) {
+    pal::AgcConfig config;
+    config.max_gain_db = 20.0f;
+    pal::Agc agc(config);
+
+    auto samples = generate_sine(1000.0f, 8000.0f, 16000, 0.0001f);
+    agc.process(samples.data(), samples.size());
+
+    ASSERT_NEAR(agc.get_gain_db(), 20.0f, 0.1f);
+}
+
+TEST(test_block_size_independent) {
+    pal::Agc agc_a;
+    pal::Agc agc_b;
+
+    auto a = generate_sine(700.0f, 8000.0f, 4096, 0.02f);
+    auto b = a;
+
+    // Whole buffer vs. period-sized chunks aligned to the sub-block
+    agc_a.process(a.data(), a.size());
+    for (size_t pos = 0; pos < b.size(); pos += 128) {
+        agc_b.process(b.data() + pos, 128);
+    }
+
+    for (size_t i = 0; i < a.size(); i++) {
+        ASSERT_NEAR(a[i], b[i], 1e-6f);
+    }
+}
+
+TEST(test_fused_decimate) {
+    pal::Resampler resampler(6);
+    pal::AgcConfig config;
+    config.decay_ms = 100.0f;
+    pal::Agc agc(config);
+
+    // -30 dBFS tone at 48kHz, 1 second
+    auto input = generate_sine(1000.0f, 48000.0f, 48000, 0.0316f);
+    std::vector<float> output(input.size() / 6 + 16);
+
+    size_t out_count = agc.decimate(resampler, input.data(), input.size(), output.data());
+
+    ASSERT(out_count == 8000);
+    float p = peak(output.data() + 7200, 800);
+    ASSERT_NEAR(p, 0.5f, 0.05f);
+}
+
+int main() {
+    std::cout << "=== AGC Unit Tests ===\n\n";
+
+    RUN_TEST(test_weak_signal_is_raised);
+    RUN_TEST(test_strong_signal_attacks_quickly);
+    RUN_TEST(test_gain_is_limited);
+    RUN_TEST(test_block_size_independent);
+    RUN_TEST(test_fused_decimate);
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
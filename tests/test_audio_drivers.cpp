@@ -0,0 +1,1060 @@
+/**
+ * @file test_audio_drivers.cpp
+ * @brief Unit tests for PAL audio driver implementations
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/audio/aggregate_audio_driver.h"
+#include "pal/audio/file_audio_driver.h"
+#include "pal/audio/loopback_audio_driver.h"
+#include "pal/audio/monitored_audio_driver.h"
+#ifdef PAL_WITH_SHM_AUDIO
+#include "pal/audio/shm_audio_driver.h"
+#include <unistd.h>
+#endif
+#ifdef PAL_WITH_ALSA
+#include "pal/audio/alsa_audio_driver.h"
+#endif
+#ifdef PAL_WITH_JACK
+#include "pal/audio/jack_audio_driver.h"
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+#define ASSERT_NEAR(a, b, tol) if (std::abs((a) - (b)) > (tol)) \
+    throw std::runtime_error("Assertion failed: " #a " != " #b)
+
+// Write a 16-bit PCM WAV file
+void write_wav_s16(const std::string& path, uint32_t rate, uint16_t channels,
+                   const std::vector<int16_t>& interleaved) {
+    uint32_t data_len = static_cast<uint32_t>(interleaved.size() * 2);
+    uint8_t h[44] = {};
+    auto le16 = [&](size_t off, uint16_t v) { h[off] = v & 0xFF; h[off + 1] = v >> 8; };
+    auto le32 = [&](size_t off, uint32_t v) { for (int i = 0; i < 4; i++) h[off + i] = (v >> (8 * i)) & 0xFF; };
+    std::memcpy(h, "RIFF", 4); le32(4, 36 + data_len);
+    std::memcpy(h + 8, "WAVEfmt ", 8); le32(16, 16);
+    le16(20, 1); le16(22, channels); le32(24, rate);
+    le32(28, rate * channels * 2); le16(32, channels * 2); le16(34, 16);
+    std::memcpy(h + 36, "data", 4); le32(40, data_len);
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    std::fwrite(h, 1, sizeof(h), f);
+    std::fwrite(interleaved.data(), 2, interleaved.size(), f);
+    std::fclose(f);
+}
+
+std::vector<uint8_t> read_file(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return bytes;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) bytes.insert(bytes.end(), buf, buf + n);
+    std::fclose(f);
+    return bytes;
+}
+
+// Callback target: TX = RX / 2, counts samples
+class RecordingEventHandler : public pal::IEventHandler {
+public:
+    void on(pal::EventType, pal::EventCallback) override {}
+    void on_any(pal::EventCallback) override {}
+    void emit(const pal::Event& event) override { events.push_back(event); }
+    void emit(pal::EventType type, const std::string& message) override {
+        pal::Event event{};
+        event.type = type;
+        event.message = message;
+        events.push_back(event);
+    }
+
+    std::vector<pal::Event> events;
+};
+
+static void spin_for_us(int us) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < end) {}
+}
+
+// Timer that only moves when told to
+class ManualTimer : public pal::ITimer {
+public:
+    uint64_t now_us = 5000000;
+    uint64_t get_time_ms() const override { return now_us / 1000; }
+    uint64_t get_time_us() const override { return now_us; }
+    void sleep_ms(uint32_t ms) override { now_us += ms * 1000ull; }
+    void sleep_us(uint32_t us) override { now_us += us; }
+};
+
+// Driver that only implements the plain callback, to exercise the defaults
+class MinimalDriver : public pal::IAudioDriver {
+public:
+    bool initialize(const std::string&, uint32_t, uint32_t) override { return true; }
+    void shutdown() override {}
+    bool start() override { return true; }
+    void stop() override {}
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override { callback_ = std::move(callback); }
+    bool is_running() const override { return false; }
+    uint32_t get_sample_rate() const override { return 8000; }
+    uint32_t get_buffer_frames() const override { return 80; }
+    float get_latency_ms() const override { return 20.0f; }
+
+    void tick() {
+        float rx[80] = {};
+        float tx[80];
+        callback_(rx, tx, 80);
+    }
+
+private:
+    AudioCallback callback_;
+};
+
+struct HalfGain {
+    size_t samples = 0;
+    void process(const float* rx, float* tx, size_t n) {
+        for (size_t i = 0; i < n; i++) tx[i] = rx[i] * 0.5f;
+        samples += n;
+    }
+};
+
+TEST(test_file_driver_wav_roundtrip) {
+    // Stereo input, radio audio on the right channel
+    std::vector<int16_t> pcm;
+    for (int i = 0; i < 1000; i++) {
+        pcm.push_back(1234);
+        pcm.push_back(static_cast<int16_t>(i * 16));
+    }
+    write_wav_s16("file_driver_in.wav", 8000, 2, pcm);
+
+    pal::FileAudioConfig config;
+    config.tx_path = "file_driver_out.wav";
+    config.rx_channel = 1;
+    pal::FileAudioDriver driver(config);
+
+    ASSERT(driver.initialize("file_driver_in.wav", 8000, 64));
+    ASSERT(driver.get_total_frames() == 1000);
+
+    HalfGain target;
+    driver.bind_audio_callback<HalfGain, &HalfGain::process>(&target);
+    ASSERT(driver.start());
+    driver.wait();
+
+    ASSERT(!driver.is_running());
+    ASSERT(driver.get_frames_processed() == 1000);
+    ASSERT(target.samples == 16 * 64);     // Last period zero-padded
+    driver.shutdown();
+
+    // Output: 44-byte header + 1000 mono S16 samples at half level
+    auto out = read_file("file_driver_out.wav");
+    ASSERT(out.size() == 44 + 2000);
+    ASSERT(std::memcmp(out.data(), "RIFF", 4) == 0);
+    for (int i = 0; i < 1000; i++) {
+        int16_t s;
+        std::memcpy(&s, out.data() + 44 + 2 * i, 2);
+        ASSERT(std::abs(s - i * 8) <= 1);
+    }
+
+    std::remove("file_driver_in.wav");
+    std::remove("file_driver_out.wav");
+}
+
+TEST(test_file_driver_rejects_rate_mismatch) {
+    write_wav_s16("file_driver_rate.wav", 48000, 1, std::vector<int16_t>(100));
+    pal::FileAudioDriver driver;
+    ASSERT(!driver.initialize("file_driver_rate.wav", 8000, 64));
+    std::remove("file_driver_rate.wav");
+}
+
+TEST(test_file_driver_raw_float_input) {
+    std::vector<float> raw(4800);
+    for (size_t i = 0; i < raw.size(); i++) raw[i] = static_cast<float>(i) / raw.size();
+    std::FILE* f = std::fopen("file_driver_in.raw", "wb");
+    std::fwrite(raw.data(), sizeof(float), raw.size(), f);
+    std::fclose(f);
+
+    pal::FileAudioConfig config;
+    config.raw_format = pal::SampleFormat::F32;
+    pal::FileAudioDriver driver(config);
+    ASSERT(driver.initialize("file_driver_in.raw", 48000, 480));
+
+    std::vector<float> seen;
+    driver.set_audio_callback([&](const float* rx, float*, size_t n) {
+        seen.insert(seen.end(), rx, rx + n);
+    });
+    ASSERT(driver.start());
+    driver.wait();
+
+    ASSERT(seen.size() == raw.size());
+    ASSERT(std::equal(seen.begin(), seen.end(), raw.begin()));
+    ASSERT(driver.get_realtime_factor() > 1.0);
+    std::remove("file_driver_in.raw");
+}
+
+TEST(test_file_driver_unaligned_float_wav) {
+    // 18-byte fmt chunk (cbSize = 0): samples start at offset 46
+    std::vector<float> pcm(1000);
+    for (size_t i = 0; i < pcm.size(); i++) pcm[i] = static_cast<float>(i) / pcm.size();
+    uint32_t data_len = static_cast<uint32_t>(pcm.size() * 4);
+    uint8_t h[46] = {};
+    auto le16 = [&](size_t off, uint16_t v) { h[off] = v & 0xFF; h[off + 1] = v >> 8; };
+    auto le32 = [&](size_t off, uint32_t v) { for (int i = 0; i < 4; i++) h[off + i] = (v >> (8 * i)) & 0xFF; };
+    std::memcpy(h, "RIFF", 4); le32(4, 38 + data_len);
+    std::memcpy(h + 8, "WAVEfmt ", 8); le32(16, 18);
+    le16(20, 3); le16(22, 1); le32(24, 8000);
+    le32(28, 8000 * 4); le16(32, 4); le16(34, 32); le16(36, 0);
+    std::memcpy(h + 38, "data", 4); le32(42, data_len);
+    std::FILE* f = std::fopen("file_driver_unaligned.wav", "wb");
+    std::fwrite(h, 1, sizeof(h), f);
+    std::fwrite(pcm.data(), 4, pcm.size(), f);
+    std::fclose(f);
+
+    pal::FileAudioDriver driver;
+    ASSERT(driver.initialize("file_driver_unaligned.wav", 8000, 128));
+    std::vector<float> seen;
+    driver.set_audio_callback([&](const float* rx, float*, size_t n) { seen.insert(seen.end(), rx, rx + n); });
+    ASSERT(driver.start());
+    driver.wait();
+    ASSERT(seen.size() == 8 * 128);
+    ASSERT(std::equal(pcm.begin(), pcm.end(), seen.begin()));
+
+    // Native frames are handed over aligned as well
+    ASSERT(driver.initialize("file_driver_unaligned.wav", 8000, 128));
+    bool aligned = true;
+    seen.clear();
+    ASSERT(driver.set_native_audio_callback([&](const pal::AudioBlockInfo&, const void* rx, void*, size_t n) {
+        aligned = aligned && reinterpret_cast<uintptr_t>(rx) % alignof(float) == 0;
+        const float* in = static_cast<const float*>(rx);
+        seen.insert(seen.end(), in, in + n);
+    }));
+    ASSERT(driver.start());
+    driver.wait();
+    driver.shutdown();
+    ASSERT(aligned);
+    ASSERT(std::equal(pcm.begin(), pcm.end(), seen.begin()));
+
+    std::remove("file_driver_unaligned.wav");
+}
+
+TEST(test_file_driver_paced_speed) {
+    // 0.5 s of audio at 10x real time takes ~50 ms
+    std::vector<int16_t> pcm(4000);
+    write_wav_s16("file_driver_paced.wav", 8000, 1, pcm);
+
+    pal::FileAudioConfig config;
+    config.speed = 10.0f;
+    pal::FileAudioDriver driver(config);
+    ASSERT(driver.initialize("file_driver_paced.wav", 8000, 80));
+    ASSERT(driver.start());
+    driver.wait();
+
+    double factor = driver.get_realtime_factor();
+    ASSERT(factor > 5.0 && factor < 11.0);
+    std::remove("file_driver_paced.wav");
+}
+
+TEST(test_loopback_tx_becomes_next_rx) {
+    pal::LoopbackAudioDriver driver;
+    ASSERT(driver.initialize("", 8000, 32));
+
+    int period = 0;
+    bool ok = true;
+    driver.set_audio_callback([&](const float* rx, float* tx, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            float expected = period == 0 ? 0.0f : static_cast<float>((period - 1) * 100 + i);
+            if (rx[i] != expected) ok = false;
+            tx[i] = static_cast<float>(period * 100 + i);
+        }
+        period++;
+    });
+    driver.run(10);
+
+    ASSERT(ok);
+    ASSERT(period == 10);
+    pal::LoopbackStats stats = driver.get_stats();
+    ASSERT(stats.callbacks == 10);
+    ASSERT(stats.samples == 320);
+
+    // Rates are latched when run() returns, not diluted by later reads
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pal::LoopbackStats later = driver.get_stats();
+    ASSERT(later.elapsed_s == stats.elapsed_s);
+    ASSERT(later.samples_per_sec == stats.samples_per_sec);
+    ASSERT_NEAR(driver.get_latency_ms(), 4.0f, 0.001f);
+}
+
+TEST(test_loopback_frequency_offset) {
+    // 1000 Hz tone shifted +250 Hz comes back at 1250 Hz
+    pal::LoopbackConfig config;
+    config.freq_offset_hz = 250.0f;
+    pal::LoopbackAudioDriver driver(config);
+    ASSERT(driver.initialize("", 8000, 80));
+
+    size_t t = 0;
+    std::vector<float> rx_log;
+    driver.set_audio_callback([&](const float* rx, float* tx, size_t n) {
+        for (size_t i = 0; i < n; i++, t++) {
+            tx[i] = static_cast<float>(std::sin(2.0 * M_PI * 1000.0 * t / 8000.0));
+        }
+        if (t > 800) rx_log.insert(rx_log.end(), rx, rx + n);
+    });
+    driver.run(110);   // 1 s of audio after settling
+
+    int crossings = 0;
+    for (size_t i = 1; i < 8000; i++) {
+        if ((rx_log[i - 1] < 0.0f) != (rx_log[i] < 0.0f)) crossings++;
+    }
+    ASSERT(std::abs(crossings / 2 - 1250) <= 2);
+
+    float peak = *std::max_element(rx_log.begin(), rx_log.end());
+    ASSERT_NEAR(peak, 1.0f, 0.05f);
+}
+
+TEST(test_loopback_awgn_level) {
+    pal::LoopbackConfig config;
+    config.noise_rms = 0.1f;
+    pal::LoopbackAudioDriver driver(config);
+    ASSERT(driver.initialize("", 48000, 480));
+
+    double sum_sq = 0.0;
+    size_t count = 0;
+    driver.set_audio_callback([&](const float* rx, float* tx, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            sum_sq += rx[i] * rx[i];
+            tx[i] = 0.0f;
+        }
+        count += n;
+    });
+    driver.run(100);
+
+    ASSERT_NEAR(std::sqrt(sum_sq / count), 0.1, 0.005);
+}
+
+TEST(test_loopback_timed_callback_indices) {
+    ManualTimer timer;
+    pal::LoopbackAudioDriver driver;
+    driver.set_timer(&timer);
+    ASSERT(driver.initialize("", 8000, 40));
+
+    // TX writes its own timeline index; it must come back at the same RX index
+    bool ok = true;
+    uint64_t expected_rx = 0;
+    driver.set_timed_audio_callback([&](const pal::AudioBlockInfo& info,
+                                        const float* rx, float* tx, size_t n) {
+        if (info.rx_sample_index != expected_rx) ok = false;
+        if (info.tx_sample_index != info.rx_sample_index + 40) ok = false;
+        if (info.rx_time_us != 5000000 + info.rx_sample_index * 125) ok = false;
+        if (info.tx_time_us != 5000000 + info.tx_sample_index * 125) ok = false;
+        for (size_t i = 0; i < n; i++) {
+            if (info.rx_sample_index >= 40 &&
+                rx[i] != static_cast<float>(info.rx_sample_index + i)) ok = false;
+            tx[i] = static_cast<float>(info.tx_sample_index + i);
+        }
+        expected_rx += n;
+    });
+    driver.run(20);
+
+    ASSERT(ok);
+    ASSERT(expected_rx == 800);
+}
+
+TEST(test_file_driver_timed_callback) {
+    write_wav_s16("file_driver_timed.wav", 8000, 1, std::vector<int16_t>(400));
+
+    ManualTimer timer;
+    pal::FileAudioDriver driver;
+    driver.set_timer(&timer);
+    ASSERT(driver.initialize("file_driver_timed.wav", 8000, 100));
+
+    std::vector<pal::AudioBlockInfo> blocks;
+    driver.set_timed_audio_callback([&](const pal::AudioBlockInfo& info,
+                                        const float*, float*, size_t) {
+        blocks.push_back(info);
+    });
+    ASSERT(driver.start());
+    driver.wait();
+
+    ASSERT(blocks.size() == 4);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        ASSERT(blocks[i].rx_sample_index == i * 100);
+        ASSERT(blocks[i].tx_sample_index == i * 100);
+        ASSERT(blocks[i].rx_time_us == 5000000 + i * 12500);
+    }
+    std::remove("file_driver_timed.wav");
+}
+
+TEST(test_default_timed_adapter) {
+    ManualTimer timer;
+    MinimalDriver driver;
+    driver.set_timer(&timer);
+
+    std::vector<pal::AudioBlockInfo> blocks;
+    driver.set_timed_audio_callback([&](const pal::AudioBlockInfo& info,
+                                        const float*, float*, size_t) {
+        blocks.push_back(info);
+    });
+    driver.tick();
+    timer.now_us += 10000;
+    driver.tick();
+
+    // 20 ms latency at 8 kHz = 160 frames; each block is 10 ms old on arrival
+    ASSERT(blocks.size() == 2);
+    ASSERT(blocks[0].rx_sample_index == 0);
+    ASSERT(blocks[1].rx_sample_index == 80);
+    ASSERT(blocks[1].tx_sample_index == 240);
+    ASSERT(blocks[0].rx_time_us == 5000000 - 10000);
+    ASSERT(blocks[1].rx_time_us == 5000000);
+    ASSERT(blocks[1].tx_time_us == 5020000);
+}
+
+TEST(test_file_driver_native_callback) {
+    // Stereo S16: left is a constant, right carries the radio
+    std::vector<int16_t> pcm;
+    for (int i = 0; i < 300; i++) {
+        pcm.push_back(-7);
+        pcm.push_back(static_cast<int16_t>(i));
+    }
+    write_wav_s16("file_driver_native.wav", 8000, 2, pcm);
+
+    pal::FileAudioConfig config;
+    config.tx_path = "file_driver_native_out.wav";
+    pal::FileAudioDriver driver(config);
+    pal::AudioFormat wanted;
+    wanted.format = pal::SampleFormat::S16;
+    wanted.channels = 2;
+    wanted.radio_channel = 1;
+    ASSERT(driver.set_native_format(wanted));
+    ASSERT(driver.initialize("file_driver_native.wav", 8000, 128));
+    ASSERT(driver.get_native_format() == wanted);
+
+    // Frames arrive untouched; TX swaps the channels
+    std::vector<int16_t> seen;
+    ASSERT(driver.set_native_audio_callback([&](const pal::AudioBlockInfo&, const void* rx,
+                                                void* tx, size_t n) {
+        const int16_t* in = static_cast<const int16_t*>(rx);
+        int16_t* out = static_cast<int16_t*>(tx);
+        seen.insert(seen.end(), in, in + 2 * n);
+        for (size_t i = 0; i < n; i++) {
+            out[2 * i] = in[2 * i + 1];
+            out[2 * i + 1] = in[2 * i];
+        }
+    }));
+    ASSERT(driver.start());
+    driver.wait();
+    driver.shutdown();
+
+    ASSERT(seen.size() == 2 * 3 * 128);
+    ASSERT(std::equal(pcm.begin(), pcm.end(), seen.begin()));
+    ASSERT(seen[600] == 0 && seen.back() == 0);     // Padded tail
+
+    // TX file keeps the native layout: stereo S16, 300 frames
+    auto out = read_file("file_driver_native_out.wav");
+    ASSERT(out.size() == 44 + 300 * 4);
+    ASSERT(out[22] == 2 && out[32] == 4);           // Channels, block align
+    int16_t frame[2];
+    std::memcpy(frame, out.data() + 44 + 4 * 123, 4);
+    ASSERT(frame[0] == 123 && frame[1] == -7);
+
+    std::remove("file_driver_native.wav");
+    std::remove("file_driver_native_out.wav");
+}
+
+TEST(test_default_native_adapter) {
+    // Mono float drivers get native callbacks for free, other layouts are refused
+    pal::LoopbackAudioDriver driver;
+    pal::AudioFormat s16;
+    s16.format = pal::SampleFormat::S16;
+    ASSERT(!driver.set_native_format(s16));
+    ASSERT(driver.set_native_format(pal::AudioFormat()));
+    ASSERT(driver.initialize("", 8000, 40));
+    ASSERT(driver.get_native_format().is_mono_float());
+
+    size_t frames = 0;
+    ASSERT(driver.set_native_audio_callback([&](const pal::AudioBlockInfo&, const void*,
+                                                void* tx, size_t n) {
+        static_cast<float*>(tx)[0] = 1.0f;
+        frames += n;
+    }));
+    driver.run(3);
+    ASSERT(frames == 120);
+
+    // The monitor forwards native callbacks and still measures them
+    pal::MonitoredAudioDriver monitored(
+        std::unique_ptr<pal::IAudioDriver>(new pal::LoopbackAudioDriver()));
+    ASSERT(monitored.initialize("", 8000, 40));
+    frames = 0;
+    ASSERT(monitored.set_native_audio_callback([&](const pal::AudioBlockInfo&, const void*,
+                                                   void*, size_t n) { frames += n; }));
+    static_cast<pal::LoopbackAudioDriver&>(monitored.get_inner()).run(2);
+    ASSERT(frames == 80);
+    ASSERT(monitored.snapshot().callbacks == 2);
+
+    // Back to a float callback
+    monitored.set_audio_callback([&](const float*, float*, size_t n) { frames += 2 * n; });
+    static_cast<pal::LoopbackAudioDriver&>(monitored.get_inner()).run(1);
+    ASSERT(frames == 160);
+}
+
+// Driver ticked by hand, standing in for one sound card and its clock
+class ManualDevice : public pal::IAudioDriver {
+public:
+    bool initialize(const std::string&, uint32_t sample_rate, uint32_t buffer_frames) override {
+        rate_ = sample_rate;
+        frames_ = buffer_frames;
+        return true;
+    }
+    void shutdown() override { running_ = false; }
+    bool start() override { running_ = true; return true; }
+    void stop() override { running_ = false; }
+    using IAudioDriver::set_audio_callback;
+    void set_audio_callback(AudioCallback callback) override { callback_.set(std::move(callback)); }
+    void set_audio_callback(AudioCallbackFn fn, void* context) override { callback_.set(fn, context); }
+    void set_timed_audio_callback(TimedAudioCallback callback) override { callback_.set_timed(std::move(callback)); }
+    bool is_running() const override { return running_; }
+    uint32_t get_sample_rate() const override { return rate_; }
+    uint32_t get_buffer_frames() const override { return frames_; }
+    float get_latency_ms() const override { return 10.0f; }
+
+    void tick(const float* rx, float* tx) {
+        pal::AudioBlockInfo info;
+        info.rx_sample_index = index_;
+        info.tx_sample_index = index_;
+        index_ += frames_;
+        callback_(info, rx, tx, frames_);
+    }
+
+private:
+    pal::AudioCallbackSlot callback_;
+    uint32_t rate_ = 0;
+    uint32_t frames_ = 0;
+    uint64_t index_ = 0;
+    bool running_ = false;
+};
+
+// Devices of an aggregate ticking on their own clocks, slave k off by ppm[k]
+struct ClockSim {
+    ManualTimer& timer;
+    ManualDevice& master;
+    std::vector<ManualDevice*> slaves;
+    std::vector<double> ppm;
+    std::vector<double> next_us;
+    double master_next_us = 0.0;
+    uint64_t base_us = 0;
+
+    ClockSim(ManualTimer& t, ManualDevice& m) : timer(t), master(m), base_us(t.now_us) {}
+
+    void add(ManualDevice* slave, double slave_ppm) {
+        slaves.push_back(slave);
+        ppm.push_back(slave_ppm);
+        next_us.push_back(0.0);
+    }
+
+    // Run until the master has done one more period; slaves fill rx and see tx
+    template <typename SlaveIo>
+    void master_period(float* master_rx, float* master_tx, SlaveIo&& slave_io) {
+        const double period_us = 1e6 * master.get_buffer_frames() / master.get_sample_rate();
+        for (;;) {
+            size_t next = slaves.size();
+            double at = master_next_us;
+            for (size_t k = 0; k < slaves.size(); k++) {
+                if (next_us[k] <= at) { at = next_us[k]; next = k; }
+            }
+            timer.now_us = base_us + static_cast<uint64_t>(at);
+            if (next == slaves.size()) {
+                master.tick(master_rx, master_tx);
+                master_next_us += period_us;
+                return;
+            }
+            std::vector<float> rx(slaves[next]->get_buffer_frames()), tx(rx.size());
+            slave_io(next, rx.data(), tx.data(), true);
+            slaves[next]->tick(rx.data(), tx.data());
+            slave_io(next, rx.data(), tx.data(), false);
+            next_us[next] += period_us / (1.0 + ppm[next] * 1e-6);
+        }
+    }
+};
+
+TEST(test_loopback_thread_stats) {
+    pal::LoopbackConfig config;
+    config.max_callbacks = 2000;
+    pal::LoopbackAudioDriver driver(config);
+    ASSERT(driver.initialize("", 48000, 256));
+
+    HalfGain target;
+    driver.bind_audio_callback<HalfGain, &HalfGain::process>(&target);
+    ASSERT(driver.start());
+    driver.wait();
+
+    ASSERT(!driver.is_running());
+    pal::LoopbackStats stats = driver.get_stats();
+    ASSERT(stats.callbacks == 2000);
+    ASSERT(target.samples == 2000 * 256);
+    ASSERT(stats.samples_per_sec > 48000.0);    // Far faster than real time
+    ASSERT(stats.callbacks_per_sec > 0.0);
+    ASSERT(stats.max_callback_us >= stats.avg_callback_us);
+    ASSERT(stats.load < 1.0);
+}
+
+TEST(test_monitor_flags_over_budget) {
+    // 48 frames at 48 kHz = 1 ms period; burn 0.9 ms per callback
+    pal::LoopbackConfig loop;
+    loop.max_callbacks = 50;
+    pal::MonitoredAudioDriver driver(
+        std::unique_ptr<pal::IAudioDriver>(new pal::LoopbackAudioDriver(loop)));
+    ASSERT(driver.initialize("", 48000, 48));
+
+    size_t samples = 0;
+    driver.set_audio_callback([&](const float*, float*, size_t n) {
+        spin_for_us(900);
+        samples += n;
+    });
+    ASSERT(driver.start());
+    static_cast<pal::LoopbackAudioDriver&>(driver.get_inner()).wait();
+
+    pal::AudioMonitorSnapshot snap = driver.snapshot();
+    ASSERT(samples == 50 * 48);
+    ASSERT(snap.callbacks == 50);
+    ASSERT(snap.over_budget > 0);
+    ASSERT(snap.avg_load >= 0.9);
+    ASSERT(snap.max_load >= snap.avg_load);
+    ASSERT(snap.load_percentile(0.5) >= 0.9);
+
+    uint64_t total = 0;
+    for (uint64_t count : snap.load_histogram) total += count;
+    ASSERT(total == 50);
+    total = 0;
+    for (uint64_t count : snap.jitter_histogram) total += count;
+    ASSERT(total == 49);    // First callback has no interval
+
+    RecordingEventHandler events;
+    driver.emit_events(events);
+    ASSERT(events.events.size() == 1);
+    ASSERT(events.events[0].type == pal::EventType::SYSTEM_WARNING);
+    ASSERT(events.events[0].source == "audio_monitor");
+    ASSERT(events.events[0].code >= 90);
+
+    // Nothing new since the last report
+    driver.emit_events(events);
+    ASSERT(events.events.size() == 1);
+}
+
+TEST(test_monitor_passes_through_timed_info) {
+    ManualTimer timer;
+    pal::MonitoredAudioDriver driver(
+        std::unique_ptr<pal::IAudioDriver>(new pal::LoopbackAudioDriver()));
+    driver.set_timer(&timer);
+    ASSERT(driver.initialize("", 8000, 80));
+    ASSERT(driver.get_sample_rate() == 8000);
+    ASSERT(driver.get_buffer_frames() == 80);
+
+    std::vector<pal::AudioBlockInfo> blocks;
+    driver.set_timed_audio_callback([&](const pal::AudioBlockInfo& info,
+                                        const float*, float*, size_t) {
+        blocks.push_back(info);
+    });
+    static_cast<pal::LoopbackAudioDriver&>(driver.get_inner()).run(3);
+
+    ASSERT(blocks.size() == 3);
+    ASSERT(blocks[2].rx_sample_index == 160);
+    ASSERT(blocks[2].rx_time_us == 5000000 + 20000);
+
+    // A trivial callback stays far under budget: no warning
+    pal::AudioMonitorSnapshot snap = driver.snapshot();
+    ASSERT(snap.callbacks == 3);
+    ASSERT(snap.deadline_misses == 0);
+    RecordingEventHandler events;
+    driver.emit_events(events);
+    ASSERT(events.events.empty());
+}
+
+TEST(test_aggregate_tracks_slave_drift) {
+    // Two slaves, one fast and one slow, each carrying a tone on its own
+    // clock; after lock-in every channel stays glitch free
+    ManualTimer timer;
+    ManualDevice* master = new ManualDevice();
+    ManualDevice* fast = new ManualDevice();
+    ManualDevice* slow = new ManualDevice();
+    pal::AggregateAudioDriver aggregate{std::unique_ptr<pal::IAudioDriver>(master)};
+    ASSERT(aggregate.add_device(std::unique_ptr<pal::IAudioDriver>(fast), "fast") == 1);
+    ASSERT(aggregate.add_device(std::unique_ptr<pal::IAudioDriver>(slow), "slow") == 2);
+    aggregate.set_timer(&timer);
+    ASSERT(aggregate.initialize("master", 8000, 80));
+    ASSERT(aggregate.get_native_format().channels == 3);
+    ASSERT_NEAR(aggregate.get_latency_ms(), 30.0f, 0.01f);
+
+    const double step = 2.0 * M_PI * 300.0 / 8000.0;
+    const float max_step = static_cast<float>(0.5 * step * 1.1);
+    uint64_t master_index = 0;
+    size_t blocks = 0;
+    float worst_rx = 0.0f;
+    std::vector<float> last_rx(3, 0.0f);
+    ASSERT(aggregate.set_native_audio_callback([&](const pal::AudioBlockInfo& info, const void* rx,
+                                                   void* tx, size_t n) {
+        const float* in = static_cast<const float*>(rx);
+        float* out = static_cast<float*>(tx);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t c = 1; c < 3; c++) {
+                if (blocks > 200) worst_rx = std::max(worst_rx, std::abs(in[i * 3 + c] - last_rx[c]));
+                last_rx[c] = in[i * 3 + c];
+                out[i * 3 + c] = static_cast<float>(0.5 * std::sin(step * (info.tx_sample_index + i)));
+            }
+        }
+        master_index = info.rx_sample_index + n;
+        blocks++;
+    }));
+    ASSERT(aggregate.start());
+
+    ClockSim sim(timer, *master);
+    sim.add(fast, 200.0);
+    sim.add(slow, -150.0);
+    std::vector<uint64_t> slave_index(2, 0);
+    std::vector<float> last_tx(2, 0.0f);
+    float worst_tx = 0.0f;
+    float master_rx[80] = {};
+    float master_tx[80];
+    for (size_t period = 0; period < 6000; period++) {
+        sim.master_period(master_rx, master_tx, [&](size_t k, float* rx, float* tx, bool before) {
+            if (before) {
+                for (size_t i = 0; i < 80; i++) {
+                    rx[i] = static_cast<float>(0.5 * std::sin(step * (slave_index[k] + i)));
+                }
+                return;
+            }
+            for (size_t i = 0; i < 80; i++) {
+                if (period > 200) worst_tx = std::max(worst_tx, std::abs(tx[i] - last_tx[k]));
+                last_tx[k] = tx[i];
+            }
+            slave_index[k] += 80;
+        });
+    }
+    ASSERT(master_index == 6000 * 80);
+
+    pal::AggregateDeviceStats fast_stats = aggregate.get_device_stats(1);
+    pal::AggregateDeviceStats slow_stats = aggregate.get_device_stats(2);
+    ASSERT_NEAR(fast_stats.drift_ppm, 200.0, 10.0);
+    ASSERT_NEAR(slow_stats.drift_ppm, -150.0, 10.0);
+    ASSERT_NEAR(fast_stats.rx_fill_frames, 160.0, 20.0);
+    ASSERT_NEAR(slow_stats.tx_fill_frames, 160.0, 20.0);
+    ASSERT(worst_rx < max_step);
+    ASSERT(worst_tx < max_step);
+    for (size_t ch = 1; ch <= 2; ch++) {
+        pal::AggregateDeviceStats stats = aggregate.get_device_stats(ch);
+        ASSERT(stats.rx_overruns == 0 && stats.rx_underruns == 0);
+        ASSERT(stats.tx_overruns == 0 && stats.tx_underruns == 0);
+    }
+
+    RecordingEventHandler events;
+    aggregate.emit_events(events);
+    ASSERT(events.events.empty());
+    aggregate.stop();
+    ASSERT(!fast->is_running() && !master->is_running());
+}
+
+TEST(test_aggregate_float_channel_and_stall) {
+    ManualTimer timer;
+    ManualDevice* master = new ManualDevice();
+    ManualDevice* slave = new ManualDevice();
+    pal::AggregateAudioDriver aggregate{std::unique_ptr<pal::IAudioDriver>(master)};
+    aggregate.add_device(std::unique_ptr<pal::IAudioDriver>(slave), "slave");
+    aggregate.set_timer(&timer);
+    ASSERT(aggregate.initialize("master", 8000, 80));
+
+    // One F32 channel per device; radio_channel picks what a float callback sees
+    pal::AudioFormat format;
+    format.channels = 3;
+    ASSERT(!aggregate.set_native_format(format));
+    format.channels = 2;
+    format.format = pal::SampleFormat::S16;
+    ASSERT(!aggregate.set_native_format(format));
+    format.format = pal::SampleFormat::F32;
+    format.radio_channel = 1;
+    ASSERT(aggregate.set_native_format(format));
+    ASSERT(aggregate.get_native_format() == format);
+
+    float seen = 0.0f;
+    aggregate.set_audio_callback([&](const float* rx, float* tx, size_t n) {
+        seen = rx[n - 1];
+        for (size_t i = 0; i < n; i++) tx[i] = 0.25f;
+    });
+    ASSERT(aggregate.start());
+
+    ClockSim sim(timer, *master);
+    sim.add(slave, 0.0);
+    bool stalled = false;
+    float slave_tx = 0.0f;
+    float master_rx[80];
+    float master_tx[80];
+    std::fill(master_rx, master_rx + 80, -1.0f);
+    auto slave_io = [&](size_t, float* rx, float* tx, bool before) {
+        if (before) std::fill(rx, rx + 80, stalled ? 0.0f : 0.75f);
+        else slave_tx = tx[79];
+    };
+    for (int i = 0; i < 50; i++) sim.master_period(master_rx, master_tx, slave_io);
+    ASSERT_NEAR(seen, 0.75f, 1e-6f);
+    ASSERT_NEAR(slave_tx, 0.25f, 1e-6f);
+    ASSERT(std::all_of(master_tx, master_tx + 80, [](float v) { return v == 0.0f; }));
+
+    // A slave that stops delivering reads as silence and then re-primes
+    sim.next_us[0] += 1e6;
+    for (int i = 0; i < 10; i++) sim.master_period(master_rx, master_tx, slave_io);
+    ASSERT(seen == 0.0f);
+    ASSERT(aggregate.get_device_stats(1).rx_underruns == 1);
+    for (int i = 0; i < 150; i++) sim.master_period(master_rx, master_tx, slave_io);
+    ASSERT_NEAR(seen, 0.75f, 1e-6f);
+    ASSERT(aggregate.get_device_stats(1).rx_underruns == 1);
+
+    RecordingEventHandler events;
+    aggregate.emit_events(events);
+    ASSERT(events.events.size() >= 1);
+    ASSERT(events.events[0].type == pal::EventType::AUDIO_UNDERRUN);
+    ASSERT(events.events[0].source == "aggregate[1] rx");
+}
+
+#ifdef PAL_WITH_SHM_AUDIO
+static std::string shm_test_name() {
+    return "/pal-test-" + std::to_string(getpid());
+}
+
+// Run one server period and wait for the consumer to finish it
+static bool shm_period(pal::ShmAudioServer& server, std::atomic<uint64_t>& consumed,
+                       const float* rx, float* tx, size_t n) {
+    uint64_t target = server.get_rx_index() + n;
+    server.process(rx, tx, n);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (consumed.load() < target) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+TEST(test_shm_roundtrip_and_index_lock) {
+    pal::ShmAudioServer server;
+    ASSERT(server.create(shm_test_name(), 8000));
+
+    pal::ShmAudioDriver consumer;
+    ASSERT(consumer.initialize(shm_test_name(), 8000, 80));
+
+    std::atomic<uint64_t> consumed{0};
+    bool ok = true;
+    consumer.set_timed_audio_callback([&](const pal::AudioBlockInfo& info,
+                                          const float* rx, float* tx, size_t n) {
+        if (info.tx_sample_index != info.rx_sample_index + 80) ok = false;
+        for (size_t i = 0; i < n; i++) tx[i] = rx[i] * 0.5f;
+        consumed.store(info.rx_sample_index + n);
+    });
+    ASSERT(consumer.start());
+
+    float rx[80], tx[80];
+    for (int p = 0; p < 20; p++) {
+        for (int i = 0; i < 80; i++) rx[i] = static_cast<float>(p * 80 + i);
+        ASSERT(shm_period(server, consumed, rx, tx, 80));
+
+        // One period of prefill: TX is the previous period's RX at half level
+        for (int i = 0; i < 80; i++) {
+            float expected = p == 0 ? 0.0f : 0.5f * ((p - 1) * 80 + i);
+            ASSERT(tx[i] == expected);
+        }
+    }
+    ASSERT(ok);
+    ASSERT(server.get_rx_overruns() == 0);
+    ASSERT(server.get_tx_underruns() == 0);
+    consumer.shutdown();
+}
+
+TEST(test_shm_consumer_restart_keeps_indices) {
+    pal::ShmAudioServer server;
+    ASSERT(server.create(shm_test_name(), 8000));
+    float rx[80] = {}, tx[80];
+    std::atomic<uint64_t> consumed{0};
+    auto track = [&](const pal::AudioBlockInfo& info, const float*, float* out, size_t n) {
+        std::fill(out, out + n, 0.0f);
+        consumed.store(info.rx_sample_index + n);
+    };
+
+    {
+        pal::ShmAudioDriver consumer;
+        ASSERT(consumer.initialize(shm_test_name(), 8000, 80));
+        consumer.set_timed_audio_callback(track);
+        ASSERT(consumer.start());
+        for (int p = 0; p < 5; p++) ASSERT(shm_period(server, consumed, rx, tx, 80));
+    }
+
+    // Consumer gone: the server keeps running and TX falls back to silence
+    for (int p = 0; p < 5; p++) server.process(rx, tx, 80);
+    ASSERT(server.get_tx_underruns() > 0);
+
+    std::vector<uint64_t> indices;
+    pal::ShmAudioDriver consumer;
+    ASSERT(consumer.initialize(shm_test_name(), 8000, 80));
+    consumer.set_timed_audio_callback([&](const pal::AudioBlockInfo& info,
+                                          const float* in, float* out, size_t n) {
+        indices.push_back(info.rx_sample_index);
+        track(info, in, out, n);
+    });
+    ASSERT(consumer.start());
+    for (int p = 0; p < 3; p++) ASSERT(shm_period(server, consumed, rx, tx, 80));
+    consumer.stop();
+
+    // Stale RX from the gap is skipped; numbering carries on from the server
+    ASSERT(indices.size() == 3);
+    ASSERT(indices[0] == 800);
+    ASSERT(indices[2] == 960);
+
+    RecordingEventHandler events;
+    server.emit_events(events);
+    ASSERT(events.events.size() == 1);
+    ASSERT(events.events[0].type == pal::EventType::AUDIO_UNDERRUN);
+}
+
+TEST(test_shm_rejects_rate_and_stops_on_close) {
+    pal::ShmAudioServer server;
+    ASSERT(server.create(shm_test_name(), 48000));
+
+    pal::ShmAudioDriver consumer;
+    ASSERT(!consumer.initialize(shm_test_name(), 8000, 80));
+    ASSERT(!consumer.initialize("/pal-test-missing", 48000, 80));
+    ASSERT(consumer.initialize(shm_test_name(), 48000, 480));
+    ASSERT(consumer.start());
+
+    server.close();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (consumer.is_running() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT(!consumer.is_running());
+}
+#endif
+
+#ifdef PAL_WITH_ALSA
+TEST(test_alsa_driver_runs_periods) {
+    // ALSA "null" device by default; set PAL_ALSA_TEST_DEVICE for snd-dummy ("hw:Dummy")
+    const char* device = std::getenv("PAL_ALSA_TEST_DEVICE");
+    pal::AlsaAudioConfig config;
+    config.rt_priority = 0;
+    pal::AlsaAudioDriver driver(config);
+    ASSERT(driver.initialize(device ? device : "null", 48000, 480));
+
+    // TX starts out silent every period even though the callback leaves
+    // it dirty; TX stays a fixed distance ahead of RX
+    std::atomic<size_t> samples{0};
+    std::atomic<bool> tx_dirty{false};
+    std::atomic<bool> indices_moved{false};
+    std::atomic<uint64_t> latency{0};
+    driver.set_timed_audio_callback([&](const pal::AudioBlockInfo& info, const float*, float* tx, size_t n) {
+        if (std::any_of(tx, tx + n, [](float s) { return s != 0.0f; })) tx_dirty = true;
+        uint64_t ahead = info.tx_sample_index - info.rx_sample_index;
+        if (samples.load() == 0) latency = ahead;
+        else if (ahead != latency.load()) indices_moved = true;
+        std::fill(tx, tx + n, 0.25f);
+        samples += n;
+    });
+    ASSERT(driver.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    driver.stop();
+
+    ASSERT(!driver.is_running());
+    ASSERT(samples.load() > 0);
+    ASSERT(!tx_dirty.load());
+    ASSERT(!indices_moved.load() && latency.load() > 0);
+    ASSERT(driver.get_latency_ms() > 0.0f);
+}
+#endif
+
+#ifdef PAL_WITH_JACK
+TEST(test_jack_driver_runs_cycles) {
+    // Needs a running server, e.g. headless: jackd -d dummy -r 48000 -p 256
+    pal::JackAudioDriver driver;
+    ASSERT(driver.initialize("pal-test", 48000, 256));
+
+    // The output port buffer is cleared before each cycle; RX indices
+    // follow each other and TX stays a fixed distance ahead
+    std::atomic<size_t> samples{0};
+    std::atomic<bool> tx_dirty{false};
+    std::atomic<bool> indices_moved{false};
+    std::atomic<uint64_t> latency{0};
+    driver.set_timed_audio_callback([&](const pal::AudioBlockInfo& info, const float*, float* tx, size_t n) {
+        if (std::any_of(tx, tx + n, [](float s) { return s != 0.0f; })) tx_dirty = true;
+        uint64_t ahead = info.tx_sample_index - info.rx_sample_index;
+        if (samples.load() == 0) latency = ahead;
+        else if (ahead != latency.load() || info.rx_sample_index != samples.load()) indices_moved = true;
+        std::fill(tx, tx + n, 0.25f);
+        samples += n;
+    });
+    ASSERT(driver.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    driver.stop();
+
+    ASSERT(samples.load() > 0);
+    ASSERT(!tx_dirty.load());
+    ASSERT(!indices_moved.load() && latency.load() > 0);
+    ASSERT(driver.get_buffer_frames() > 0);
+    ASSERT(driver.get_latency_ms() > 0.0f);
+}
+#endif
+
+int main() {
+    std::cout << "=== Audio Driver Unit Tests ===\n\n";
+
+    RUN_TEST(test_file_driver_wav_roundtrip);
+    RUN_TEST(test_file_driver_rejects_rate_mismatch);
+    RUN_TEST(test_file_driver_raw_float_input);
+    RUN_TEST(test_file_driver_unaligned_float_wav);
+    RUN_TEST(test_file_driver_paced_speed);
+    RUN_TEST(test_loopback_tx_becomes_next_rx);
+    RUN_TEST(test_loopback_frequency_offset);
+    RUN_TEST(test_loopback_awgn_level);
+    RUN_TEST(test_loopback_thread_stats);
+    RUN_TEST(test_loopback_timed_callback_indices);
+    RUN_TEST(test_file_driver_timed_callback);
+    RUN_TEST(test_default_timed_adapter);
+    RUN_TEST(test_file_driver_native_callback);
+    RUN_TEST(test_default_native_adapter);
+    RUN_TEST(test_monitor_flags_over_budget);
+    RUN_TEST(test_monitor_passes_through_timed_info);
+    RUN_TEST(test_aggregate_tracks_slave_drift);
+    RUN_TEST(test_aggregate_float_channel_and_stall);
+#ifdef PAL_WITH_SHM_AUDIO
+    RUN_TEST(test_shm_roundtrip_and_index_lock);
+    RUN_TEST(test_shm_consumer_restart_keeps_indices);
+    RUN_TEST(test_shm_rejects_rate_and_stops_on_close);
+#endif
+#ifdef PAL_WITH_ALSA
+    RUN_TEST(test_alsa_driver_runs_periods);
+#endif
+#ifdef PAL_WITH_JACK
+    RUN_TEST(test_jack_driver_runs_cycles);
+#endif
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file test_audio_ring.cpp
+ * @brief Unit tests for SpscRing
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/audio_ring.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+#define ASSERT_NEAR(a, b, tol) if (std::abs((a) - (b)) > (tol)) \
+    throw std::runtime_error("Assertion failed: " #a " != " #b)
+
+// Event handler that records emitted events
+class RecordingEventHandler : public pal::IEventHandler {
+public:
+    void on(pal::EventType, pal::EventCallback) override {}
+    void on_any(pal::EventCallback) override {}
+    void emit(const pal::Event& event) override { events.push_back(event); }
+    void emit(pal::EventType type, const std::string& message) override {
+        pal::Event event{};
+        event.type = type;
+        event.message = message;
+        events.push_back(event);
+    }
+
+    std::vector<pal::Event> events;
+};
+
+TEST(test_capacity_rounded_to_pow2) {
+    pal::AudioRing ring(1000);
+    ASSERT(ring.capacity() == 1024);
+    ASSERT(ring.size() == 0);
+}
+
+TEST(test_write_read_roundtrip) {
+    pal::AudioRing ring(16);
+    float in[10], out[10];
+    for (int i = 0; i < 10; i++) in[i] = static_cast<float>(i);
+
+    ASSERT(ring.write(in, 10) == 10);
+    ASSERT(ring.size() == 10);
+    ASSERT(ring.read(out, 10) == 10);
+    for (int i = 0; i < 10; i++) ASSERT(out[i] == in[i]);
+
+    ASSERT(ring.get_write_index() == 10);
+    ASSERT(ring.get_read_index() == 10);
+}
+
+TEST(test_regions_wrap_into_two_spans) {
+    pal::AudioRing16 ring(16);
+    int16_t buf[12] = {};
+
+    // Advance positions to 12 so the next 8 samples wrap
+    ring.write(buf, 12);
+    ring.read(buf, 12);
+
+    auto w = ring.write_regions(8);
+    ASSERT(w.first_count == 4);
+    ASSERT(w.second_count == 4);
+    ASSERT(w.second < w.first);
+    for (size_t i = 0; i < w.first_count; i++) w.first[i] = static_cast<int16_t>(i);
+    for (size_t i = 0; i < w.second_count; i++) w.second[i] = static_cast<int16_t>(4 + i);
+    ring.commit_write(w.total());
+
+    auto r = ring.read_regions();
+    ASSERT(r.total() == 8);
+    ASSERT(r.first_count == 4);
+    ASSERT(r.first[3] == 3);
+    ASSERT(r.second[0] == 4);
+    ring.commit_read(r.total());
+    ASSERT(ring.size() == 0);
+}
+
+TEST(test_overrun_and_underrun_counted) {
+    pal::AudioRing ring(8);
+    float buf[12] = {};
+
+    ASSERT(ring.write(buf, 12) == 8);
+    ASSERT(ring.get_overruns() == 1);
+    ASSERT(ring.get_overrun_samples() == 4);
+
+    ASSERT(ring.read(buf, 12) == 8);
+    ASSERT(ring.get_underruns() == 1);
+    ASSERT(ring.get_underrun_samples() == 4);
+}
+
+TEST(test_high_water_mark) {
+    pal::AudioRing ring(64);
+    float buf[64] = {};
+
+    ring.write(buf, 40);
+    ring.read(buf, 30);
+    ring.write(buf, 10);
+    ASSERT(ring.get_high_water_mark() == 40);
+
+    ring.reset_high_water_mark();
+    ASSERT(ring.get_high_water_mark() == 20);
+}
+
+TEST(test_events_emitted_once_per_change) {
+    pal::AudioRing ring(4);
+    RecordingEventHandler handler;
+    float buf[8] = {};
+
+    ring.write(buf, 8);
+    ring.read(buf, 8);
+    ring.emit_events(handler);
+    ASSERT(handler.events.size() == 2);
+    ASSERT(handler.events[0].type == pal::EventType::AUDIO_OVERRUN);
+    ASSERT(handler.events[0].code == 1);
+    ASSERT(handler.events[1].type == pal::EventType::AUDIO_UNDERRUN);
+
+    // Nothing new, nothing emitted
+    ring.emit_events(handler);
+    ASSERT(handler.events.size() == 2);
+}
+
+TEST(test_threaded_stream_is_intact) {
+    pal::AudioRing ring(256);
+    const size_t total = 1 << 20;
+
+    std::thread producer([&]() {
+        float block[48];
+        size_t next = 0;
+        while (next < total) {
+            size_t n = std::min<size_t>(48, total - next);
+            for (size_t i = 0; i < n; i++) block[i] = static_cast<float>(next + i);
+            auto w = ring.write_regions(n);
+            if (w.total() < n) { std::this_thread::yield(); continue; }
+            std::copy(block, block + w.first_count, w.first);
+            std::copy(block + w.first_count, block + n, w.second);
+            ring.commit_write(n);
+            next += n;
+        }
+    });
+
+    size_t expected = 0;
+    bool ok = true;
+    while (expected < total) {
+        auto r = ring.read_regions(100);
+        for (size_t i = 0; i < r.first_count; i++) ok &= (r.first[i] == static_cast<float>(expected++));
+        for (size_t i = 0; i < r.second_count; i++) ok &= (r.second[i] == static_cast<float>(expected++));
+        ring.commit_read(r.total());
+        if (r.total() == 0) std::this_thread::yield();
+    }
+    producer.join();
+
+    ASSERT(ok);
+    ASSERT(ring.get_overruns() == 0);
+}
+
+int main() {
+    std::cout << "=== Audio Ring Unit Tests ===\n\n";
+
+    RUN_TEST(test_capacity_rounded_to_pow2);
+    RUN_TEST(test_write_read_roundtrip);
+    RUN_TEST(test_regions_wrap_into_two_spans);
+    RUN_TEST(test_overrun_and_underrun_counted);
+    RUN_TEST(test_high_water_mark);
+    RUN_TEST(test_events_emitted_once_per_change);
+    RUN_TEST(test_threaded_stream_is_intact);
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
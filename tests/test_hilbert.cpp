@@ -0,0 +1,156 @@
+/**
+ * @file test_hilbert.cpp
+ * @brief Unit tests for Hilbert class
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/hilbert.h"
+#include "pal/resampler.h"
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+#define ASSERT_NEAR(a, b, tol) if (std::abs((a) - (b)) > (tol)) \
+    throw std::runtime_error("Assertion failed: " #a " != " #b)
+
+// Generate sine wave
+std::vector<float> generate_sine(float freq, float sample_rate, size_t count) {
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = std::sin(2.0f * M_PI * freq * i / sample_rate);
+    }
+    return samples;
+}
+
+// Check |I + jQ| is flat and the phase advances at +freq
+void check_analytic(const float* i_out, const float* q_out, size_t start, size_t end,
+                    float freq, float sample_rate, float amplitude) {
+    float expected_step = 2.0f * M_PI * freq / sample_rate;
+    for (size_t n = start; n < end; n++) {
+        float mag = std::sqrt(i_out[n] * i_out[n] + q_out[n] * q_out[n]);
+        ASSERT_NEAR(mag, amplitude, 0.03f * amplitude);
+
+        float step = std::atan2(q_out[n], i_out[n]) - std::atan2(q_out[n - 1], i_out[n - 1]);
+        if (step < -M_PI) step += 2.0f * M_PI;
+        if (step > M_PI) step -= 2.0f * M_PI;
+        ASSERT_NEAR(step, expected_step, 0.05f);
+    }
+}
+
+TEST(test_taps_rounded_to_4k_plus_3) {
+    pal::Hilbert h64(64);
+    ASSERT(h64.get_num_taps() == 67);
+    ASSERT(h64.get_delay() == 33);
+
+    pal::Hilbert h63(63);
+    ASSERT(h63.get_num_taps() == 63);
+}
+
+TEST(test_analytic_signal_in_passband) {
+    const float freqs[] = { 500.0f, 1000.0f, 1800.0f, 2700.0f };
+
+    for (float freq : freqs) {
+        pal::Hilbert hilbert;
+        auto input = generate_sine(freq, 8000.0f, 1000);
+        std::vector<float> i_out(input.size()), q_out(input.size());
+
+        hilbert.process(input.data(), input.size(), i_out.data(), q_out.data());
+        check_analytic(i_out.data(), q_out.data(), 100, input.size(), freq, 8000.0f, 1.0f);
+    }
+}
+
+TEST(test_in_phase_is_delayed_input) {
+    pal::Hilbert hilbert;
+    auto input = generate_sine(1000.0f, 8000.0f, 500);
+    std::vector<float> i_out(input.size()), q_out(input.size());
+
+    hilbert.process(input.data(), input.size(), i_out.data(), q_out.data());
+
+    size_t delay = static_cast<size_t>(hilbert.get_delay());
+    for (size_t n = delay; n < input.size(); n++) {
+        ASSERT_NEAR(i_out[n], input[n - delay], 1e-6f);
+    }
+}
+
+TEST(test_block_size_independent) {
+    pal::Hilbert a, b;
+    auto input = generate_sine(1200.0f, 8000.0f, 1000);
+    std::vector<float> ia(input.size()), qa(input.size());
+    std::vector<float> ib(input.size()), qb(input.size());
+
+    a.process(input.data(), input.size(), ia.data(), qa.data());
+    for (size_t pos = 0; pos < input.size(); pos += 37) {
+        size_t len = std::min<size_t>(37, input.size() - pos);
+        b.process(input.data() + pos, len, ib.data() + pos, qb.data() + pos);
+    }
+
+    for (size_t n = 0; n < input.size(); n++) {
+        ASSERT_NEAR(qa[n], qb[n], 1e-5f);
+    }
+}
+
+TEST(test_fused_decimate) {
+    pal::Resampler resampler(6);
+    pal::Hilbert hilbert;
+
+    // 1kHz at 48kHz -> analytic 1kHz at 8kHz
+    auto input = generate_sine(1000.0f, 48000.0f, 4800);
+    std::vector<float> i_out(input.size() / 6), q_out(input.size() / 6);
+
+    size_t out_count = hilbert.decimate(resampler, input.data(), input.size(),
+                                        i_out.data(), q_out.data());
+
+    ASSERT(out_count == 800);
+    check_analytic(i_out.data(), q_out.data(), 100, out_count, 1000.0f, 8000.0f, 1.0f);
+}
+
+TEST(test_reset_clears_history) {
+    pal::Hilbert hilbert;
+    auto input = generate_sine(1000.0f, 8000.0f, 200);
+    std::vector<float> i_out(200), q_out(200);
+    hilbert.process(input.data(), input.size(), i_out.data(), q_out.data());
+
+    hilbert.reset();
+
+    std::vector<float> zeros(200, 0.0f);
+    hilbert.process(zeros.data(), zeros.size(), i_out.data(), q_out.data());
+    for (size_t n = 0; n < zeros.size(); n++) {
+        ASSERT(i_out[n] == 0.0f && q_out[n] == 0.0f);
+    }
+}
+
+int main() {
+    std::cout << "=== Hilbert Unit Tests ===\n\n";
+
+    RUN_TEST(test_taps_rounded_to_4k_plus_3);
+    RUN_TEST(test_analytic_signal_in_passband);
+    RUN_TEST(test_in_phase_is_delayed_input);
+    RUN_TEST(test_block_size_independent);
+    RUN_TEST(test_fused_decimate);
+    RUN_TEST(test_reset_clears_history);
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
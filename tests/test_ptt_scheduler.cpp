@@ -0,0 +1,277 @@
+/**
+ * @file test_ptt_scheduler.cpp
+ * @brief Unit tests for PttScheduler
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/ptt_scheduler.h"
+#include "pal/radio.h"
+#include "pal/timer.h"
+#include "pal/tx_scheduler.h"
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+
+// Scheduling slack allowed on a loaded test machine
+static const uint64_t SLACK_US = 20000;
+
+// Event handler that records emitted events
+class RecordingEventHandler : public pal::IEventHandler {
+public:
+    void on(pal::EventType, pal::EventCallback) override {}
+    void on_any(pal::EventCallback) override {}
+    void emit(const pal::Event& event) override { events.push_back(event); }
+    void emit(pal::EventType type, const std::string& message) override {
+        pal::Event event{};
+        event.type = type;
+        event.message = message;
+        events.push_back(event);
+    }
+
+    std::vector<pal::Event> events;
+};
+
+class SteadyTimer : public pal::ITimer {
+public:
+    uint64_t get_time_ms() const override { return get_time_us() / 1000; }
+    uint64_t get_time_us() const override {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    void sleep_ms(uint32_t ms) override { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+    void sleep_us(uint32_t us) override { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+};
+
+// Radio that records when set_ptt() was called
+class PttRecordingRadio : public pal::IRadio {
+public:
+    explicit PttRecordingRadio(const pal::ITimer& timer) : timer_(timer) {}
+
+    bool initialize() override { return true; }
+    void shutdown() override {}
+    bool start() override { return true; }
+    void stop() override {}
+    bool set_channel(const pal::Channel&) override { return true; }
+    pal::Channel get_channel() const override { return pal::Channel(); }
+    void set_ptt(bool transmit) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        calls.push_back(Call{transmit, timer_.get_time_us()});
+        transmitting_ = transmit;
+    }
+    bool is_transmitting() const override { return transmitting_; }
+    bool is_ready() const override { return true; }
+    std::string get_port_config() const override { return "9600,n,8,1"; }
+    void register_send_callback(SendCommandCallback) override {}
+    void register_ack_callback(AckCallback) override {}
+    void process_response(const uint8_t*, size_t) override {}
+
+    struct Call {
+        bool transmit;
+        uint64_t time_us;
+    };
+
+    std::vector<Call> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls;
+    }
+
+private:
+    const pal::ITimer& timer_;
+    std::mutex mutex_;
+    std::vector<Call> calls;
+    bool transmitting_ = false;
+};
+
+// Anchor TX index 0 at the given time, as an audio callback would
+static void anchor(pal::PttScheduler& ptt, uint64_t time_us) {
+    pal::AudioBlockInfo info;
+    info.tx_sample_index = 0;
+    info.tx_time_us = time_us;
+    ptt.update_clock(info);
+}
+
+// Poll until the radio has seen the given number of set_ptt() calls
+static std::vector<PttRecordingRadio::Call> wait_calls(PttRecordingRadio& radio, size_t count,
+                                                        uint32_t timeout_ms = 2000) {
+    for (uint32_t waited = 0; waited < timeout_ms; waited++) {
+        std::vector<PttRecordingRadio::Call> calls = radio.snapshot();
+        if (calls.size() >= count) return calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return radio.snapshot();
+}
+
+TEST(test_serial_wire_time) {
+    pal::SerialConfig serial;
+    serial.baud_rate = 9600;
+    ASSERT(pal::serial_wire_time_us(serial, 1) == 1042);   // 10 bits, rounded up
+    ASSERT(pal::serial_wire_time_us(serial, 96) == 100000);
+
+    serial.parity = pal::Parity::EVEN;
+    serial.stop_bits = pal::StopBits::TWO;
+    ASSERT(pal::serial_wire_time_us(serial, 8) == 10000);  // 12 bits per byte
+
+    serial.baud_rate = 0;
+    ASSERT(pal::serial_wire_time_us(serial, 8) == 0);
+}
+
+TEST(test_keys_ahead_of_first_sample) {
+    SteadyTimer timer;
+    PttRecordingRadio radio(timer);
+
+    pal::PttSchedulerConfig config;
+    config.sample_rate = 8000;
+    config.timing.lead_us = 10000;
+    config.timing.key_up_delay_us = 5000;
+    config.timing.tail_us = 2000;
+    config.timing.key_command_bytes = 5;        // Yaesu CAT, 9600 8N1
+    pal::PttScheduler ptt(radio, timer, config);
+    ASSERT(ptt.key_advance_us() == 10000 + 5000 + 5209);
+    ASSERT(ptt.start());
+
+    uint64_t t0 = timer.get_time_us();
+    anchor(ptt, t0);
+    ASSERT(ptt.index_to_time_us(800) == t0 + 100000);
+
+    // Samples [800, 1600): first plays at +100 ms, last ends at +200 ms
+    ASSERT(ptt.schedule(800, 800));
+    std::vector<PttRecordingRadio::Call> calls = wait_calls(radio, 2);
+    ASSERT(calls.size() == 2);
+
+    uint64_t key_at = t0 + 100000 - ptt.key_advance_us();
+    uint64_t unkey_at = t0 + 200000 + 2000;
+    ASSERT(calls[0].transmit && calls[0].time_us >= key_at && calls[0].time_us < key_at + SLACK_US);
+    ASSERT(!calls[1].transmit && calls[1].time_us >= unkey_at && calls[1].time_us < unkey_at + SLACK_US);
+    ASSERT(ptt.get_late_keys() == 0);
+    ASSERT(!ptt.is_keyed());
+
+    RecordingEventHandler events;
+    ptt.emit_events(events);
+    ASSERT(events.events.size() == 2);
+    ASSERT(events.events[0].type == pal::EventType::PTT_ON);
+    ASSERT(events.events[1].type == pal::EventType::PTT_OFF);
+    ASSERT(events.events[0].code >= 0 && events.events[0].code < static_cast<int32_t>(SLACK_US));
+}
+
+TEST(test_close_transmissions_stay_keyed) {
+    SteadyTimer timer;
+    PttRecordingRadio radio(timer);
+
+    pal::PttSchedulerConfig config;
+    config.sample_rate = 8000;
+    config.timing.lead_us = 20000;
+    pal::PttScheduler ptt(radio, timer, config);
+    ASSERT(ptt.start());
+    anchor(ptt, timer.get_time_us());
+
+    // 10 ms gap is shorter than the 20 ms lead: keyed from 30 ms to 160 ms
+    ASSERT(ptt.schedule(400, 400));
+    ASSERT(ptt.schedule(880, 400));
+    std::vector<PttRecordingRadio::Call> calls = wait_calls(radio, 2);
+    ASSERT(calls.size() == 2);
+    ASSERT(calls[0].transmit && !calls[1].transmit);
+    ASSERT(calls[1].time_us - calls[0].time_us >= 120000);
+
+    // A well separated transmission keys again
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT(ptt.schedule(2400, 80));
+    calls = wait_calls(radio, 4);
+    ASSERT(calls.size() == 4);
+}
+
+TEST(test_late_transmission_and_cancel) {
+    SteadyTimer timer;
+    PttRecordingRadio radio(timer);
+
+    pal::PttSchedulerConfig config;
+    config.sample_rate = 8000;
+    config.timing.lead_us = 5000;
+    pal::PttScheduler ptt(radio, timer, config);
+    ASSERT(ptt.start());
+
+    // Due 50 ms ago: keyed at once and counted late
+    anchor(ptt, timer.get_time_us() - 50000);
+    ASSERT(ptt.schedule(0, 80000));
+    std::vector<PttRecordingRadio::Call> calls = wait_calls(radio, 1);
+    ASSERT(calls.size() == 1 && calls[0].transmit);
+    ASSERT(ptt.get_late_keys() == 1);
+
+    ASSERT(ptt.schedule(90000, 8000));
+    ptt.cancel();
+    calls = wait_calls(radio, 2);
+    ASSERT(calls.size() == 2 && !calls[1].transmit);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT(radio.snapshot().size() == 2);       // Pending one was dropped
+    ASSERT(!ptt.is_keyed());
+}
+
+TEST(test_waits_for_clock_and_unkeys_on_stop) {
+    SteadyTimer timer;
+    PttRecordingRadio radio(timer);
+
+    pal::PttSchedulerConfig config;
+    config.sample_rate = 8000;
+    pal::PttScheduler ptt(radio, timer, config);
+
+    pal::TxBurst asap;
+    asap.samples.assign(80, 0.0f);
+    ASSERT(!ptt.schedule(asap));                // Not running
+    ASSERT(ptt.start());
+    ASSERT(!ptt.schedule(asap));                // No start index to key against
+
+    pal::TxBurst burst;
+    burst.start_index = 80;
+    burst.samples.assign(80000, 0.0f);
+    ASSERT(ptt.schedule(burst));
+
+    // No audio callback has reported a TX time yet
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT(radio.snapshot().empty());
+
+    // Timeless blocks are ignored
+    pal::AudioBlockInfo untimed;
+    ptt.update_clock(untimed);
+    ASSERT(ptt.index_to_time_us(80) == 0);
+
+    anchor(ptt, timer.get_time_us());
+    ASSERT(wait_calls(radio, 1).size() == 1);
+    ASSERT(ptt.is_keyed());
+
+    ptt.stop();
+    std::vector<PttRecordingRadio::Call> calls = radio.snapshot();
+    ASSERT(calls.size() == 2 && !calls[1].transmit);
+    ASSERT(!ptt.is_running());
+}
+
+int main() {
+    std::cout << "=== PTT Scheduler Unit Tests ===\n\n";
+
+    RUN_TEST(test_serial_wire_time);
+    RUN_TEST(test_keys_ahead_of_first_sample);
+    RUN_TEST(test_close_transmissions_stay_keyed);
+    RUN_TEST(test_late_transmission_and_cancel);
+    RUN_TEST(test_waits_for_clock_and_unkeys_on_stop);
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,950 @@
+/**
+ * @file test_radios.cpp
+ * @brief Unit tests for the radio protocol encoders
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/radios/cat_command_queue.h"
+#include "pal/radios/civ_codec.h"
+#include "pal/radios/civ_parser.h"
+#include "pal/radios/elecraft.h"
+#include "pal/radios/icom_civ.h"
+#include "pal/radios/kenwood.h"
+#include "pal/radios/kenwood_codec.h"
+#include "pal/radios/kenwood_parser.h"
+#include "pal/radios/radio_state_shadow.h"
+#include "pal/radios/yaesu_cat.h"
+#include "pal/radios/yaesu_parser.h"
+#include "pal/scan_list.h"
+#include "pal/timer.h"
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+
+using Bytes = std::vector<uint8_t>;
+
+// Serial port that records every write() as one entry
+class RecordingSerial : public pal::ISerial {
+public:
+    bool open(const std::string&, const pal::SerialConfig&) override { return true; }
+    void close() override {}
+    bool is_open() const override { return true; }
+    size_t write(const uint8_t* data, size_t length) override {
+        writes.emplace_back(data, data + length);
+        return length;
+    }
+    size_t read(uint8_t*, size_t) override { return 0; }
+    void set_receive_callback(ReceiveCallback) override {}
+    void set_rts(bool) override {}
+    void set_dtr(bool) override {}
+    bool get_cts() const override { return false; }
+    bool get_dsr() const override { return false; }
+    void flush() override {}
+    size_t available() const override { return 0; }
+
+    std::vector<Bytes> writes;
+};
+
+// Timer advanced by hand
+class ManualTimer : public pal::ITimer {
+public:
+    uint64_t now_us = 5000000;
+    uint64_t get_time_ms() const override { return now_us / 1000; }
+    uint64_t get_time_us() const override { return now_us; }
+    void sleep_ms(uint32_t ms) override { now_us += ms * 1000ull; }
+    void sleep_us(uint32_t us) override { now_us += us; }
+};
+
+template <size_t N>
+static Bytes bytes_of(const pal::CivBuffer<N>& buffer) {
+    return Bytes(buffer.data(), buffer.data() + buffer.size());
+}
+
+template <size_t N>
+static std::string text_of(const pal::KenwoodBuffer<N>& buffer) {
+    return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+static std::string text_of(const Bytes& bytes) {
+    return std::string(bytes.begin(), bytes.end());
+}
+
+static pal::Channel make_channel(uint32_t freq_hz, pal::RadioMode mode) {
+    pal::Channel channel;
+    channel.rx_frequency = freq_hz;
+    channel.tx_frequency = freq_hz;
+    channel.rx_mode = mode;
+    channel.tx_mode = mode;
+    return channel;
+}
+
+TEST(test_civ_codec_frames) {
+    pal::CivCodec codec(pal::IcomRadioAddress::IC_7300);
+
+    pal::CivFrameBuffer frame;
+    ASSERT(codec.encode_freq(frame, 14250000));
+    ASSERT(bytes_of(frame) == (Bytes{0xFE, 0xFE, 0x94, 0xE0, 0x05, 0x00, 0x00, 0x25, 0x14, 0x00, 0xFD}));
+
+    uint8_t bcd[pal::CIV_FREQ_BYTES];
+    pal::CivCodec::freq_to_bcd(1234567890, bcd, sizeof(bcd));
+    ASSERT(pal::CivCodec::bcd_to_freq(bcd, sizeof(bcd)) == 1234567890);
+
+    frame.clear();
+    ASSERT(codec.encode_ptt(frame, true));
+    ASSERT(bytes_of(frame) == (Bytes{0xFE, 0xFE, 0x94, 0xE0, 0x1C, 0x00, 0x01, 0xFD}));
+
+    // A full buffer refuses whole frames and keeps what it had
+    frame.clear();
+    ASSERT(codec.encode_freq(frame, 7000000));
+    ASSERT(!codec.encode_mode(frame, pal::RadioMode::USB));
+    ASSERT(frame.size() == 11);
+
+    pal::CivBuffer<12> small;
+    ASSERT(!codec.encode_channel(small, make_channel(7000000, pal::RadioMode::LSB)));
+    ASSERT(small.empty());
+}
+
+TEST(test_icom_channel_is_one_write) {
+    RecordingSerial serial;
+    pal::IcomCiv radio(&serial, pal::IcomRadioAddress::IC_7300);
+    ASSERT(radio.initialize());
+
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 1);
+    ASSERT(serial.writes[0] == (Bytes{0xFE, 0xFE, 0x94, 0xE0, 0x05, 0x00, 0x40, 0x07, 0x07, 0x00, 0xFD,
+                                      0xFE, 0xFE, 0x94, 0xE0, 0x06, 0x01, 0xFD}));
+
+    radio.set_ptt(true);
+    radio.set_ptt(false);
+    ASSERT(serial.writes.size() == 3);
+    ASSERT(serial.writes[2] == (Bytes{0xFE, 0xFE, 0x94, 0xE0, 0x1C, 0x00, 0x00, 0xFD}));
+
+    // Address changes reach the encoder
+    radio.set_radio_address(pal::IcomRadioAddress::IC_7610);
+    radio.set_ptt(true);
+    ASSERT(serial.writes[3][2] == 0x98);
+    ASSERT(radio.codec().get_radio_address() == 0x98);
+}
+
+TEST(test_kenwood_codec_matches_printf) {
+    const uint32_t freqs[] = {0, 1, 99, 100, 7074000, 14250000, 54000000, 4294967295u};
+    for (uint32_t freq : freqs) {
+        char expected[24];
+        std::snprintf(expected, sizeof(expected), "FB%011u;", freq);
+        pal::KenwoodCommandBuffer command;
+        ASSERT(pal::KenwoodCodec::encode_freq(command, 'B', freq));
+        ASSERT(text_of(command) == expected);
+    }
+
+    pal::KenwoodCommandBuffer command;
+    ASSERT(pal::KenwoodCodec::encode_number(command, "PC", 5, 3));
+    ASSERT(pal::KenwoodCodec::encode_ptt(command, false));
+    ASSERT(text_of(command) == "PC005;RX;");
+
+    // Full buffers refuse whole commands
+    ASSERT(!pal::KenwoodCodec::encode_freq(command, 'A', 14250000));
+    ASSERT(text_of(command) == "PC005;RX;");
+    pal::KenwoodBuffer<16> small;
+    ASSERT(!pal::KenwoodCodec::encode_channel(small, make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(small.empty());
+}
+
+TEST(test_kenwood_and_elecraft_writes) {
+    RecordingSerial serial;
+    pal::Kenwood radio(&serial);
+    ASSERT(radio.initialize());
+
+    ASSERT(radio.set_channel(make_channel(14250000, pal::RadioMode::LSB)));
+    radio.set_ptt(true);
+    ASSERT(serial.writes.size() == 2);
+    ASSERT(text_of(serial.writes[0]) == "FA00014250000;MD1;");
+    ASSERT(text_of(serial.writes[1]) == "TX;");
+
+    pal::Elecraft k3(&serial);
+    ASSERT(k3.initialize());
+    k3.set_power(50);
+    k3.set_antenna(2);
+    ASSERT(text_of(serial.writes[2]) == "PC050;");
+    ASSERT(text_of(serial.writes[3]) == "AN2;");
+}
+
+TEST(test_shadow_sends_only_changes) {
+    RecordingSerial serial;
+    pal::IcomCiv radio(&serial, pal::IcomRadioAddress::IC_7300);
+    ASSERT(radio.initialize());
+
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 1);
+
+    // Same mode: frequency frame only
+    ASSERT(radio.set_channel(make_channel(7076000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 2);
+    ASSERT(serial.writes[1] == (Bytes{0xFE, 0xFE, 0x94, 0xE0, 0x05, 0x00, 0x60, 0x07, 0x07, 0x00, 0xFD}));
+    ASSERT(radio.get_channel().rx_frequency == 7076000);
+
+    // A NAK forces a full re-sync
+    const uint8_t nak[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_NAK, 0xFD};
+    radio.process_response(nak, sizeof(nak));
+    ASSERT(radio.set_channel(make_channel(7076000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 3 && serial.writes[2].size() == 18);
+
+    // So does a reconnect
+    ASSERT(radio.start());
+    ASSERT(radio.set_channel(make_channel(7076000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 4 && serial.writes[3].size() == 18);
+    ASSERT(radio.state_shadow().fields_suppressed() == 3);
+
+    // And talking to another radio
+    radio.set_radio_address(0x98);
+    ASSERT(radio.set_channel(make_channel(7076000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 5 && serial.writes[4].size() == 18 && serial.writes[4][2] == 0x98);
+
+    // Yaesu: one 5-byte command per changed field
+    pal::YaesuCat yaesu(&serial);
+    ASSERT(yaesu.initialize());
+    yaesu.set_managed_fields(pal::RadioStateField::ALL);
+    ASSERT(yaesu.state_shadow().managed() ==
+           (pal::RadioStateField::FREQUENCY | pal::RadioStateField::MODE | pal::RadioStateField::SPLIT));
+    ASSERT(yaesu.set_channel(make_channel(14250000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 8);
+    ASSERT(yaesu.set_channel(make_channel(14070000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 9);
+    ASSERT(serial.writes[8] == (Bytes{0x01, 0x40, 0x70, 0x00, 0x01}));
+
+    // Pre-encoded (scan list) channels go out the same way
+    uint8_t encoded[16];
+    pal::Channel hop = make_channel(7074000, pal::RadioMode::LSB);
+    size_t length = yaesu.encode_channel(hop, encoded, sizeof(encoded));
+    ASSERT(length == 15 && yaesu.send_encoded_channel(hop, encoded, length));
+    ASSERT(serial.writes.size() == 12);
+    ASSERT(serial.writes[9].size() == 5 && serial.writes[10] == (Bytes{0x00, 0x00, 0x00, 0x00, 0x07}));
+    ASSERT(serial.writes[11] == (Bytes{0x00, 0x00, 0x00, 0x00, 0x82}));
+}
+
+TEST(test_shadow_managed_fields) {
+    pal::Channel channel = make_channel(14250000, pal::RadioMode::LSB);
+    channel.tx_frequency = 14255000;
+    channel.antenna = 2;
+    channel.power = 50;
+    channel.attenuation = 10;
+
+    RecordingSerial serial;
+    pal::Kenwood radio(&serial);
+    ASSERT(radio.initialize());
+    radio.set_managed_fields(pal::RadioStateField::ALL);
+
+    ASSERT(radio.set_channel(channel));
+    ASSERT(text_of(serial.writes[0]) == "FA00014250000;MD1;FB00014255000;FT1;AN2;PC050;RA01;");
+
+    channel.power = 25;
+    ASSERT(radio.set_channel(channel));
+    ASSERT(text_of(serial.writes[1]) == "PC025;");
+
+    channel.tx_frequency = channel.rx_frequency;
+    ASSERT(radio.set_channel(channel));
+    ASSERT(text_of(serial.writes[2]) == "FT0;");
+
+    const uint8_t error[] = {'?', ';'};
+    radio.process_response(error, sizeof(error));
+    ASSERT(radio.set_channel(channel));
+    ASSERT(text_of(serial.writes[3]) == "FA00014250000;MD1;FT0;AN2;PC025;RA01;");
+
+    // CI-V levels: 50 % -> 0128, attenuator 20 dB -> 0x20
+    pal::CivCodec codec(pal::IcomRadioAddress::IC_7300);
+    pal::CivStateBuffer frames;
+    channel.power = 50;
+    channel.attenuation = 20;
+    ASSERT(codec.encode_state(frames, channel, pal::RadioStateField::POWER | pal::RadioStateField::ATTENUATION));
+    ASSERT(bytes_of(frames) == (Bytes{0xFE, 0xFE, 0x94, 0xE0, 0x14, 0x0A, 0x01, 0x28, 0xFD,
+                                      0xFE, 0xFE, 0x94, 0xE0, 0x11, 0x20, 0xFD}));
+}
+
+TEST(test_scan_list_hops) {
+    RecordingSerial serial;
+    pal::IcomCiv radio(&serial, pal::IcomRadioAddress::IC_7300);
+    ASSERT(radio.initialize());
+
+    pal::ScanList scan(radio);   // 9600 8N1
+    scan.add(make_channel(3596000, pal::RadioMode::USB));
+    scan.add(make_channel(7102000, pal::RadioMode::USB));
+    scan.add(make_channel(10145500, pal::RadioMode::LSB));
+    ASSERT(scan.compile());
+    ASSERT(scan.is_compiled() && scan.get_compile_count() == 1);
+
+    // One write of the pre-encoded bytes, 18 bytes x 10 bits at 9600 baud
+    pal::ScanHop hop = scan.hop(1);
+    ASSERT(hop.ok && hop.index == 1 && hop.bytes == 18);
+    ASSERT(hop.wire_time_us == 18750 && scan.wire_time_us(1) == 18750);
+    ASSERT(serial.writes.size() == 1);
+    ASSERT(serial.writes[0] == Bytes(scan.bytes(1), scan.bytes(1) + scan.length(1)));
+    ASSERT(radio.get_channel().rx_frequency == 7102000);
+
+    // The radio adopted the channel: set_channel has nothing to send
+    ASSERT(radio.set_channel(make_channel(7102000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 1);
+
+    ASSERT(scan.next().index == 2);
+    ASSERT(scan.next().index == 0);
+    ASSERT(scan.get_compile_count() == 1);
+
+    // Address change: stale, recompiled on the next hop
+    radio.set_radio_address(pal::IcomRadioAddress::IC_7610);
+    ASSERT(!scan.is_compiled());
+    ASSERT(scan.next().ok);
+    ASSERT(scan.get_compile_count() == 2);
+    ASSERT(serial.writes.back()[2] == 0x98);
+
+    // Protocol change
+    pal::Kenwood kenwood(&serial);
+    ASSERT(kenwood.initialize());
+    scan.set_radio(kenwood);
+    hop = scan.hop(2);
+    ASSERT(hop.ok && scan.get_compile_count() == 3);
+    ASSERT(text_of(serial.writes.back()) == "FA00010145500;MD1;");
+
+    ASSERT(!scan.hop(3).ok);
+}
+
+TEST(test_cat_queue_civ_window) {
+    ManualTimer timer;
+    std::vector<Bytes> writes;
+    std::vector<pal::CatCompletion> done;
+    std::vector<Bytes> replies;
+    auto record = [&](const pal::CatCompletion& c) {
+        done.push_back(c);
+        replies.emplace_back(c.reply, c.reply + c.reply_length);
+    };
+
+    pal::CatQueueConfig config;
+    config.window = 2;
+    pal::CatCommandQueue queue([&](const uint8_t* d, size_t n) { writes.emplace_back(d, d + n); },
+                               timer, config);
+
+    pal::CivCodec codec(pal::IcomRadioAddress::IC_7300);
+    pal::CivChannelBuffer channel;
+    codec.encode_channel(channel, make_channel(7074000, pal::RadioMode::USB));
+    pal::CivFrameBuffer ptt;
+    codec.encode_ptt(ptt, true);
+    pal::CivFrameBuffer read;
+    codec.encode(read, pal::CivCommand::READ_FREQ);
+
+    uint64_t first = queue.submit(channel.data(), channel.size(), record);
+    queue.submit(ptt.data(), ptt.size(), record);
+    queue.submit(read.data(), read.size(), record);
+    ASSERT(first != 0);
+    ASSERT(writes.size() == 2 && queue.in_flight() == 2 && queue.pending() == 1);
+
+    // Our own echo is ignored; two ACKs complete the two-frame command
+    const uint8_t ack[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_ACK, 0xFD};
+    timer.now_us += 12000;
+    queue.on_receive(channel.data(), channel.size());
+    queue.on_receive(ack, sizeof(ack));
+    ASSERT(done.empty());
+    queue.on_receive(ack, sizeof(ack));
+    ASSERT(done.size() == 1 && done[0].id == first);
+    ASSERT(done[0].result == pal::CatResult::OK && done[0].attempts == 1);
+    ASSERT(done[0].latency_us == 12000);
+    ASSERT(writes.size() == 3 && writes[2] == bytes_of(read));
+
+    // Split across reads, the frequency reply completes the read
+    queue.on_receive(ack, sizeof(ack));
+    const uint8_t freq[] = {0xFE, 0xFE, 0xE0, 0x94, 0x03, 0x00, 0x40, 0x07, 0x07, 0x00, 0xFD};
+    queue.on_receive(freq, 4);
+    queue.on_receive(freq + 4, sizeof(freq) - 4);
+    ASSERT(done.size() == 3);
+    ASSERT(replies[2] == Bytes(freq, freq + sizeof(freq)));
+    ASSERT(pal::CivCodec::bcd_to_freq(replies[2].data() + 5, 5) == 7074000);
+    ASSERT(queue.idle());
+    ASSERT(queue.get_stats().completed == 3 && queue.get_stats().unmatched == 0);
+}
+
+TEST(test_cat_queue_civ_nak_window) {
+    ManualTimer timer;
+    std::vector<Bytes> writes;
+    std::vector<pal::CatCompletion> done;
+    auto record = [&](const pal::CatCompletion& c) { done.push_back(c); };
+
+    pal::CatQueueConfig config;
+    config.window = 2;
+    config.serial.baud_rate = 0;
+    pal::CatCommandQueue queue([&](const uint8_t* d, size_t n) { writes.emplace_back(d, d + n); },
+                               timer, config);
+
+    pal::CivCodec codec(pal::IcomRadioAddress::IC_7300);
+    pal::CivChannelBuffer channel;
+    codec.encode_channel(channel, make_channel(7074000, pal::RadioMode::USB));
+    pal::CivFrameBuffer ptt;
+    codec.encode_ptt(ptt, true);
+    uint64_t first = queue.submit(channel.data(), channel.size(), record);
+    uint64_t second = queue.submit(ptt.data(), ptt.size(), record);
+    ASSERT(writes.size() == 2 && queue.in_flight() == 2);
+
+    // Frequency refused with the PTT command already out: a re-send would
+    // reach the radio after it, so the channel request fails at once
+    const uint8_t ack[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_ACK, 0xFD};
+    const uint8_t nak[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_NAK, 0xFD};
+    queue.on_receive(nak, sizeof(nak));
+    ASSERT(done.size() == 1 && done[0].id == first && done[0].result == pal::CatResult::NAK);
+    ASSERT(done[0].attempts == 1 && queue.in_flight() == 1 && queue.pending() == 0);
+
+    // Mode accepted: that FB belongs to the channel request, not to PTT
+    queue.on_receive(ack, sizeof(ack));
+    ASSERT(done.size() == 1);
+    queue.on_receive(ack, sizeof(ack));
+    ASSERT(done.size() == 2 && done[1].id == second && done[1].result == pal::CatResult::OK);
+
+    timer.now_us += 1000000;
+    queue.poll();
+    ASSERT(writes.size() == 2 && queue.idle());
+    ASSERT(queue.get_stats().naks == 1 && queue.get_stats().retries == 0);
+
+    // Through a radio: 7 MHz refused behind 14 MHz never comes back to
+    // override it, and the shadow no longer vouches for 14 MHz
+    RecordingSerial serial;
+    pal::CatCommandQueue radio_queue([&](const uint8_t* d, size_t n) { serial.write(d, n); }, timer, config);
+    pal::IcomCiv radio(&serial, pal::IcomRadioAddress::IC_7300);
+    ASSERT(radio.initialize());
+    radio.set_command_queue(&radio_queue);
+    ASSERT(radio.set_channel_async(make_channel(7074000, pal::RadioMode::USB), nullptr));
+    ASSERT(radio.set_channel_async(make_channel(14074000, pal::RadioMode::USB), nullptr));
+    radio_queue.on_receive(nak, sizeof(nak));
+    radio_queue.on_receive(ack, sizeof(ack));
+    radio_queue.on_receive(ack, sizeof(ack));
+    timer.now_us += 1000000;
+    radio_queue.poll();
+    ASSERT(serial.writes.size() == 2 && radio_queue.idle());
+    ASSERT(radio.set_channel(make_channel(14074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 3);
+}
+
+TEST(test_cat_queue_retries) {
+    ManualTimer timer;
+    std::vector<Bytes> writes;
+    std::vector<pal::CatCompletion> done;
+
+    pal::CatQueueConfig config;
+    config.timeout_us = 100000;
+    config.max_retries = 2;
+    config.backoff_us = 20000;
+    config.serial.baud_rate = 0;    // No wire time, to keep the arithmetic simple
+    pal::CatCommandQueue queue([&](const uint8_t* d, size_t n) { writes.emplace_back(d, d + n); },
+                               timer, config);
+
+    pal::CivCodec codec(pal::IcomRadioAddress::IC_7300);
+    pal::CivFrameBuffer ptt;
+    codec.encode_ptt(ptt, true);
+    auto record = [&](const pal::CatCompletion& c) { done.push_back(c); };
+    queue.submit(ptt.data(), ptt.size(), record);
+    queue.submit(ptt.data(), ptt.size(), record);
+    ASSERT(writes.size() == 1);
+
+    // Timeout, then a 20 ms backoff; the second command waits behind it
+    timer.now_us += 100000;
+    queue.poll();
+    ASSERT(writes.size() == 1 && queue.next_deadline_us() == timer.now_us + 20000);
+    timer.now_us += 20000;
+    queue.poll();
+    ASSERT(writes.size() == 2);
+
+    // NAK, 40 ms backoff, NAK again: out of retries
+    const uint8_t nak[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_NAK, 0xFD};
+    queue.on_receive(nak, sizeof(nak));
+    timer.now_us += 39999;
+    queue.poll();
+    ASSERT(writes.size() == 2);
+    timer.now_us += 1;
+    queue.poll();
+    ASSERT(writes.size() == 3);
+    queue.on_receive(nak, sizeof(nak));
+    ASSERT(done.size() == 1);
+    ASSERT(done[0].result == pal::CatResult::NAK && done[0].attempts == 3);
+    ASSERT(done[0].latency_us == 160000);
+
+    // The next command goes out at once and can time out for good
+    ASSERT(writes.size() == 4);
+    for (int i = 0; i < 10 && done.size() < 2; i++) {
+        timer.now_us += 100000;
+        queue.poll();
+    }
+    ASSERT(done.size() == 2 && done[1].result == pal::CatResult::TIMEOUT);
+
+    pal::CatQueueStats stats = queue.get_stats();
+    ASSERT(stats.failed == 2 && stats.retries == 4 && stats.naks == 2 && stats.timeouts == 4);
+    ASSERT(done[1].attempts == 3);
+}
+
+TEST(test_cat_queue_kenwood_and_yaesu) {
+    ManualTimer timer;
+    std::vector<pal::CatCompletion> done;
+    std::vector<std::string> replies;
+    auto record = [&](const pal::CatCompletion& c) {
+        done.push_back(c);
+        replies.emplace_back(reinterpret_cast<const char*>(c.reply), c.reply_length);
+    };
+
+    pal::CatQueueConfig config;
+    config.protocol = pal::CatProtocol::KENWOOD;
+    pal::CatCommandQueue kenwood(nullptr, timer, config);
+
+    // Set commands are silent: done once on the wire (14 bytes at 9600 8N1)
+    const std::string set = "FA00014250000;";
+    kenwood.submit(reinterpret_cast<const uint8_t*>(set.data()), set.size(), record);
+    ASSERT(done.size() == 1 && done[0].result == pal::CatResult::OK);
+    ASSERT(done[0].reply_us == 14584 && done[0].reply_length == 0);
+
+    // A trailing query is answered; auto-information in between is not ours
+    const std::string verify = set + "FA;";
+    kenwood.submit(reinterpret_cast<const uint8_t*>(verify.data()), verify.size(), record);
+    const std::string reply = "MD2;FA00014250000;";
+    kenwood.on_receive(reinterpret_cast<const uint8_t*>(reply.data()), reply.size());
+    ASSERT(done.size() == 2 && replies[1] == "FA00014250000;");
+    ASSERT(kenwood.get_stats().unmatched == 1);
+
+    const std::string query = "IF;";
+    kenwood.submit(reinterpret_cast<const uint8_t*>(query.data()), query.size(), record);
+    const std::string error = "?;";
+    kenwood.on_receive(reinterpret_cast<const uint8_t*>(error.data()), error.size());
+    ASSERT(kenwood.get_stats().naks == 1 && kenwood.pending() == 1);
+    kenwood.cancel_all();
+    ASSERT(done.size() == 3 && done[2].result == pal::CatResult::CANCELLED);
+
+    // Yaesu: fixed-length reply, no framing
+    config.protocol = pal::CatProtocol::YAESU;
+    pal::CatCommandQueue yaesu(nullptr, timer, config);
+    const uint8_t read_freq[] = {0x00, 0x00, 0x00, 0x00, 0x03};
+    yaesu.submit(read_freq, sizeof(read_freq), record, 5);
+    const uint8_t status[] = {0x01, 0x42, 0x50, 0x00, 0x01, 0xFF};
+    yaesu.on_receive(status, 3);
+    ASSERT(done.size() == 3);
+    yaesu.on_receive(status + 3, 3);
+    ASSERT(done.size() == 4 && done[3].reply_length == 5 && done[3].reply[4] == 0x01);
+    ASSERT(yaesu.get_stats().unmatched == 1);
+}
+
+TEST(test_async_completes_on_ack) {
+    ManualTimer timer;
+    RecordingSerial serial;
+    pal::CatCommandQueue queue([&](const uint8_t* d, size_t n) { serial.write(d, n); }, timer);
+    pal::IcomCiv radio(&serial, pal::IcomRadioAddress::IC_7300);
+    ASSERT(radio.initialize());
+
+    std::vector<pal::RadioCompletion> done;
+    auto record = [&](const pal::RadioCompletion& c) { done.push_back(c); };
+
+    // Without a queue: completes at once, unconfirmed
+    ASSERT(radio.set_ptt_async(false, record));
+    ASSERT(done.size() == 1 && done[0].ok && !done[0].confirmed);
+
+    radio.set_command_queue(&queue);
+    ASSERT(radio.set_channel_async(make_channel(7074000, pal::RadioMode::USB), record));
+    ASSERT(serial.writes.size() == 2 && done.size() == 1);
+
+    const uint8_t ack[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_ACK, 0xFD};
+    timer.now_us += 8000;
+    queue.on_receive(ack, sizeof(ack));
+    queue.on_receive(ack, sizeof(ack));
+    ASSERT(done.size() == 2 && done[1].ok && done[1].confirmed);
+    ASSERT(done[1].latency_us == 8000 && done[1].attempts == 1);
+
+    // Nothing to change: immediate
+    ASSERT(radio.set_channel_async(make_channel(7074000, pal::RadioMode::USB), record));
+    ASSERT(done.size() == 3 && done[2].ok && serial.writes.size() == 2);
+
+    // Refused on every attempt: failure, and the shadow forgets the state
+    ASSERT(radio.set_channel_async(make_channel(7076000, pal::RadioMode::USB), record));
+    const uint8_t nak[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_NAK, 0xFD};
+    for (int i = 0; i < 10 && done.size() < 4; i++) {
+        queue.on_receive(nak, sizeof(nak));
+        timer.now_us += 100000;
+        queue.poll();
+    }
+    ASSERT(done.size() == 4 && !done[3].ok && done[3].confirmed == false && done[3].attempts == 3);
+    ASSERT(radio.state_shadow().known() == pal::RadioStateField::NONE);
+
+    // Same for plain set_channel through the queue once its retries run out
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(radio.state_shadow().known() != pal::RadioStateField::NONE);
+    for (int i = 0; i < 10 && !queue.idle(); i++) {
+        timer.now_us += 1000000;
+        queue.poll();
+    }
+    ASSERT(queue.idle() && radio.state_shadow().known() == pal::RadioStateField::NONE);
+
+    ASSERT(radio.set_ptt_async(true, record));
+    queue.on_receive(ack, sizeof(ack));
+    ASSERT(done.size() == 5 && done[4].ok && radio.is_transmitting());
+}
+
+TEST(test_async_completes_on_readback) {
+    ManualTimer timer;
+    RecordingSerial serial;
+    std::vector<pal::RadioCompletion> done;
+    auto record = [&](const pal::RadioCompletion& c) { done.push_back(c); };
+    auto feed = [](pal::CatCommandQueue& queue, const std::string& text) {
+        queue.on_receive(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    };
+
+    pal::CatQueueConfig config;
+    config.protocol = pal::CatProtocol::KENWOOD;
+    pal::CatCommandQueue kenwood_queue([&](const uint8_t* d, size_t n) { serial.write(d, n); }, timer, config);
+    pal::Kenwood kenwood(&serial);
+    ASSERT(kenwood.initialize());
+    kenwood.set_command_queue(&kenwood_queue);
+
+    ASSERT(kenwood.set_channel_async(make_channel(7074000, pal::RadioMode::USB), record));
+    ASSERT(text_of(serial.writes.back()) == "FA00007074000;MD2;IF;");
+    feed(kenwood_queue, "IF00007074000     +00000000002000000 ;");
+    ASSERT(done.size() == 1 && done[0].ok && done[0].confirmed);
+
+    // The readback still says RX: answered, but not in the requested state
+    ASSERT(kenwood.set_ptt_async(true, record));
+    ASSERT(text_of(serial.writes.back()) == "TX;IF;");
+    feed(kenwood_queue, "IF00007074000     +00000000002000000 ;");
+    ASSERT(done.size() == 2 && !done[1].ok && done[1].confirmed);
+
+    // Plain set_ptt: "TX;" and "RX;" are actions, done once written
+    size_t writes = serial.writes.size();
+    kenwood.set_ptt(true);
+    kenwood.set_ptt(false);
+    ASSERT(serial.writes.size() == writes + 2);
+    ASSERT(text_of(serial.writes[writes]) == "TX;" && text_of(serial.writes[writes + 1]) == "RX;");
+    ASSERT(kenwood_queue.idle() && kenwood_queue.get_stats().timeouts == 0);
+
+    config.protocol = pal::CatProtocol::YAESU;
+    pal::CatCommandQueue yaesu_queue([&](const uint8_t* d, size_t n) { serial.write(d, n); }, timer, config);
+    pal::YaesuCat yaesu(&serial);
+    ASSERT(yaesu.initialize());
+    yaesu.set_command_queue(&yaesu_queue);
+
+    ASSERT(yaesu.set_channel_async(make_channel(7074000, pal::RadioMode::USB), record));
+    ASSERT(serial.writes.back().size() == 15 && serial.writes.back()[14] == 0x03);
+    const uint8_t freq_mode[] = {0x00, 0x70, 0x74, 0x00, 0x01};
+    yaesu_queue.on_receive(freq_mode, sizeof(freq_mode));
+    ASSERT(done.size() == 3 && done[2].ok);
+
+    ASSERT(yaesu.set_ptt_async(true, record));
+    const uint8_t transmitting[] = {0x0F};
+    yaesu_queue.on_receive(transmitting, sizeof(transmitting));
+    ASSERT(done.size() == 4 && done[3].ok);
+}
+
+TEST(test_civ_parser_messages) {
+    pal::CivParser parser(0x94);
+    std::vector<pal::CivMessage> got;
+    parser.set_handler([&](const pal::CivMessage& message) { got.push_back(message); });
+
+    // Echo of our read, then the reply split across two reads
+    const uint8_t stream[] = {
+        0xFE, 0xFE, 0x94, 0xE0, 0x03, 0xFD,
+        0xFE, 0xFE, 0xE0, 0x94, 0x03, 0x00, 0x50, 0x07, 0x07, 0x00, 0xFD,
+    };
+    parser.feed(stream, 10);
+    ASSERT(got.empty());
+    parser.feed(stream + 10, sizeof(stream) - 10);
+    ASSERT(got.size() == 1);
+    ASSERT(got[0].type == pal::CivMessageType::FREQUENCY && got[0].frequency_hz == 7075000);
+    ASSERT(!got[0].broadcast && got[0].payload_length == 5);
+    ASSERT(parser.get_stats().echoes == 1);
+
+    // Noise, a transceive mode change, an S-meter reading, ACK and NAK
+    const uint8_t frames[] = {
+        0x12, 0xFD, 0xFE, 0xFE, 0xE0,
+        0xFE, 0xFE, 0xFE, 0x00, 0x94, 0x01, 0x03, 0x02, 0xFD,
+        0xFE, 0xFE, 0xE0, 0x94, 0x15, 0x02, 0x01, 0x20, 0xFD,
+        0xFE, 0xFE, 0xE0, 0x94, 0xFB, 0xFD,
+        0xFE, 0xFE, 0xE0, 0x94, 0xFA, 0xFD,
+    };
+    parser.feed(frames, sizeof(frames));
+    ASSERT(got.size() == 5);
+    ASSERT(got[1].type == pal::CivMessageType::MODE && got[1].broadcast);
+    ASSERT(got[1].mode == pal::RadioMode::CW && got[1].filter == 2);
+    ASSERT(got[2].type == pal::CivMessageType::METER);
+    ASSERT(got[2].meter == pal::CivMeter::S_METER && got[2].level == 120);
+    ASSERT(got[3].type == pal::CivMessageType::ACK);
+    ASSERT(got[4].type == pal::CivMessageType::NAK);
+
+    // Another radio, another controller, bad BCD, a jam and an overlong
+    // frame are dropped; the parser resyncs on the next preamble
+    Bytes junk = {
+        0xFE, 0xFE, 0xE0, 0x88, 0xFB, 0xFD,
+        0xFE, 0xFE, 0xE1, 0x94, 0xFB, 0xFD,
+        0xFE, 0xFE, 0xE0, 0x94, 0x03, 0x0A, 0x00, 0x00, 0x00, 0x00, 0xFD,
+        0xFE, 0xFE, 0xE0, 0x94, 0x03, 0xFC,
+        0xFE, 0xFE, 0xE0, 0x94, 0x1A,
+    };
+    junk.insert(junk.end(), pal::CIV_PARSER_MAX_PAYLOAD + 1, 0x41);
+    junk.insert(junk.end(), {0xFD, 0xFE, 0xFE, 0xE0, 0x94, 0x04, 0x01, 0x01, 0xFD});
+    parser.feed(junk.data(), junk.size());
+    ASSERT(got.size() == 6 && got[5].type == pal::CivMessageType::MODE && got[5].mode == pal::RadioMode::USB);
+
+    const pal::CivParserStats& stats = parser.get_stats();
+    ASSERT(stats.filtered == 2);
+    ASSERT(stats.malformed == 3);       // Bad BCD, jam, early preamble in the noise
+    ASSERT(stats.overflows == 1);
+    ASSERT(stats.messages == 6);
+}
+
+TEST(test_icom_follows_front_panel) {
+    RecordingSerial serial;
+    pal::IcomCiv radio(&serial, pal::IcomRadioAddress::IC_7300);
+    ASSERT(radio.initialize());
+    int acks = 0;
+    std::vector<pal::CivMessage> got;
+    radio.register_ack_callback([&]() { acks++; });
+    radio.set_message_callback([&](const pal::CivMessage& message) { got.push_back(message); });
+
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    const uint8_t ack[] = {0xFE, 0xFE, 0xE0, 0x94, pal::CIV_ACK, 0xFD};
+    radio.process_response(ack, sizeof(ack));
+    ASSERT(acks == 1 && got.size() == 1);
+
+    // The radio confirming what we sent changes nothing
+    const uint8_t same[] = {0xFE, 0xFE, 0x00, 0x94, 0x00, 0x00, 0x40, 0x07, 0x07, 0x00, 0xFD};
+    radio.process_response(same, sizeof(same));
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 1);
+
+    // Retuned from the front panel: the frequency goes out again
+    const uint8_t moved[] = {0xFE, 0xFE, 0x00, 0x94, 0x00, 0x00, 0x00, 0x10, 0x14, 0x00, 0xFD};
+    radio.process_response(moved, sizeof(moved));
+    ASSERT(got.size() == 3 && got[2].frequency_hz == 14100000);
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 2 && serial.writes[1].size() == 11);
+    ASSERT(radio.parser_stats().messages == 3);
+}
+
+TEST(test_kenwood_parser_answers) {
+    pal::KenwoodParser parser;
+    std::vector<pal::KenwoodMessage> got;
+    std::vector<std::string> texts;
+    parser.set_handler([&](const pal::KenwoodMessage& message) {
+        got.push_back(message);
+        texts.emplace_back(message.text, message.length);
+    });
+
+    const std::string stream =
+        "FA00014074000;FB00007074000;MD3;SM00015;SM0007;TX0;RX;?;"
+        "IF00014250000     +00000000002000000 ;";
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(stream.data());
+    parser.feed(bytes, 20);                 // Splits FB across two reads
+    parser.feed(bytes + 20, stream.size() - 20);
+
+    ASSERT(got.size() == 9);
+    ASSERT(got[0].type == pal::KenwoodMessageType::FREQUENCY && got[0].vfo == 'A' && got[0].frequency_hz == 14074000);
+    ASSERT(got[1].type == pal::KenwoodMessageType::FREQUENCY && got[1].vfo == 'B' && got[1].frequency_hz == 7074000);
+    ASSERT(texts[1] == "FB00007074000;");
+    ASSERT(got[2].type == pal::KenwoodMessageType::MODE && got[2].mode == pal::RadioMode::CW);
+    ASSERT(got[3].type == pal::KenwoodMessageType::METER && got[3].meter == 0 && got[3].level == 15);
+    ASSERT(got[4].type == pal::KenwoodMessageType::METER && got[4].level == 7);
+    ASSERT(got[5].type == pal::KenwoodMessageType::TRANSMIT && got[5].transmitting);
+    ASSERT(got[6].type == pal::KenwoodMessageType::TRANSMIT && !got[6].transmitting);
+    ASSERT(got[7].type == pal::KenwoodMessageType::ERROR);
+    ASSERT(got[8].type == pal::KenwoodMessageType::INFO && got[8].frequency_hz == 14250000);
+    ASSERT(got[8].mode == pal::RadioMode::USB && !got[8].transmitting);
+    ASSERT(parser.get_stats().copied == 1);
+
+    // Bad fields are dropped, as is an overlong answer; unknown codes pass through
+    std::string junk = "FA0001407X000;MD;" + std::string(pal::KENWOOD_PARSER_MAX_ANSWER + 8, 'Z') + ";PS1;";
+    parser.feed(reinterpret_cast<const uint8_t*>(junk.data()), junk.size());
+    ASSERT(got.size() == 11);
+    ASSERT(got[9].type == pal::KenwoodMessageType::OTHER && texts[9] == "MD;");
+    ASSERT(got[10].type == pal::KenwoodMessageType::OTHER && texts[10] == "PS1;");
+    ASSERT(parser.get_stats().malformed == 1);
+    ASSERT(parser.get_stats().overflows == 1);
+}
+
+TEST(test_kenwood_auto_info) {
+    RecordingSerial serial;
+    pal::Kenwood radio(&serial);
+    ASSERT(radio.initialize());
+    std::vector<pal::KenwoodMessage> got;
+    radio.set_message_callback([&](const pal::KenwoodMessage& message) { got.push_back(message); });
+
+    ASSERT(radio.set_auto_info(pal::KenwoodAutoInfo::ON));
+    ASSERT(text_of(serial.writes.back()) == "AI2;");
+    ASSERT(radio.start());
+    ASSERT(text_of(serial.writes.back()) == "AI2;");
+
+    ASSERT(radio.set_channel(make_channel(14074000, pal::RadioMode::USB)));
+    size_t writes = serial.writes.size();
+
+    // Pushed back unchanged: nothing to send
+    const std::string same = "FA00014074000;MD2;";
+    radio.process_response(reinterpret_cast<const uint8_t*>(same.data()), same.size());
+    ASSERT(radio.set_channel(make_channel(14074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == writes);
+
+    // Front panel: new mode and PTT
+    const std::string changed = "MD1;TX0;";
+    radio.process_response(reinterpret_cast<const uint8_t*>(changed.data()), changed.size());
+    ASSERT(got.size() == 4 && radio.is_transmitting());
+    ASSERT(radio.set_channel(make_channel(14074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == writes + 1 && text_of(serial.writes.back()) == "MD2;");
+}
+
+TEST(test_yaesu_parser_status) {
+    pal::YaesuParser parser;
+    std::vector<pal::YaesuCommand> got;
+    parser.set_handler([&](pal::YaesuCommand read, const pal::YaesuStatus&) { got.push_back(read); });
+
+    // Only the reads expect replies, in the order they were written
+    const uint8_t written[] = {
+        0x01, 0x42, 0x50, 0x00, 0x01,
+        0x00, 0x00, 0x00, 0x00, 0x03,
+        0x00, 0x00, 0x00, 0x00, 0xE7,
+        0x00, 0x00, 0x00, 0x00, 0xF7,
+    };
+    parser.on_write(written, sizeof(written));
+    ASSERT(parser.outstanding() == 3);
+
+    const uint8_t replies[] = {0x01, 0x42, 0x50, 0x00, 0x02, 0x89, 0x65, 0x55};
+    parser.feed(replies, 2);
+    ASSERT(got.empty());
+    parser.feed(replies + 2, sizeof(replies) - 2);
+    ASSERT(got.size() == 3 && got[0] == pal::YaesuCommand::READ_FREQ);
+
+    const pal::YaesuStatus& status = parser.get_status();
+    ASSERT(status.valid == (pal::YaesuStatus::FREQUENCY | pal::YaesuStatus::RX | pal::YaesuStatus::TX));
+    ASSERT(status.frequency_hz == 14250000 && status.mode == pal::RadioMode::CW);
+    ASSERT(status.s_meter == 9 && status.squelched);
+    ASSERT(status.transmitting && status.high_swr && !status.split && status.power_meter == 5);
+    ASSERT(parser.get_stats().unexpected == 1);
+
+    // Receiving: F7 answers 0xFF
+    uint8_t receiving = 0xFF;
+    ASSERT(parser.apply(pal::YaesuCommand::READ_TX_STATUS, &receiving, 1));
+    ASSERT(!status.transmitting && !status.high_swr && status.power_meter == 0);
+
+    // Bad BCD and wrong lengths are refused
+    const uint8_t bad[] = {0x01, 0x4A, 0x50, 0x00, 0x01};
+    ASSERT(!parser.apply(pal::YaesuCommand::READ_FREQ, bad, sizeof(bad)));
+    ASSERT(!parser.apply(pal::YaesuCommand::READ_FREQ, bad, 4));
+    ASSERT(status.frequency_hz == 14250000);
+    ASSERT(pal::YaesuParser::reply_length(pal::YaesuCommand::SET_FREQ) == 0);
+}
+
+TEST(test_yaesu_read_status) {
+    RecordingSerial serial;
+    pal::YaesuCat radio(&serial);
+    ASSERT(radio.initialize());
+    int updates = 0;
+    radio.set_status_callback([&](const pal::YaesuStatus&) { updates++; });
+
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(radio.read_status());
+    ASSERT(serial.writes.size() == 5 && serial.writes[4] == (Bytes{0x00, 0x00, 0x00, 0x00, 0xF7}));
+
+    // Retuned from the front panel while we weren't looking
+    const uint8_t replies[] = {0x01, 0x40, 0x74, 0x00, 0x01, 0x05, 0x00};
+    radio.process_response(replies, sizeof(replies));
+    ASSERT(updates == 3);
+    ASSERT(radio.get_status().frequency_hz == 14074000 && radio.get_status().s_meter == 5);
+    ASSERT(radio.is_transmitting());
+
+    ASSERT(radio.set_channel(make_channel(7074000, pal::RadioMode::USB)));
+    ASSERT(serial.writes.size() == 6 && serial.writes[5][4] == 0x01);
+}
+
+TEST(test_cat_queue_pacing) {
+    ManualTimer timer;
+    RecordingSerial serial;
+    std::vector<pal::RadioCompletion> done;
+
+    pal::CatQueueConfig config;
+    config.protocol = pal::CatProtocol::YAESU;
+    config.pacing_us = pal::YAESU_PACING_US;
+    pal::CatCommandQueue queue([&](const uint8_t* d, size_t n) { serial.write(d, n); }, timer, config);
+    pal::YaesuCat radio(&serial);
+    ASSERT(radio.initialize());
+    radio.set_command_queue(&queue);
+
+    // Frequency, mode and readback go out one command at a time
+    ASSERT(radio.set_channel_async(make_channel(7074000, pal::RadioMode::USB),
+                                   [&](const pal::RadioCompletion& c) { done.push_back(c); }));
+    ASSERT(serial.writes.size() == 1 && serial.writes[0].size() == 5);
+    uint64_t first = timer.now_us;
+    queue.poll();
+    ASSERT(serial.writes.size() == 1);
+
+    while (serial.writes.size() < 3) {
+        timer.now_us = queue.next_deadline_us();
+        queue.poll();
+    }
+    ASSERT(serial.writes[2][4] == 0x03);
+    ASSERT(timer.now_us - first >= 2 * (5208 + pal::YAESU_PACING_US));
+
+    const uint8_t reply[] = {0x00, 0x70, 0x74, 0x00, 0x01};
+    queue.on_receive(reply, sizeof(reply));
+    ASSERT(done.size() == 1 && done[0].ok);
+
+    // The next request waits out the gap after the readback
+    ASSERT(radio.read_status());
+    ASSERT(serial.writes.size() == 3);
+    timer.now_us = queue.next_deadline_us();
+    queue.poll();
+    ASSERT(serial.writes.size() == 4 && serial.writes[3][4] == 0x03);
+
+    queue.cancel_all();
+
+    // A stray byte while a paced set request is part-way out doesn't complete it
+    std::vector<pal::CatCompletion> sets;
+    const uint8_t freq_mode[] = {0x00, 0x70, 0x74, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x07};
+    timer.now_us += 20000;
+    queue.submit(freq_mode, sizeof(freq_mode), [&](const pal::CatCompletion& c) { sets.push_back(c); });
+    ASSERT(serial.writes.size() == 5);
+    const uint8_t stray = 0xFF;
+    queue.on_receive(&stray, 1);
+    ASSERT(sets.empty() && queue.get_stats().unmatched == 1);
+    timer.now_us = queue.next_deadline_us();
+    queue.poll();
+    ASSERT(serial.writes.size() == 6 && serial.writes[5][4] == 0x07);
+    ASSERT(sets.size() == 1 && sets[0].result == pal::CatResult::OK);
+}
+
+int main() {
+    std::cout << "=== Radio Protocol Unit Tests ===\n\n";
+
+    RUN_TEST(test_civ_codec_frames);
+    RUN_TEST(test_icom_channel_is_one_write);
+    RUN_TEST(test_kenwood_codec_matches_printf);
+    RUN_TEST(test_kenwood_and_elecraft_writes);
+    RUN_TEST(test_shadow_sends_only_changes);
+    RUN_TEST(test_shadow_managed_fields);
+    RUN_TEST(test_scan_list_hops);
+    RUN_TEST(test_cat_queue_civ_window);
+    RUN_TEST(test_cat_queue_civ_nak_window);
+    RUN_TEST(test_cat_queue_retries);
+    RUN_TEST(test_cat_queue_kenwood_and_yaesu);
+    RUN_TEST(test_async_completes_on_ack);
+    RUN_TEST(test_async_completes_on_readback);
+    RUN_TEST(test_civ_parser_messages);
+    RUN_TEST(test_icom_follows_front_panel);
+    RUN_TEST(test_kenwood_parser_answers);
+    RUN_TEST(test_kenwood_auto_info);
+    RUN_TEST(test_yaesu_parser_status);
+    RUN_TEST(test_yaesu_read_status);
+    RUN_TEST(test_cat_queue_pacing);
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
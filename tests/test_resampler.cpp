@@ -7,9 +7,11 @@
  */
 
 #include "pal/resampler.h"
+#include "pal/fractional_resampler.h"
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -158,6 +160,87 @@ TEST(test_reset_clears_history) {
     ASSERT(max_val < 0.01f);
 }
 
+TEST(test_native_format_entry_points) {
+    // Radio on the right channel of stereo S16; the left must not leak in
+    auto tone = generate_sine(1000.0f, 48000.0f, 960);
+    pal::AudioFormat format;
+    format.format = pal::SampleFormat::S16;
+    format.channels = 2;
+    format.radio_channel = 1;
+
+    std::vector<int16_t> frames(2 * tone.size());
+    std::vector<float> mono(tone.size());
+    for (size_t i = 0; i < tone.size(); i++) {
+        frames[2 * i] = 12345;
+        frames[2 * i + 1] = pal::float_to_sample<int16_t>(tone[i]);
+        mono[i] = pal::sample_to_float(frames[2 * i + 1]);
+    }
+
+    pal::Resampler native(6);
+    pal::Resampler reference(6);
+    std::vector<float> out_native(tone.size() / 6);
+    std::vector<float> out_reference(tone.size() / 6);
+    ASSERT(native.decimate(frames.data(), format, tone.size(), out_native.data()) == 160);
+    ASSERT(reference.decimate(mono.data(), mono.size(), out_reference.data()) == 160);
+    ASSERT(out_native == out_reference);
+
+    // Interpolate into S32 stereo channel 0, leaving channel 1 alone
+    format.format = pal::SampleFormat::S32;
+    format.radio_channel = 0;
+    std::vector<int32_t> tx(2 * 960, 77);
+    ASSERT(native.interpolate(out_reference.data(), 160, tx.data(), format) == 960);
+    std::vector<float> tx_reference(960);
+    ASSERT(reference.interpolate(out_reference.data(), 160, tx_reference.data()) == 960);
+    for (size_t i = 0; i < 960; i++) {
+        ASSERT(tx[2 * i] == pal::float_to_sample<int32_t>(tx_reference[i]));
+        ASSERT(tx[2 * i + 1] == 77);
+    }
+}
+
+TEST(test_fractional_unity_is_delay) {
+    // Ratio 1.0 lands on the input samples, two samples late
+    auto tone = generate_sine(300.0f, 8000.0f, 200);
+    pal::FractionalResampler resampler;
+    std::vector<float> out(200);
+    size_t consumed = 0;
+    ASSERT(resampler.process(tone.data(), tone.size(), out.data(), out.size(), &consumed) == 200);
+    ASSERT(consumed == 200);
+    for (size_t i = 2; i < 200; i++) {
+        ASSERT(std::abs(out[i] - tone[i - 2]) < 1e-6f);
+    }
+}
+
+TEST(test_fractional_ratio_and_chunking) {
+    // 1000 ppm fast: 100000 outputs use 100100 inputs
+    auto tone = generate_sine(300.0f, 8000.0f, 101000);
+    pal::FractionalResampler whole(1.001);
+    pal::FractionalResampler chunked(1.001);
+    std::vector<float> out_whole(100000);
+    std::vector<float> out_chunked(100000);
+
+    size_t consumed = 0;
+    ASSERT(whole.process(tone.data(), tone.size(), out_whole.data(), out_whole.size(), &consumed) == 100000);
+    ASSERT(consumed >= 100099 && consumed <= 100101);
+
+    // Odd chunk sizes on both sides give the same samples
+    size_t in = 0, out = 0;
+    while (out < out_chunked.size()) {
+        size_t used = 0;
+        size_t out_n = std::min<size_t>(37, out_chunked.size() - out);
+        out += chunked.process(tone.data() + in, std::min<size_t>(53, tone.size() - in),
+                               out_chunked.data() + out, out_n, &used);
+        in += used;
+    }
+    ASSERT(in == consumed);
+    ASSERT(out_whole == out_chunked);
+
+    // Interpolated output stays a clean tone: no step larger than the slope allows
+    float max_step = 2.0f * 3.14159265f * 300.0f / 8000.0f;
+    for (size_t i = 3; i < out_whole.size(); i++) {
+        ASSERT(std::abs(out_whole[i] - out_whole[i - 1]) < max_step * 1.05f);
+    }
+}
+
 int main() {
     std::cout << "=== Resampler Unit Tests ===\n\n";
     
@@ -166,6 +249,9 @@ int main() {
     RUN_TEST(test_decimate_rejects_alias);
     RUN_TEST(test_roundtrip);
     RUN_TEST(test_reset_clears_history);
+    RUN_TEST(test_native_format_entry_points);
+    RUN_TEST(test_fractional_unity_is_delay);
+    RUN_TEST(test_fractional_ratio_and_chunking);
     
     std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
     
@@ -0,0 +1,177 @@
+/**
+ * @file test_rt_thread.cpp
+ * @brief Unit tests for RtThreadPolicy / apply_rt_policy
+ *
+ * Scheduling classes need privileges the test machine may not have, so
+ * these check that whatever is reported matches what the thread really
+ * has, and only require the parts any process may do (pinning, prefault).
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/rt_thread.h"
+#include "pal/audio/loopback_audio_driver.h"
+#include "pal/audio/monitored_audio_driver.h"
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+
+// Run f on a fresh thread so policies don't leak into the test process
+template <typename F>
+static pal::RtThreadStatus on_thread(F f) {
+    pal::RtThreadStatus status;
+    std::thread thread([&] { status = f(); });
+    thread.join();
+    return status;
+}
+
+// First CPU this process may use
+static int first_allowed_cpu() {
+#if defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) return cpu;
+        }
+    }
+#endif
+    return 0;
+}
+
+TEST(test_default_policy_changes_nothing) {
+    pal::RtThreadPolicy policy;
+    ASSERT(policy.is_default());
+
+    pal::RtThreadStatus status = on_thread([&] { return pal::apply_rt_policy(policy); });
+    ASSERT(status.applied);
+    ASSERT(status.sched_granted);
+    ASSERT(!status.affinity_granted && !status.memory_locked);
+    ASSERT(status.satisfies(policy));
+    ASSERT(pal::RtThreadStatus().describe() == "not applied");
+}
+
+TEST(test_fifo_reports_what_was_granted) {
+    pal::RtThreadPolicy policy = pal::RtThreadPolicy::fifo(10);
+    pal::RtThreadStatus status = on_thread([&] { return pal::apply_rt_policy(policy); });
+    ASSERT(status.applied);
+
+    // Granted or refused, the report must agree with itself
+    if (status.sched_granted) {
+        ASSERT(status.sched == pal::RtSchedClass::FIFO && status.priority == 10);
+        ASSERT(status.describe().find("FIFO/10") == 0);
+        ASSERT(status.satisfies(policy));
+    } else {
+        ASSERT(status.describe().find("(refused)") != std::string::npos);
+        ASSERT(!status.satisfies(policy));
+    }
+}
+
+#if defined(__linux__)
+TEST(test_pin_and_prefault) {
+    pal::RtThreadPolicy policy;
+    policy.cpus.push_back(first_allowed_cpu());
+    policy.prefault_stack_bytes = 64 * 1024;
+    policy.prefault_heap_bytes = 256 * 1024;
+
+    int ran_on = -1;
+    pal::RtThreadStatus status = on_thread([&] {
+        pal::RtThreadStatus s = pal::apply_rt_policy(policy);
+        ran_on = sched_getcpu();
+        return s;
+    });
+    ASSERT(status.affinity_granted);
+    ASSERT(status.cpu_count == 1);
+    ASSERT(ran_on == policy.cpus[0]);
+    ASSERT(status.stack_prefaulted >= policy.prefault_stack_bytes);
+    ASSERT(status.heap_prefaulted == policy.prefault_heap_bytes);
+    ASSERT(status.satisfies(policy));
+    ASSERT(status.describe().find("cpus=1 pinned") != std::string::npos);
+}
+
+TEST(test_stack_prefault_fits_small_stack) {
+    // Asking for more than the thread has must not run off its stack
+    pal::RtThreadPolicy policy;
+    policy.prefault_stack_bytes = 8 * 1024 * 1024;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    pal::RtThreadStatus status;
+    pthread_t thread;
+    auto body = [](void* arg) -> void* {
+        pal::RtThreadPolicy small;
+        small.prefault_stack_bytes = 8 * 1024 * 1024;
+        *static_cast<pal::RtThreadStatus*>(arg) = pal::apply_rt_policy(small);
+        return nullptr;
+    };
+    ASSERT(pthread_create(&thread, &attr, body, &status) == 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    ASSERT(status.applied);
+    ASSERT(status.stack_prefaulted > 0);
+    ASSERT(status.stack_prefaulted < 256 * 1024);
+    ASSERT(!status.satisfies(policy));
+}
+
+TEST(test_driver_threads_apply_policy) {
+    // Policy set on a decorator reaches the driver thread underneath
+    pal::LoopbackConfig config;
+    config.max_callbacks = 10;
+    pal::MonitoredAudioDriver driver(
+        std::unique_ptr<pal::IAudioDriver>(new pal::LoopbackAudioDriver(config)));
+    ASSERT(driver.initialize("", 8000, 80));
+    ASSERT(!driver.get_rt_status().applied);
+
+    pal::RtThreadPolicy policy;
+    policy.cpus.push_back(first_allowed_cpu());
+    driver.set_rt_policy(policy);
+    ASSERT(driver.get_inner().get_rt_policy().cpus == policy.cpus);
+
+    driver.set_audio_callback([](const float*, float*, size_t) {});
+    ASSERT(driver.start());
+    static_cast<pal::LoopbackAudioDriver&>(driver.get_inner()).wait();
+    driver.stop();
+
+    pal::RtThreadStatus status = driver.get_rt_status();
+    ASSERT(status.applied && status.affinity_granted && status.cpu_count == 1);
+}
+#endif
+
+int main() {
+    std::cout << "=== RT Thread Unit Tests ===\n\n";
+
+    RUN_TEST(test_default_policy_changes_nothing);
+    RUN_TEST(test_fifo_reports_what_was_granted);
+#if defined(__linux__)
+    RUN_TEST(test_pin_and_prefault);
+    RUN_TEST(test_stack_prefault_fits_small_stack);
+    RUN_TEST(test_driver_threads_apply_policy);
+#endif
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file test_tx_scheduler.cpp
+ * @brief Unit tests for TxScheduler
+ *
+ * @author Alex Pennington, AAM402/KY4OLB
+ * @date December 2024
+ */
+
+#include "pal/tx_scheduler.h"
+#include "pal/events.h"
+#include "pal/audio/loopback_audio_driver.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+// Simple test framework
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "... "; \
+    tests_run++; \
+    try { name(); tests_passed++; std::cout << "PASSED\n"; } \
+    catch (const std::exception& e) { std::cout << "FAILED: " << e.what() << "\n"; } \
+} while(0)
+
+#define ASSERT(cond) if (!(cond)) throw std::runtime_error("Assertion failed: " #cond)
+
+// Event handler that records emitted events
+class RecordingEventHandler : public pal::IEventHandler {
+public:
+    void on(pal::EventType, pal::EventCallback) override {}
+    void on_any(pal::EventCallback) override {}
+    void emit(const pal::Event& event) override { events.push_back(event); }
+    void emit(pal::EventType type, const std::string& message) override {
+        pal::Event event{};
+        event.type = type;
+        event.message = message;
+        events.push_back(event);
+    }
+
+    std::vector<pal::Event> events;
+};
+
+// Burst whose samples are 1, 2, 3, ... so positions are easy to check
+static std::unique_ptr<pal::TxBurst> make_burst(uint64_t start, size_t length, uint32_t id = 0) {
+    std::unique_ptr<pal::TxBurst> burst(new pal::TxBurst);
+    burst->start_index = start;
+    burst->id = id;
+    for (size_t i = 0; i < length; i++) burst->samples.push_back(static_cast<float>(i + 1));
+    return burst;
+}
+
+// Render [0, total) in blocks and return the concatenated output
+static std::vector<float> render_all(pal::TxScheduler& tx, size_t total, size_t block) {
+    std::vector<float> out(total, -1.0f);
+    for (size_t pos = 0; pos < total; pos += block) {
+        tx.render(pos, out.data() + pos, std::min(block, total - pos));
+    }
+    return out;
+}
+
+TEST(test_idle_renders_silence) {
+    pal::TxScheduler tx;
+    std::vector<float> out = render_all(tx, 256, 64);
+    ASSERT(std::all_of(out.begin(), out.end(), [](float s) { return s == 0.0f; }));
+    ASSERT(tx.get_queued_frames() == 0);
+}
+
+TEST(test_burst_starts_on_exact_index) {
+    pal::TxScheduler tx;
+    ASSERT(tx.submit(make_burst(100, 50)));
+    ASSERT(tx.get_queued_frames() == 50);
+
+    std::vector<float> out = render_all(tx, 256, 64);
+    for (size_t i = 0; i < 256; i++) {
+        float expected = (i >= 100 && i < 150) ? static_cast<float>(i - 99) : 0.0f;
+        ASSERT(out[i] == expected);
+    }
+    ASSERT(tx.get_bursts_played() == 1);
+    ASSERT(tx.get_queued_frames() == 0);
+    ASSERT(tx.get_late_bursts() == 0);
+}
+
+TEST(test_back_to_back_bursts_are_gapless) {
+    pal::TxScheduler tx;
+    ASSERT(tx.submit(make_burst(10, 100, 1)));
+    ASSERT(tx.submit(make_burst(110, 100, 2)));
+
+    std::vector<float> out = render_all(tx, 320, 48);
+    for (size_t i = 10; i < 210; i++) {
+        ASSERT(out[i] == static_cast<float>((i - 10) % 100 + 1));
+    }
+    ASSERT(out[9] == 0.0f && out[210] == 0.0f);
+
+    // Played bursts come back in order for reuse
+    auto first = tx.reclaim();
+    auto second = tx.reclaim();
+    ASSERT(first && first->id == 1);
+    ASSERT(second && second->id == 2);
+    ASSERT(!tx.reclaim());
+}
+
+TEST(test_asap_and_late_policies) {
+    // TX_START_ASAP plays immediately without counting as late
+    pal::TxScheduler asap;
+    std::vector<float> out(64);
+    asap.render(0, out.data(), 64);
+    ASSERT(asap.submit(make_burst(pal::TX_START_ASAP, 10)));
+    asap.render(64, out.data(), 64);
+    ASSERT(out[0] == 1.0f && out[9] == 10.0f && out[10] == 0.0f);
+    ASSERT(asap.get_late_bursts() == 0);
+
+    // SHIFT: a burst due at 20 submitted at 64 plays whole, now
+    pal::TxScheduler shift;
+    shift.render(0, out.data(), 64);
+    ASSERT(shift.submit(make_burst(20, 10)));
+    shift.render(64, out.data(), 64);
+    ASSERT(out[0] == 1.0f && out[9] == 10.0f);
+    ASSERT(shift.get_late_bursts() == 1);
+
+    // TRUNCATE: same burst keeps its timing, the first 44 samples are gone
+    pal::TxSchedulerConfig config;
+    config.late_policy = pal::TxLatePolicy::TRUNCATE;
+    pal::TxScheduler truncate(config);
+    truncate.render(0, out.data(), 64);
+    ASSERT(truncate.submit(make_burst(20, 50)));
+    truncate.render(64, out.data(), 64);
+    ASSERT(out[0] == 45.0f && out[5] == 50.0f && out[6] == 0.0f);
+    ASSERT(truncate.get_late_bursts() == 1);
+    ASSERT(truncate.get_queued_frames() == 0);
+
+    // Index 0 is a real start: late like any other
+    pal::TxScheduler at_zero(config);
+    at_zero.render(0, out.data(), 64);
+    ASSERT(at_zero.submit(make_burst(0, 80)));
+    at_zero.render(64, out.data(), 64);
+    ASSERT(out[0] == 65.0f && out[15] == 80.0f && out[16] == 0.0f);
+    ASSERT(at_zero.get_late_bursts() == 1);
+}
+
+TEST(test_abort_and_capacity) {
+    pal::TxSchedulerConfig config;
+    config.max_bursts = 2;
+    pal::TxScheduler tx(config);
+
+    ASSERT(tx.submit(make_burst(0, 500)));
+    ASSERT(tx.submit(make_burst(1000, 500)));
+    ASSERT(!tx.submit(make_burst(2000, 500)));  // Full until reclaimed
+
+    std::vector<float> out(64);
+    tx.render(0, out.data(), 64);
+    ASSERT(out[0] == 1.0f);
+
+    tx.abort();
+    tx.render(64, out.data(), 64);
+    ASSERT(std::all_of(out.begin(), out.end(), [](float s) { return s == 0.0f; }));
+    ASSERT(tx.get_queued_frames() == 0);
+
+    ASSERT(tx.reclaim() && tx.reclaim());
+    ASSERT(tx.submit(make_burst(0, 10)));
+}
+
+TEST(test_drain_event_once_per_transmission) {
+    pal::TxSchedulerConfig config;
+    config.drain_warning_frames = 100;
+    pal::TxScheduler tx(config);
+    RecordingEventHandler events;
+
+    ASSERT(tx.submit(make_burst(0, 300)));
+    std::vector<float> out(64);
+    uint64_t index = 0;
+    for (int i = 0; i < 3; i++, index += 64) tx.render(index, out.data(), 64);
+    tx.emit_events(events);
+    ASSERT(events.events.empty());              // 108 frames still queued
+
+    for (int i = 0; i < 4; i++, index += 64) {
+        tx.render(index, out.data(), 64);
+        tx.emit_events(events);
+    }
+    ASSERT(events.events.size() == 1);
+    ASSERT(events.events[0].type == pal::EventType::AUDIO_TX_DRAINING);
+    ASSERT(events.events[0].code == 44);
+
+    // Idle re-arms: the next transmission warns again
+    ASSERT(tx.submit(make_burst(pal::TX_START_ASAP, 80)));
+    tx.render(index, out.data(), 64);
+    tx.emit_events(events);
+    ASSERT(events.events.size() == 2);
+}
+
+TEST(test_attach_plays_on_driver_timeline) {
+    // Loopback returns TX frame k at RX frame k
+    pal::LoopbackAudioDriver driver;
+    ASSERT(driver.initialize("", 8000, 80));
+
+    pal::TxScheduler tx;
+    ASSERT(tx.submit(make_burst(1000, 200)));
+
+    std::vector<float> rx_log;
+    tx.attach(driver, [&](const pal::AudioBlockInfo&, const float* rx, float*, size_t n) {
+        rx_log.insert(rx_log.end(), rx, rx + n);
+    });
+    driver.run(20);
+
+    ASSERT(rx_log.size() == 1600);
+    ASSERT(rx_log[999] == 0.0f);
+    ASSERT(rx_log[1000] == 1.0f);
+    ASSERT(rx_log[1199] == 200.0f);
+    ASSERT(rx_log[1200] == 0.0f);
+}
+
+int main() {
+    std::cout << "=== TX Scheduler Unit Tests ===\n\n";
+
+    RUN_TEST(test_idle_renders_silence);
+    RUN_TEST(test_burst_starts_on_exact_index);
+    RUN_TEST(test_back_to_back_bursts_are_gapless);
+    RUN_TEST(test_asap_and_late_policies);
+    RUN_TEST(test_abort_and_capacity);
+    RUN_TEST(test_drain_event_once_per_transmission);
+    RUN_TEST(test_attach_plays_on_driver_timeline);
+
+    std::cout << "\n=== Results: " << tests_passed << "/" << tests_run << " passed ===\n";
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}